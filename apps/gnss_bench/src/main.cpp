@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Runs the tracker's fix processing on native_sim against a GNSS log replayed into the PTY
+ * UART by tools/gnss_replay. Each fix goes through the tracker's GNSS receiver and is encoded
+ * into the frame the tracker would send, timed on its own. The start of each UTC second is
+ * driven onto the emulated PPS pin so the TDMA clock locks as it does on a tracker.
+ *
+ * Every fix prints one line, which depends only on the log and so can be diffed across runs:
+ *   #FIX <utc hh:mm:ss.mmm> <fix status> <frame hex>
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gnss.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/logging/log.h>
+
+#ifdef CONFIG_GPIO_EMUL
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#endif
+
+#include <core/Coordinates.h>
+#include <core/FrameCodec.h>
+#include <core/GnssReceiver.h>
+#include <core/TdmaClock.h>
+#include <core/TimestampService.h>
+#include <core/defs.h>
+
+LOG_MODULE_REGISTER(main);
+
+namespace {
+constexpr uint8_t NODE_ID = 1;
+
+const gpio_dt_spec pps = GPIO_DT_SPEC_GET(DT_ALIAS(pps), gpios);
+
+GnssReceiver receiver;
+TxFrameEncoder encoder;
+uint8_t sequence{0};
+uint32_t lastSecond{UINT32_MAX};
+
+// Written by the GNSS driver's thread, read by main for the reports
+struct {
+    uint32_t fixes;
+    uint32_t noFixes;
+    uint32_t ppsEdges;
+    uint64_t cyclesTotal;
+    uint32_t cyclesMax;
+} stats;
+
+// The UTC second a fix belongs to, from its date and time
+uint32_t utcSecond(const gnss_time& utc) {
+    return ((utc.month_day * 24U + utc.hour) * 60U + utc.minute) * 60U + utc.millisecond / 1000U;
+}
+
+void pulsePps() {
+#ifdef CONFIG_GPIO_EMUL
+    // The edge interrupt runs in here, capturing the timebase as the PPS ISR does on a tracker
+    gpio_emul_input_set(pps.port, pps.pin, 1);
+    gpio_emul_input_set(pps.port, pps.pin, 0);
+    stats.ppsEdges++;
+#endif
+}
+
+void printFix(const gnss_data& data, const uint8_t* frame, const size_t size) {
+    static constexpr char digits[] = "0123456789abcdef";
+    char hex[2 * TxFrameEncoder::frameSize<LoraFrame> + 1];
+    for (size_t i = 0; i < size; i++) {
+        hex[2 * i] = digits[frame[i] >> 4];
+        hex[2 * i + 1] = digits[frame[i] & 0x0F];
+    }
+    hex[2 * size] = '\0';
+
+    printk("#FIX %02u:%02u:%02u.%03u %u %s\n", data.utc.hour, data.utc.minute, data.utc.millisecond / 1000U,
+           data.utc.millisecond % 1000U, data.info.fix_status, hex);
+}
+
+void onGnssData(const device* dev, const gnss_data* data) {
+    if (!data) {
+        return;
+    }
+
+    // PPS leads the sentences of its second, so it goes before the fix is processed
+    const uint32_t second = utcSecond(data->utc);
+    if (second != lastSecond) {
+        lastSecond = second;
+        pulsePps();
+    }
+
+    uint8_t frame[TxFrameEncoder::frameSize<LoraFrame>];
+    const uint32_t start = k_cycle_get_32();
+
+    gnssCallback(dev, data);
+    size_t size = 0;
+    if (receiver.isFixAcquired()) {
+        // As LoraTransceiver::toGnssInfo, which needs a radio to link
+        GnssInfo fix{};
+        fix.latitude = nanoToMilliDeg(data->nav_data.latitude);
+        fix.longitude = nanoToMilliDeg(data->nav_data.longitude);
+        fix.satellites_cnt = static_cast<uint8_t>(data->info.satellites_cnt);
+        fix.fix_status = data->info.fix_status;
+        size = encoder.encodeFix(frame, NODE_ID, sequence++, fix);
+        stats.fixes++;
+    } else {
+        size = encoder.encodeNoFix(frame, NODE_ID, sequence++);
+        stats.noFixes++;
+    }
+
+    const uint32_t cycles = k_cycle_get_32() - start;
+    stats.cyclesTotal += cycles;
+    stats.cyclesMax = MAX(stats.cyclesMax, cycles);
+
+    printFix(*data, frame, size);
+}
+
+const char* sourceName(const TdmaClock::Source source) {
+    switch (source) {
+    case TdmaClock::Source::GPS_PPS: return "GPS PPS";
+    case TdmaClock::Source::HUNTER: return "hunter";
+    default: return "free running";
+    }
+}
+}
+
+GNSS_DATA_CALLBACK_DEFINE(DEVICE_DT_GET(DT_ALIAS(gnss)), onGnssData);
+
+int main() {
+    const device* timer = DEVICE_DT_GET(DT_ALIAS(tdma_timer));
+    TimestampService& timestamps = TimestampService::instance();
+    timestamps.init(timer);
+    timestamps.attachPps(&pps);
+    TdmaClock::instance().init(timestamps);
+    setGnssReciever(&receiver);
+
+    LOG_INF("Waiting for NMEA on the GNSS UART, see tools/gnss_replay");
+
+    uint32_t lastProcessed = 0;
+    while (true) {
+        k_sleep(K_SECONDS(CONFIG_GNSS_BENCH_REPORT_S));
+
+        const uint32_t processed = stats.fixes + stats.noFixes;
+        const uint64_t averageNs = processed == 0 ? 0 : k_cyc_to_ns_floor64(stats.cyclesTotal / processed);
+        const TdmaClock& clock = TdmaClock::instance();
+        LOG_INF("%u fixes, %u without a fix, %u per second", stats.fixes, stats.noFixes,
+                (processed - lastProcessed) / CONFIG_GNSS_BENCH_REPORT_S);
+        LOG_INF("Processing: %u ns average, %u ns max", static_cast<uint32_t>(averageNs),
+                static_cast<uint32_t>(k_cyc_to_ns_floor64(stats.cyclesMax)));
+        LOG_INF("TDMA clock: %s after %u PPS edges, frame %u, drift %d ppb", sourceName(clock.source()),
+                stats.ppsEdges, clock.frameNumber(), clock.driftPpb());
+        lastProcessed = processed;
+    }
+
+    return 0;
+}
@@ -7,24 +7,126 @@
 #include <zephyr/device.h>
 #include <zephyr/logging/log.h>
 #include <zephyr/logging/log_ctrl.h>
+#include <cstdlib>
 
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "core/AgeOfInformation.h"
+#include "core/Coordinates.h"
+#include "core/ChannelPlan.h"
+#include "core/DiscoveryScan.h"
+#include "core/Downlink.h"
+#include "core/HopMaster.h"
 #include "core/LoraTransceiver.h"
+#include "core/PositionPredictor.h"
 #include "core/Settings.h"
+#include "core/SfScanner.h"
 
 
 LOG_MODULE_REGISTER(main);
 
+#ifdef CONFIG_POSITION_PREDICTOR
+static PositionPredictor predictor;
+
+#ifdef CONFIG_SHELL
+static void printPrediction(const struct shell *sh, const uint8_t nodeId) {
+    PositionPredictor::Prediction prediction{};
+    if (!predictor.predict(nodeId, k_uptime_get_32(), prediction)) {
+        return;
+    }
+
+    char latitude[FIXED_POINT_TEXT_SIZE];
+    char longitude[FIXED_POINT_TEXT_SIZE];
+    formatFixedPoint(latitude, prediction.position.latitude, 3, 6);
+    formatFixedPoint(longitude, prediction.position.longitude, 3, 6);
+    shell_print(sh, "Node %u: %s, %s +/- %u m, %d/%d cm/s N/E, last fix %u ms ago", nodeId, latitude, longitude,
+                prediction.uncertaintyM, prediction.northCmPerS, prediction.eastCmPerS, prediction.ageMs);
+}
+
+static int cmd_predict(const struct shell *sh, size_t argc, char **argv) {
+    if (argc > 1) {
+        char *end;
+        const unsigned long nodeId = strtoul(argv[1], &end, 10);
+        if (*end != '\0' || nodeId > MAX_NODE_ID) {
+            shell_error(sh, "Invalid node '%s' (expected 0-%u)", argv[1], MAX_NODE_ID);
+            return -EINVAL;
+        }
+        printPrediction(sh, static_cast<uint8_t>(nodeId));
+        return 0;
+    }
+
+    for (uint8_t nodeId = 0; nodeId <= MAX_NODE_ID; nodeId++) {
+        printPrediction(sh, nodeId);
+    }
+    return 0;
+}
+
+SHELL_CMD_ARG_REGISTER(predict, NULL, "Predicted position of trackers now [node]", cmd_predict, 1, 1);
+#endif
+#endif
+
 int main(void) {
     // Settings::load();
-    // float freqMHz = static_cast<float>(OutlawSettings::getFrequency()) / 1'000'000;
+    // const uint32_t freqHz = Settings::get(Settings::Id::FREQUENCY);
 #ifdef CONFIG_LICENSED_FREQUENCY
-    float freqMhz = 435.0f;
+    const uint32_t freqHz = 435'000'000;
 #else
-    float freqMhz = 903.0f;
+    const uint32_t freqHz = 903'000'000;
+#endif
+    LoraTransceiver lora(0, freqHz);
+
+#if defined(CONFIG_FREQUENCY_HOPPING) || (defined(CONFIG_DOWNLINK) && defined(CONFIG_LICENSED_FREQUENCY))
+    Settings::load();
 #endif
-    LoraTransceiver lora(0, freqMhz);
+
+#ifdef CONFIG_DOWNLINK
+#ifdef CONFIG_LICENSED_FREQUENCY
+    // Commands are transmitted, so the hunter needs a callsign of its own
+    static char callsign[Settings::CALLSIGN_LEN + 1] = {};
+    Settings::getBytes(Settings::Id::CALLSIGN, callsign, Settings::CALLSIGN_LEN);
+    lora.setCallsign(callsign);
+#endif
+    static DownlinkScheduler downlink(lora);
+    lora.setDownlink(&downlink);
+#endif
+
+#ifdef CONFIG_POSITION_PREDICTOR
+    lora.setPositionPredictor(&predictor);
+#endif
+
+#ifdef CONFIG_FIX_AGE
+    static AgeOfInformation ageOfInformation;
+    lora.setAgeOfInformation(&ageOfInformation);
+#endif
+
     lora.awaitRxPacket();
 
+#ifdef CONFIG_SF_SCAN
+    static SfScanner scanner(lora);
+    lora.setSfScanner(&scanner);
+    scanner.start();
+#endif
+
+#ifdef CONFIG_DISCOVERY_SCAN
+    // Look for trackers away from the configured frequency before settling down
+    static DiscoveryScan discovery(lora);
+    lora.setDiscovery(&discovery);
+    discovery.start();
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+    // The hunter keeps the frames, trackers follow its beacons
+    static HopMaster hopMaster(lora, ChannelPlan::fromSettings());
+    hopMaster.start();
+#endif
+
+#ifdef CONFIG_DOWNLINK_CONSOLE
+    // Without the shell, main reads commands from the console instead
+    downlink.runConsole();
+#endif
+
     while (true) {
         k_sleep(K_FOREVER);
     }
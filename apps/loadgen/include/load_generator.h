@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "core/FrameCodec.h"
+#include "core/LoraTransceiver.h"
+#include "core/defs.h"
+
+/**
+ * Sends the traffic of a fleet of trackers from one radio, to load a hunter on the bench.
+ * Each virtual tracker has its own node ID, sequence numbers and a track moving back and
+ * forth across a small area. Frames go out round robin at a fixed rate, as single fixes,
+ * NOFIX, fix batches or deliberately malformed frames in the configured mix, and every
+ * frame is counted so the totals can be compared with what the hunter received.
+ */
+class LoadGenerator {
+public:
+    struct Profile {
+        uint8_t nodes;              // Virtual trackers, node IDs 0 to nodes - 1
+        uint32_t intervalMs;        // Between frames from the whole fleet
+        uint8_t noFixPercent;
+        uint8_t batchPercent;
+        uint8_t batchFixes;         // Fixes per batch, which sets the batch frame size
+        uint8_t malformedPercent;
+    };
+
+    struct Counters {
+        uint32_t sent;
+        uint32_t fixes;
+        uint32_t noFixes;
+        uint32_t batches;
+        uint32_t truncated;         // Fix batches cut short, malformed to the hunter
+        uint32_t oversized;         // Fix frames with a byte too many, unknown to the hunter
+        uint32_t busy;              // Frames skipped because the last was still on air
+        uint32_t failed;            // Frames the radio refused
+        uint32_t perNode[MAX_NODE_ID + 1];
+        uint64_t airtimeUs;
+    };
+
+    /**
+     * @param lora Transceiver to send with, set up for transmitting
+     */
+    explicit LoadGenerator(LoraTransceiver& lora);
+
+#ifdef CONFIG_LICENSED_FREQUENCY
+    /**
+     * Set the callsign every virtual tracker sends with
+     */
+    void setCallsign(const char* callsign);
+#endif
+
+    /**
+     * Start sending with the current profile, from fresh counters
+     * @param frames Frames to send before stopping, 0 to send until stopped
+     * @return Whether it started, false while running
+     */
+    bool start(uint32_t frames);
+
+    void stop();
+
+    bool running() const { return active; }
+
+    Profile& profile() { return loadProfile; }
+
+    const Counters& counters() const { return stats; }
+
+    /**
+     * Log what was sent so far
+     */
+    void report() const;
+
+    void handleSendWork();
+    void handleTxDone();
+
+    /**
+     * Generator driven by the loadgen shell command
+     */
+    static LoadGenerator* instance() { return shellInstance; }
+
+private:
+    enum class Kind : uint8_t {
+        FIX,
+        NO_FIX,
+        BATCH,
+        TRUNCATED,
+        OVERSIZED,
+    };
+
+    struct Tracker {
+        GnssInfo history[FIX_BATCH_MAX_FIXES];  // Newest first
+        int8_t latitudeStep;
+        int8_t longitudeStep;
+        uint8_t seq;
+        uint16_t sampleIndex;
+    };
+
+    struct SendWork {
+        k_work_delayable work;
+        LoadGenerator* owner;
+    };
+
+    static LoadGenerator* shellInstance;
+
+    static void sendWorkHandler(k_work* work);
+
+    uint32_t random();
+    Kind pickKind();
+
+    /**
+     * Move a tracker one step along its track
+     */
+    void advance(Tracker& tracker);
+
+    /**
+     * Encode the next frame of a tracker
+     * @return Size of the frame
+     */
+    size_t encode(uint8_t nodeId, Kind kind, uint8_t* out);
+
+    void count(uint8_t nodeId, Kind kind, size_t size);
+
+    LoraTransceiver& lora;
+    TxFrameEncoder encoder;
+    Profile loadProfile;
+    Counters stats{};
+    Tracker trackers[MAX_NODE_ID + 1]{};
+    SendWork sendWork{};
+    uint32_t randomState{1};
+    uint32_t remaining{0};
+    uint8_t nextNode{0};
+    int64_t nextSendMs{0};
+    int64_t lastReportMs{0};
+    bool active{false};
+    bool onAir{false};
+};
@@ -0,0 +1,352 @@
+#include "load_generator.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <zephyr/logging/log.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(load_generator);
+
+namespace {
+// Tracks stay within this many millidegrees of the start, about 5 km
+constexpr int32_t AREA_MILLIDEG = 50;
+constexpr int32_t START_LATITUDE = 43'084;
+constexpr int32_t START_LONGITUDE = -77'680;
+constexpr uint8_t BATCH_INTERVAL_DS = 10;
+// Truncated batches need a delta to cut
+constexpr size_t MALFORMED_BATCH_FIXES = 2;
+constexpr size_t MAX_FRAME_SIZE = TxFrameEncoder::frameSize<FixBatchFrame> + (FIX_BATCH_MAX_FIXES - 1) * FIX_DELTA_SIZE;
+
+void txDoneCallback(void* userData) {
+    static_cast<LoadGenerator*>(userData)->handleTxDone();
+}
+}
+
+LoadGenerator* LoadGenerator::shellInstance = nullptr;
+
+LoadGenerator::LoadGenerator(LoraTransceiver& lora) : lora(lora), loadProfile{
+    .nodes = CONFIG_LOADGEN_NODES,
+    .intervalMs = CONFIG_LOADGEN_INTERVAL_MS,
+    .noFixPercent = CONFIG_LOADGEN_NOFIX_PERCENT,
+    .batchPercent = CONFIG_LOADGEN_BATCH_PERCENT,
+    .batchFixes = CONFIG_LOADGEN_BATCH_FIXES,
+    .malformedPercent = CONFIG_LOADGEN_MALFORMED_PERCENT,
+} {
+    sendWork.owner = this;
+    k_work_init_delayable(&sendWork.work, sendWorkHandler);
+    shellInstance = this;
+}
+
+#ifdef CONFIG_LICENSED_FREQUENCY
+void LoadGenerator::setCallsign(const char* callsign) {
+    encoder.setCallsign(callsign);
+    lora.setCallsign(callsign);
+}
+#endif
+
+bool LoadGenerator::start(const uint32_t frames) {
+    if (active) {
+        return false;
+    }
+
+    // The same seed sends the same frames, so runs can be repeated
+    randomState = CONFIG_LOADGEN_SEED != 0 ? CONFIG_LOADGEN_SEED : 1;
+    stats = {};
+    for (Tracker& tracker : trackers) {
+        tracker = {};
+        const auto latitude = START_LATITUDE + static_cast<int32_t>(random() % (2 * AREA_MILLIDEG + 1)) - AREA_MILLIDEG;
+        const auto longitude = START_LONGITUDE + static_cast<int32_t>(random() % (2 * AREA_MILLIDEG + 1)) - AREA_MILLIDEG;
+        for (GnssInfo& fix : tracker.history) {
+            fix = {latitude, longitude, 8, 1};
+        }
+        // Up to 3 millideg per frame each way, never standing still
+        tracker.latitudeStep = static_cast<int8_t>(1 + random() % 3);
+        tracker.longitudeStep = static_cast<int8_t>(1 + random() % 3);
+    }
+
+    LOG_INF("Sending %u frames as %u trackers, one every %u ms", frames, loadProfile.nodes, loadProfile.intervalMs);
+    remaining = frames;
+    nextNode = 0;
+    onAir = false;
+    active = true;
+    lora.setTxDoneHandler(txDoneCallback, this);
+    lora.setTx();
+    nextSendMs = k_uptime_get();
+    lastReportMs = nextSendMs;
+    k_work_schedule(&sendWork.work, K_NO_WAIT);
+    return true;
+}
+
+void LoadGenerator::stop() {
+    if (!active) {
+        return;
+    }
+
+    active = false;
+    k_work_cancel_delayable(&sendWork.work);
+    report();
+}
+
+void LoadGenerator::sendWorkHandler(k_work* work) {
+    auto* delayable = k_work_delayable_from_work(work);
+    CONTAINER_OF(delayable, SendWork, work)->owner->handleSendWork();
+}
+
+void LoadGenerator::handleSendWork() {
+    if (!active) {
+        return;
+    }
+
+    // Paced against the start so the time spent sending does not add up
+    nextSendMs += loadProfile.intervalMs;
+    k_work_schedule(&sendWork.work, K_TIMEOUT_ABS_MS(nextSendMs));
+
+    const uint8_t nodeId = nextNode;
+    nextNode = static_cast<uint8_t>((nextNode + 1) % loadProfile.nodes);
+
+    if (onAir) {
+        // Faster than the airtime allows, the frame is dropped rather than queued
+        stats.busy++;
+    } else {
+        const Kind kind = pickKind();
+        uint8_t frame[MAX_FRAME_SIZE];
+        const size_t size = encode(nodeId, kind, frame);
+        onAir = lora.txFrame(frame, size);
+        if (!onAir) {
+            stats.failed++;
+        } else {
+            count(nodeId, kind, size);
+            if (remaining > 0 && --remaining == 0) {
+                stop();
+                return;
+            }
+        }
+    }
+
+    if (CONFIG_LOADGEN_REPORT_S > 0 && k_uptime_get() - lastReportMs >= CONFIG_LOADGEN_REPORT_S * 1000LL) {
+        lastReportMs = k_uptime_get();
+        report();
+    }
+}
+
+void LoadGenerator::handleTxDone() {
+    onAir = false;
+}
+
+uint32_t LoadGenerator::random() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+LoadGenerator::Kind LoadGenerator::pickKind() {
+    uint32_t roll = random() % 100;
+    if (roll < loadProfile.malformedPercent) {
+        return roll % 2 == 0 ? Kind::TRUNCATED : Kind::OVERSIZED;
+    }
+    roll -= loadProfile.malformedPercent;
+    if (roll < loadProfile.batchPercent) {
+        return Kind::BATCH;
+    }
+    roll -= loadProfile.batchPercent;
+    return roll < loadProfile.noFixPercent ? Kind::NO_FIX : Kind::FIX;
+}
+
+void LoadGenerator::advance(Tracker& tracker) {
+    GnssInfo fix = tracker.history[0];
+    if (abs(fix.latitude + tracker.latitudeStep - START_LATITUDE) > AREA_MILLIDEG) {
+        tracker.latitudeStep = static_cast<int8_t>(-tracker.latitudeStep);
+    }
+    if (abs(fix.longitude + tracker.longitudeStep - START_LONGITUDE) > AREA_MILLIDEG) {
+        tracker.longitudeStep = static_cast<int8_t>(-tracker.longitudeStep);
+    }
+    fix.latitude += tracker.latitudeStep;
+    fix.longitude += tracker.longitudeStep;
+
+    memmove(&tracker.history[1], &tracker.history[0], (FIX_BATCH_MAX_FIXES - 1) * sizeof(GnssInfo));
+    tracker.history[0] = fix;
+    tracker.sampleIndex++;
+}
+
+size_t LoadGenerator::encode(const uint8_t nodeId, const Kind kind, uint8_t* out) {
+    Tracker& tracker = trackers[nodeId];
+    advance(tracker);
+    const uint8_t seq = tracker.seq++;
+
+    switch (kind) {
+    case Kind::NO_FIX:
+        return encoder.encodeNoFix(out, nodeId, seq);
+    case Kind::BATCH:
+    case Kind::TRUNCATED: {
+        FixBatchFrame header{};
+        header.node_id = nodeId;
+        header.seq = seq;
+        header.sample_index = tracker.sampleIndex;
+        header.interval_ds = BATCH_INTERVAL_DS;
+        const size_t fixes = kind == Kind::BATCH ? loadProfile.batchFixes : MALFORMED_BATCH_FIXES;
+        const size_t size = encoder.encodeFixBatch(out, header, tracker.history, fixes);
+        // Cut into the last delta, so the header promises more fixes than there are
+        return kind == Kind::BATCH ? size : size - 1;
+    }
+    case Kind::OVERSIZED: {
+        const size_t size = encoder.encodeFix(out, nodeId, seq, tracker.history[0]);
+        out[size] = 0;
+        return size + 1;
+    }
+    default:
+        return encoder.encodeFix(out, nodeId, seq, tracker.history[0]);
+    }
+}
+
+void LoadGenerator::count(const uint8_t nodeId, const Kind kind, const size_t size) {
+    stats.sent++;
+    stats.perNode[nodeId]++;
+    stats.airtimeUs += lora.timeOnAirUs(size);
+
+    switch (kind) {
+    case Kind::FIX: stats.fixes++; break;
+    case Kind::NO_FIX: stats.noFixes++; break;
+    case Kind::BATCH: stats.batches++; break;
+    case Kind::TRUNCATED: stats.truncated++; break;
+    case Kind::OVERSIZED: stats.oversized++; break;
+    }
+}
+
+void LoadGenerator::report() const {
+    LOG_INF("Sent: %u frames, %u fixes, %u no fix, %u batches of %u, %u truncated, %u oversized", stats.sent,
+            stats.fixes, stats.noFixes, stats.batches, loadProfile.batchFixes, stats.truncated, stats.oversized);
+    LOG_INF("Skipped: %u busy, %u failed, airtime %u ms", stats.busy, stats.failed,
+            static_cast<uint32_t>(stats.airtimeUs / 1000U));
+    for (uint8_t nodeId = 0; nodeId < loadProfile.nodes; nodeId++) {
+        LOG_INF("Node %u: %u frames", nodeId, stats.perNode[nodeId]);
+    }
+}
+
+#ifdef CONFIG_SHELL
+
+static LoadGenerator* shellGenerator(const struct shell* sh) {
+    LoadGenerator* generator = LoadGenerator::instance();
+    if (!generator) {
+        shell_error(sh, "Load generator not started");
+    }
+    return generator;
+}
+
+static bool parseValue(const struct shell* sh, const char* text, const uint32_t min, const uint32_t max,
+                       uint32_t& value) {
+    char* end;
+    value = strtoul(text, &end, 10);
+    if (*end != '\0' || value < min || value > max) {
+        shell_error(sh, "Invalid value '%s' (expected %u-%u)", text, min, max);
+        return false;
+    }
+    return true;
+}
+
+static int cmd_loadgen_start(const struct shell* sh, size_t argc, char** argv) {
+    LoadGenerator* generator = shellGenerator(sh);
+    uint32_t frames = 0;
+    if (!generator || (argc > 1 && !parseValue(sh, argv[1], 0, UINT32_MAX, frames))) {
+        return -EINVAL;
+    }
+
+    if (!generator->start(frames)) {
+        shell_error(sh, "Already running");
+        return -EBUSY;
+    }
+    return 0;
+}
+
+static int cmd_loadgen_stop(const struct shell* sh, size_t argc, char** argv) {
+    LoadGenerator* generator = shellGenerator(sh);
+    if (!generator) {
+        return -ENODEV;
+    }
+
+    generator->stop();
+    return 0;
+}
+
+static int cmd_loadgen_show(const struct shell* sh, size_t argc, char** argv) {
+    const LoadGenerator* generator = shellGenerator(sh);
+    if (!generator) {
+        return -ENODEV;
+    }
+
+    const LoadGenerator::Counters& stats = generator->counters();
+    shell_print(sh, "%s, %u frames sent: %u fixes, %u no fix, %u batches, %u truncated, %u oversized",
+                generator->running() ? "Running" : "Stopped", stats.sent, stats.fixes, stats.noFixes, stats.batches,
+                stats.truncated, stats.oversized);
+    shell_print(sh, "Skipped: %u busy, %u failed", stats.busy, stats.failed);
+    for (uint8_t nodeId = 0; nodeId <= MAX_NODE_ID; nodeId++) {
+        if (stats.perNode[nodeId] > 0) {
+            shell_print(sh, "Node %u: %u frames", nodeId, stats.perNode[nodeId]);
+        }
+    }
+    return 0;
+}
+
+static int cmd_loadgen_set(const struct shell* sh, size_t argc, char** argv) {
+    LoadGenerator* generator = shellGenerator(sh);
+    if (!generator) {
+        return -ENODEV;
+    }
+    if (generator->running()) {
+        shell_error(sh, "Stop the load generator first");
+        return -EBUSY;
+    }
+
+    LoadGenerator::Profile& profile = generator->profile();
+    const char* name = argv[1];
+    uint32_t max = 100;
+    uint32_t min = 0;
+    if (strcmp(name, "nodes") == 0) {
+        min = 1;
+        max = MAX_NODE_ID + 1;
+    } else if (strcmp(name, "interval") == 0) {
+        min = 1;
+        max = UINT16_MAX;
+    } else if (strcmp(name, "fixes") == 0) {
+        min = 1;
+        max = FIX_BATCH_MAX_FIXES;
+    } else if (strcmp(name, "nofix") != 0 && strcmp(name, "batch") != 0 && strcmp(name, "malformed") != 0) {
+        shell_error(sh, "Unknown setting '%s'", name);
+        return -EINVAL;
+    }
+
+    uint32_t value = 0;
+    if (!parseValue(sh, argv[2], min, max, value)) {
+        return -EINVAL;
+    }
+
+    if (strcmp(name, "nodes") == 0) {
+        profile.nodes = static_cast<uint8_t>(value);
+    } else if (strcmp(name, "interval") == 0) {
+        profile.intervalMs = value;
+    } else if (strcmp(name, "fixes") == 0) {
+        profile.batchFixes = static_cast<uint8_t>(value);
+    } else if (strcmp(name, "nofix") == 0) {
+        profile.noFixPercent = static_cast<uint8_t>(value);
+    } else if (strcmp(name, "batch") == 0) {
+        profile.batchPercent = static_cast<uint8_t>(value);
+    } else {
+        profile.malformedPercent = static_cast<uint8_t>(value);
+    }
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_loadgen,
+    SHELL_CMD_ARG(start, NULL, "Start sending [frames]", cmd_loadgen_start, 1, 1),
+    SHELL_CMD(stop, NULL, "Stop sending and log the totals", cmd_loadgen_stop),
+    SHELL_CMD(show, NULL, "Show what has been sent", cmd_loadgen_show),
+    SHELL_CMD_ARG(set, NULL, "Set <nodes|interval|nofix|batch|fixes|malformed> <value>", cmd_loadgen_set, 3, 0),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(loadgen, &sub_loadgen, "Emulate many trackers to load a hunter", NULL);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include <core/Coordinates.h>
+#include <core/LoraTransceiver.h>
+#include <core/Settings.h>
+
+#include "load_generator.h"
+
+LOG_MODULE_REGISTER(main);
+
+// Radio settings changed from the shell apply to the next frame sent
+static bool applySetting(const Settings::Id id, const uint32_t value, void* userData) {
+    auto* lora = static_cast<LoraTransceiver*>(userData);
+    switch (id) {
+    case Settings::Id::FREQUENCY:
+        return lora->setFrequency(value);
+    case Settings::Id::DATARATE:
+        return lora->setDatarate(static_cast<lora_datarate>(value));
+    case Settings::Id::TX_POWER:
+        return lora->setTxPower(static_cast<int8_t>(value));
+    default:
+        return false;
+    }
+}
+
+int main() {
+    // Same saved radio settings as a tracker, so the hunter hears it as one
+    Settings::load();
+    const uint32_t freqHz = Settings::get(Settings::Id::FREQUENCY);
+    static LoraTransceiver lora(0, freqHz);
+    lora.setDatarate(static_cast<lora_datarate>(Settings::get(Settings::Id::DATARATE)));
+    lora.setTxPower(static_cast<int8_t>(Settings::get(Settings::Id::TX_POWER)));
+    Settings::setApplyHandler(applySetting, &lora);
+
+    static LoadGenerator generator(lora);
+#ifdef CONFIG_LICENSED_FREQUENCY
+    static char callsign[Settings::CALLSIGN_LEN + 1] = {};
+    Settings::getBytes(Settings::Id::CALLSIGN, callsign, Settings::CALLSIGN_LEN);
+    generator.setCallsign(callsign);
+#endif
+
+    char mhz[FIXED_POINT_TEXT_SIZE];
+    formatFixedPoint(mhz, static_cast<int32_t>(freqHz), 6, 6);
+    LOG_INF("Load generator on %s MHz, start it with: loadgen start [frames]", mhz);
+
+    while (true) {
+        k_sleep(K_FOREVER);
+    }
+
+    return 0;
+}
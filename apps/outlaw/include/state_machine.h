@@ -3,23 +3,71 @@
 #include <stdint.h>
 #include <zephyr/kernel.h>
 
+#include "core/ChannelAccess.h"
+#include "core/ChannelPlan.h"
+#include "core/FixBatch.h"
 #include "core/GnssReceiver.h"
 #include "core/LoraTransceiver.h"
+#include "core/Relay.h"
+#include "core/Settings.h"
 
 class StateMachine {
 public:
 #ifdef CONFIG_LICENSED_FREQUENCY
-    explicit StateMachine(uint8_t nodeId, const float frequencyMHz = 903.0, const char callsign[6] = "");
+    explicit StateMachine(uint8_t nodeId, const uint32_t frequencyHz = 903'000'000, const char callsign[6] = "");
 #else
-    explicit StateMachine(uint8_t nodeId, const float frequencyMHz = 903.0);
+    explicit StateMachine(uint8_t nodeId, const uint32_t frequencyHz = 903'000'000);
 #endif
     void handleTxTimer();
 
+#ifdef CONFIG_FIX_BATCHING
+    void handleSampleTimer();
+#endif
+
+    void handleTxWork();
+    void handleTxDone();
+
+#ifdef CONFIG_DOWNLINK
+    void handleCommand(const CommandFrame& command);
+    void handleCommandWork();
+    void closeDownlinkWindow();
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+    void handleHopWork();
+#endif
+
     int run();
 
+    /**
+     * Apply a changed setting to the running tracker
+     * @param id Setting changed
+     * @param value New value
+     * @return Whether the setting was applied
+     */
+    bool applySetting(Settings::Id id, uint32_t value);
+
 private:
     enum class State { Transmitter, Receiver };
 
+    void init();
+    bool transmitOwnFrame();
+#ifdef CONFIG_SLOT_TX
+    bool scheduleSlot();
+#endif
+    static void txWorkHandler(k_work* work);
+    void listen();
+#ifdef CONFIG_FREQUENCY_HOPPING
+    static void hopWorkHandler(k_work* work);
+    uint32_t hopFrequency() const;
+    void followChannel();
+#endif
+#ifdef CONFIG_DOWNLINK
+    static void commandWorkHandler(k_work* work);
+    static void windowWorkHandler(k_work* work);
+    CommandStatus applyCommand(const CommandFrame& command);
+#endif
+
     void enterTransmitter();
     void enterReceiver();
     void exitReceiver();
@@ -32,7 +80,68 @@ private:
     LoraTransceiver lora;
     GnssReceiver gnssReceiver;
     k_timer txTimer{};
+    uint32_t txPeriodMs{Settings::DEFAULT_TX_PERIOD_MS};
+#ifdef CONFIG_FIX_BATCHING
+    k_timer sampleTimer{};
+    FixBatch fixBatch;
+#endif
     uint8_t nodeId{};
     int lastPinSate{-1};
     State currentState{State::Transmitter};
+
+    struct TxWork {
+        k_work_delayable work;
+        StateMachine* owner;
+    };
+
+    TxWork txWork{};
+
+#ifdef CONFIG_SLOT_TX
+    // Start of the slot the pending transmission goes out in, in TimestampService ticks
+    uint32_t slotStartTicks{0};
+    bool slotPending{false};
+#endif
+
+#ifdef CONFIG_RELAY
+    RelayCache relayCache;
+    uint8_t relayBudget{0};
+#endif
+
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+    ChannelAccess channelAccess;
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+    struct HopWork {
+        k_work work;
+        StateMachine* owner;
+    };
+
+    ChannelPlan channelPlan;
+    HopWork hopWork{};
+#endif
+
+#ifdef CONFIG_DOWNLINK
+    struct CommandWork {
+        k_work work;
+        StateMachine* owner;
+    };
+
+    struct WindowWork {
+        k_work_delayable work;
+        StateMachine* owner;
+    };
+
+    CommandWork commandWork{};
+    WindowWork windowWork{};
+    // Copied in the receive callback, applied from the system work queue
+    CommandFrame receivedCommand{};
+    // Last command handled and what came of it, acknowledged again while the hunter repeats it
+    CommandFrame lastCommand{};
+    CommandStatus lastCommandStatus{CommandStatus::APPLIED};
+    bool commandHandled{false};
+    bool ackPending{false};
+    // The acknowledgement is on air and the tracker's own frame goes out when it is done
+    bool ackInFlight{false};
+#endif
 };
@@ -19,13 +19,19 @@
 #include <core/GnssReceiver.h>
 #include <core/Settings.h>
 #include <core/TdmaClock.h>
+#include <core/TimestampService.h>
+#include <core/BootTimeline.h>
+#include <core/Coordinates.h>
 
 LOG_MODULE_REGISTER(main);
 GNSS_DATA_CALLBACK_DEFINE(DEVICE_DT_GET(DT_ALIAS(gnss)), gnssCallback);
 
 int main() {
+    bootMark(BootMilestone::MAIN);
+
     static const gpio_dt_spec pps_spec = GPIO_DT_SPEC_GET(DT_ALIAS(pps), gpios);
     static const gpio_dt_spec led = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
+    static const gpio_dt_spec lora_dio0 = GPIO_DT_SPEC_GET_BY_IDX(DT_ALIAS(lora), dio_gpios, 0);
     const device* tim2Dev = DEVICE_DT_GET(DT_ALIAS(tdma_timer));
     if (!device_is_ready(led.port)) {
         LOG_ERR("LED GPIO device not ready\n");
@@ -35,22 +41,34 @@ int main() {
         LOG_ERR("TDMA timer device not ready");
     }
 
+    // PPS and radio edge captures do not depend on settings, so start them first
+    TimestampService& timestamps = TimestampService::instance();
+    timestamps.init(tim2Dev);
+    timestamps.attachPps(&pps_spec);
+    timestamps.attachRadio(&lora_dio0);
+
+    time_setup_pps();
+    TdmaClock::instance().init(timestamps);
+    bootMark(BootMilestone::CLOCK_READY);
+
+    // The GNSS driver has been receiving since boot. The state machine hands the receiver its
+    // aiding data in the background and sends the first frame as soon as the radio is configured.
     Settings::load();
-    const uint8_t nodeId = Settings::getNodeId();
-    const uint32_t freqHz = Settings::getFrequency();
-    const float freqMHz = static_cast<float>(freqHz) / 1'000'000;
+    bootMark(BootMilestone::SETTINGS_LOADED);
+    const uint8_t nodeId = static_cast<uint8_t>(Settings::get(Settings::Id::NODE_ID));
+    const uint32_t freqHz = Settings::get(Settings::Id::FREQUENCY);
+    char mhz[FIXED_POINT_TEXT_SIZE];
+    formatFixedPoint(mhz, static_cast<int32_t>(freqHz), 6, 6);
+    LOG_INF("Frequency: %s MHz, node ID: %u", mhz, nodeId);
 #ifdef CONFIG_LICENSED_FREQUENCY
-    const char callsign[Settings::CALLSIGN_LEN] = {};
-    Settings::getCallsign(const_cast<char*>(callsign));
+    static char callsign[Settings::CALLSIGN_LEN] = {};
+    Settings::getBytes(Settings::Id::CALLSIGN, callsign, sizeof(callsign));
     LOG_INF("Callsign: %.6s", callsign);
-    StateMachine sm(nodeId, freqMHz, callsign);
+    StateMachine sm(nodeId, freqHz, callsign);
 #else
-    StateMachine sm(nodeId, freqMHz);
+    StateMachine sm(nodeId, freqHz);
 #endif
 
-    time_setup_pps(&pps_spec);
-    TdmaClock::instance().init(&pps_spec, tim2Dev);
-
     while (true) {
         const int ret = sm.run();
         if (ret != 0) {
@@ -5,6 +5,10 @@
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
 
+#include "core/EventTrace.h"
+#include "core/Settings.h"
+#include "core/TdmaClock.h"
+
 static constexpr int TRANSMITTER_LOGIC_LEVEL = 0;
 static constexpr int TRANSMITTER_LED_LEVEL = 0;
 
@@ -22,28 +26,88 @@ static void txTimerCallback(struct k_timer* timer) {
     }
 }
 
+#ifdef CONFIG_FIX_BATCHING
+static void sampleTimerCallback(struct k_timer* timer) {
+    if (auto* sm = static_cast<StateMachine*>(k_timer_user_data_get(timer))) {
+        sm->handleSampleTimer();
+    }
+}
+#endif
+
+static bool settingCallback(const Settings::Id id, const uint32_t value, void* userData) {
+    return static_cast<StateMachine*>(userData)->applySetting(id, value);
+}
+
+static void txDoneCallback(void* userData) {
+    static_cast<StateMachine*>(userData)->handleTxDone();
+}
+
+#ifdef CONFIG_DOWNLINK
+static void commandCallback(const CommandFrame& command, void* userData) {
+    static_cast<StateMachine*>(userData)->handleCommand(command);
+}
+#endif
+
 #ifdef CONFIG_LICENSED_FREQUENCY
-StateMachine::StateMachine(uint8_t nodeId, const float frequencyMHz, const char* callsign) :  callsign(callsign), lora(nodeId, frequencyMHz), nodeId(nodeId) {
-    k_timer_init(&txTimer, txTimerCallback, nullptr);
-    k_timer_user_data_set(&txTimer, this);
+StateMachine::StateMachine(uint8_t nodeId, const uint32_t frequencyHz, const char* callsign) :  callsign(callsign), lora(nodeId, frequencyHz), nodeId(nodeId)
+#ifdef CONFIG_RELAY
+    , relayCache(nodeId)
+#endif
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+    , channelAccess(lora, nodeId)
+#endif
+{
     lora.setCallsign(callsign);
+    init();
+}
 
-#ifdef CONFIG_DEFAULT_RECEIVE_MODE
-    currentState = State::Receiver;
-    enterReceiver();
 #else
-    currentState = State::Transmitter;
-    enterTransmitter();
-#endif
 
-    setGnssReciever(&gnssReceiver);
+StateMachine::StateMachine(const uint8_t nodeId, const uint32_t frequencyHz) :  lora(nodeId, frequencyHz), nodeId(nodeId)
+#ifdef CONFIG_RELAY
+    , relayCache(nodeId)
+#endif
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+    , channelAccess(lora, nodeId)
+#endif
+{
+    init();
 }
 
-#else
+#endif
 
-StateMachine::StateMachine(const uint8_t nodeId, const float frequencyMhz) :  lora(nodeId, frequencyMhz), nodeId(nodeId) {
+void StateMachine::init() {
     k_timer_init(&txTimer, txTimerCallback, nullptr);
     k_timer_user_data_set(&txTimer, this);
+#ifdef CONFIG_FIX_BATCHING
+    k_timer_init(&sampleTimer, sampleTimerCallback, nullptr);
+    k_timer_user_data_set(&sampleTimer, this);
+#endif
+    txWork.owner = this;
+    k_work_init_delayable(&txWork.work, txWorkHandler);
+
+    // Settings changed over the air or from the shell take effect straight away
+    txPeriodMs = Settings::get(Settings::Id::TX_PERIOD);
+    lora.setDatarate(static_cast<lora_datarate>(Settings::get(Settings::Id::DATARATE)));
+    lora.setTxPower(static_cast<int8_t>(Settings::get(Settings::Id::TX_POWER)));
+    Settings::setApplyHandler(settingCallback, this);
+#ifdef CONFIG_FREQUENCY_HOPPING
+    channelPlan = ChannelPlan::fromSettings();
+    hopWork.owner = this;
+    k_work_init(&hopWork.work, hopWorkHandler);
+    lora.setClock(&TdmaClock::instance());
+#endif
+#ifdef CONFIG_DOWNLINK
+    commandWork.owner = this;
+    k_work_init(&commandWork.work, commandWorkHandler);
+    windowWork.owner = this;
+    k_work_init_delayable(&windowWork.work, windowWorkHandler);
+#endif
+
+    setGnssReciever(&gnssReceiver);
+#ifdef CONFIG_GNSS_AIDING
+    gnssReceiver.startAiding();
+#endif
 
 #ifdef CONFIG_DEFAULT_RECEIVE_MODE
     currentState = State::Receiver;
@@ -52,38 +116,396 @@ StateMachine::StateMachine(const uint8_t nodeId, const float frequencyMhz) :  lo
     currentState = State::Transmitter;
     enterTransmitter();
 #endif
+}
 
-    setGnssReciever(&gnssReceiver);
+
+void StateMachine::handleTxTimer() {
+    traceEvent(TraceEvent::TX_TIMER);
+#ifdef CONFIG_SLOT_TX
+    if (scheduleSlot()) {
+        return;
+    }
+#endif
+
+    // Switching the radio out of RX touches SPI, so leave the timer ISR first
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+    k_work_schedule(&txWork.work, channelAccess.startDelay());
+#else
+    k_work_schedule(&txWork.work, K_NO_WAIT);
+#endif
 }
 
+#ifdef CONFIG_SLOT_TX
+bool StateMachine::scheduleSlot() {
+    const TdmaClock& clock = TdmaClock::instance();
+    if (clock.source() == TdmaClock::Source::FREERUN) {
+        slotPending = false;
+        return false;
+    }
+
+    // Build the frame and set the radio up a little ahead, only keying is left for the slot
+    constexpr uint32_t prepareUs = CONFIG_SLOT_TX_PREPARE_MS * 1000U;
+    const uint32_t offsetUs = (nodeId * CONFIG_SLOT_TX_SLOT_MS) % TdmaClock::FRAME_LEN_MS * 1000U;
+    slotStartTicks = clock.nextFrameOffsetTicks(offsetUs, prepareUs);
+    slotPending = true;
+    k_work_schedule(&txWork.work, K_USEC(MAX(clock.usUntil(slotStartTicks) - static_cast<int32_t>(prepareUs), 0)));
+    return true;
+}
 #endif
 
+bool StateMachine::transmitOwnFrame() {
+#ifdef CONFIG_FIX_BATCHING
+    if (gnssReceiver.isFixAcquired() && fixBatch.size() > 1) {
+        return lora.txGnssBatch(fixBatch);
+    }
+#endif
 
-void StateMachine::handleTxTimer() {
     if (gnssReceiver.isFixAcquired()) {
-        lora.txGnssPayload(gnssReceiver.getLatestData());
-    } else {
-        lora.txNoFixPayload();
+#ifdef CONFIG_FIX_AGE
+        return lora.txGnssPayload(gnssReceiver.getLatestData(), gnssReceiver.fixUptimeMs());
+#else
+        return lora.txGnssPayload(gnssReceiver.getLatestData());
+#endif
+    }
+    return lora.txNoFixPayload();
+}
+
+void StateMachine::txWorkHandler(k_work* work) {
+    auto* delayable = k_work_delayable_from_work(work);
+    CONTAINER_OF(delayable, TxWork, work)->owner->handleTxWork();
+}
+
+void StateMachine::handleTxWork() {
+    if (currentState != State::Transmitter) {
+        return;
+    }
+    traceEvent(TraceEvent::TX_WORK);
+
+#ifdef CONFIG_DOWNLINK
+    k_work_cancel_delayable(&windowWork.work);
+#endif
+    lora.awaitCancel();
+#ifdef CONFIG_FREQUENCY_HOPPING
+    lora.setFrequency(hopFrequency());
+#endif
+
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+    k_timeout_t backoff;
+    if (!channelAccess.clearToSend(backoff)) {
+        k_work_schedule(&txWork.work, backoff);
+#ifdef CONFIG_RELAY
+        listen();
+#endif
+        return;
+    }
+#endif
+
+    lora.setTx();
+#ifdef CONFIG_RELAY
+    relayBudget = CONFIG_RELAY_FRAMES_PER_SLOT;
+#endif
+#ifdef CONFIG_SLOT_TX
+    if (slotPending) {
+        slotPending = false;
+        lora.armAt(slotStartTicks);
+    }
+#endif
+
+#ifdef CONFIG_DOWNLINK
+    // Acknowledge last slot's command first, so the hunter hears it before the uplink it
+    // answers with its next command
+    if (ackPending) {
+        ackPending = false;
+        ackInFlight = lora.txCommandAck(lastCommand.command_id, lastCommandStatus);
+        if (ackInFlight) {
+            return;
+        }
+    }
+#endif
+
+    if (!transmitOwnFrame()) {
+#ifdef CONFIG_SLOT_TX
+        lora.disarm();
+#endif
+        handleTxDone();
+    }
+}
+
+void StateMachine::handleTxDone() {
+    if (currentState != State::Transmitter) {
+        return;
+    }
+
+#ifdef CONFIG_DOWNLINK
+    if (ackInFlight) {
+        ackInFlight = false;
+        if (transmitOwnFrame()) {
+            return;
+        }
+    }
+#endif
+
+#ifdef CONFIG_RELAY
+    // Spend the rest of the slot re-broadcasting frames heard from other trackers
+    uint8_t frame[RELAY_MAX_INNER_SIZE];
+    uint8_t hops = 0;
+    while (relayBudget > 0) {
+        relayBudget--;
+        const size_t size = relayCache.takeNext(frame, hops);
+        if (size == 0) {
+            break;
+        }
+        if (lora.txRelayed(frame, size, hops)) {
+            return;
+        }
+    }
+
+    // Relaying trackers listen until their next slot, which also covers the downlink window
+    listen();
+#elif defined(CONFIG_DOWNLINK) || defined(CONFIG_FREQUENCY_HOPPING)
+    listen();
+#ifdef CONFIG_DOWNLINK
+    k_work_schedule(&windowWork.work, K_MSEC(CONFIG_DOWNLINK_RX_WINDOW_MS));
+#endif
+#endif
+}
+
+void StateMachine::listen() {
+    lora.setRx();
+    lora.awaitRxPacket();
+}
+
+#ifdef CONFIG_DOWNLINK
+void StateMachine::windowWorkHandler(k_work* work) {
+    auto* delayable = k_work_delayable_from_work(work);
+    CONTAINER_OF(delayable, WindowWork, work)->owner->closeDownlinkWindow();
+}
+
+void StateMachine::closeDownlinkWindow() {
+#if !defined(CONFIG_RELAY) && !defined(CONFIG_FREQUENCY_HOPPING)
+    // Back to standby until the next slot, the hunter only sends right after an uplink
+    lora.awaitCancel();
+    lora.setTx();
+#endif
+}
+
+void StateMachine::handleCommand(const CommandFrame& command) {
+    // Runs in the receive callback, reconfiguring the radio has to wait for the work queue
+    if (k_work_is_pending(&commandWork.work)) {
+        return;
+    }
+
+    receivedCommand = command;
+    k_work_submit(&commandWork.work);
+}
+
+void StateMachine::commandWorkHandler(k_work* work) {
+    CONTAINER_OF(work, CommandWork, work)->owner->handleCommandWork();
+}
+
+void StateMachine::handleCommandWork() {
+    if (currentState != State::Transmitter) {
+        return;
+    }
+
+    k_work_cancel_delayable(&windowWork.work);
+
+    // The hunter repeats a command until it hears the acknowledgement, so apply it only once.
+    // Its IDs start somewhere new on every boot, so only a repeat of the whole command is
+    // taken as one, and anything else is applied and acknowledged with its own status.
+    const bool repeat = commandHandled && receivedCommand.command_id == lastCommand.command_id &&
+                        receivedCommand.target_node == lastCommand.target_node &&
+                        receivedCommand.opcode == lastCommand.opcode && receivedCommand.value == lastCommand.value;
+    if (!repeat) {
+        lora.awaitCancel();
+        lastCommand = receivedCommand;
+        lastCommandStatus = applyCommand(receivedCommand);
+        commandHandled = true;
+        LOG_INF("Command %u (opcode %u, value %u): status %u", lastCommand.command_id, lastCommand.opcode,
+                lastCommand.value, static_cast<uint8_t>(lastCommandStatus));
+    }
+    ackPending = true;
+
+#if defined(CONFIG_RELAY) || defined(CONFIG_FREQUENCY_HOPPING)
+    listen();
+#else
+    closeDownlinkWindow();
+#endif
+}
+
+CommandStatus StateMachine::applyCommand(const CommandFrame& command) {
+    Settings::Id id;
+    switch (static_cast<CommandOpcode>(command.opcode)) {
+    case CommandOpcode::SET_TX_PERIOD:
+        id = Settings::Id::TX_PERIOD;
+        break;
+    case CommandOpcode::SET_DATARATE:
+        id = Settings::Id::DATARATE;
+        break;
+    case CommandOpcode::SET_TX_POWER:
+        id = Settings::Id::TX_POWER;
+        break;
+    case CommandOpcode::SET_FREQUENCY:
+        id = Settings::Id::FREQUENCY;
+        break;
+    case CommandOpcode::SET_NODE_ID:
+        id = Settings::Id::NODE_ID;
+        break;
+    default:
+        return CommandStatus::UNSUPPORTED;
+    }
+
+    // Checked against the same bounds as the shell, applied through applySetting, then saved
+    const int ret = Settings::set(id, command.value);
+    if (ret == -EINVAL) {
+        return CommandStatus::INVALID;
+    }
+    if (ret != 0) {
+        return CommandStatus::FAILED;
+    }
+
+    Settings::commit();
+    return CommandStatus::APPLIED;
+}
+#endif
+
+#ifdef CONFIG_FIX_BATCHING
+void StateMachine::handleSampleTimer() {
+    if (!gnssReceiver.isFixAcquired()) {
+        fixBatch.clear();
+        return;
+    }
+
+    fixBatch.push(LoraTransceiver::toGnssInfo(gnssReceiver.getLatestData()));
+}
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+void StateMachine::hopWorkHandler(k_work* work) {
+    CONTAINER_OF(work, HopWork, work)->owner->handleHopWork();
+}
+
+uint32_t StateMachine::hopFrequency() const {
+    // Without the hunter's frame numbers, wait for it on the channel every cycle visits
+    const TdmaClock& clock = TdmaClock::instance();
+    return clock.hunterSynced() ? channelPlan.frequencyFor(clock.frameNumber()) : channelPlan.frequency(0);
+}
+
+void StateMachine::followChannel() {
+    // Only while listening, transmissions pick their channel as they start
+    if (currentState == State::Transmitter && !lora.isTx() && lora.frequency() != hopFrequency()) {
+        k_work_submit(&hopWork.work);
+    }
+}
+
+void StateMachine::handleHopWork() {
+    if (currentState != State::Transmitter || lora.isTx()) {
+        return;
+    }
+
+    lora.awaitCancel();
+    lora.setFrequency(hopFrequency());
+    listen();
+}
+#endif
+
+bool StateMachine::applySetting(const Settings::Id id, const uint32_t value) {
+    switch (id) {
+    case Settings::Id::TX_PERIOD:
+        txPeriodMs = value;
+        if (currentState == State::Transmitter) {
+            k_timer_start(&txTimer, K_MSEC(txPeriodMs), K_MSEC(txPeriodMs));
+        }
+        return true;
+
+    case Settings::Id::DATARATE:
+        return lora.setDatarate(static_cast<lora_datarate>(value));
+
+    case Settings::Id::TX_POWER:
+        return lora.setTxPower(static_cast<int8_t>(value));
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+    case Settings::Id::HOP_CHANNELS:
+    case Settings::Id::HOP_SPACING:
+        channelPlan = ChannelPlan::fromSettings(id, value);
+        return true;
+
+    case Settings::Id::FREQUENCY:
+        // Channel 0 moves with the frequency, the radio follows at the next hop or frame
+        channelPlan = ChannelPlan::fromSettings(id, value);
+        return true;
+#else
+    case Settings::Id::FREQUENCY:
+        return lora.setFrequency(value);
+#endif
+
+    case Settings::Id::NODE_ID:
+        nodeId = static_cast<uint8_t>(value);
+        lora.setNodeId(nodeId);
+#ifdef CONFIG_RELAY
+        relayCache.setOwnNodeId(nodeId);
+#endif
+        return true;
+
+    default:
+        // Read at boot
+        return true;
     }
 }
 
 int StateMachine::run() {
+#ifdef CONFIG_FREQUENCY_HOPPING
+    followChannel();
+#endif
     return checkForTransition();
 }
 
 void StateMachine::enterTransmitter() {
     LOG_INF("Entering transmitter state");
+    lora.setTxDoneHandler(txDoneCallback, this);
+#ifdef CONFIG_DOWNLINK
+    lora.setCommandHandler(commandCallback, this);
+#endif
+#ifdef CONFIG_RELAY
+    lora.setRelayCache(&relayCache);
+    listen();
+#elif defined(CONFIG_FREQUENCY_HOPPING)
+    listen();
+#else
     lora.setTx();
+#endif
 
     gpio_pin_set_dt(&led, TRANSMITTER_LED_LEVEL);
-    k_timer_start(&txTimer, K_SECONDS(5), K_SECONDS(5));
+    // First frame straight away, so the hunter hears a tracker as soon as it is powered
+    k_timer_start(&txTimer, K_NO_WAIT, K_MSEC(txPeriodMs));
+#ifdef CONFIG_FIX_BATCHING
+    k_timer_start(&sampleTimer, K_NO_WAIT, K_MSEC(CONFIG_FIX_BATCH_INTERVAL_MS));
+#endif
 }
 
 void StateMachine::enterReceiver() {
     LOG_INF("Entering receiver state");
+    lora.setTxDoneHandler(nullptr, nullptr);
+#ifdef CONFIG_SLOT_TX
+    slotPending = false;
+    lora.disarm();
+#endif
+#ifdef CONFIG_DOWNLINK
+    lora.setCommandHandler(nullptr, nullptr);
+    k_work_cancel_delayable(&windowWork.work);
+#endif
+#ifdef CONFIG_RELAY
+    lora.setRelayCache(nullptr);
+#endif
+    lora.awaitCancel();
     lora.setRx();
     gpio_pin_set_dt(&led, RECEIVER_LED_LEVEL);
     k_timer_stop(&txTimer);
+    k_work_cancel_delayable(&txWork.work);
+#ifdef CONFIG_FIX_BATCHING
+    k_timer_stop(&sampleTimer);
+    fixBatch.clear();
+#endif
     lora.awaitRxPacket();
 }
 
@@ -101,6 +523,7 @@ void StateMachine::transitionTo(State target) {
     }
 
     currentState = target;
+    traceEvent(TraceEvent::STATE, static_cast<uint16_t>(target));
 
     if (currentState == State::Transmitter) {
         enterTransmitter();
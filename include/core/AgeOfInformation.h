@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "core/defs.h"
+
+#ifdef CONFIG_FIX_AGE
+
+/**
+ * How old each tracker's position is by the time the hunter outputs it. The tracker sends
+ * the age of the fix at the start of its transmission, the airtime follows from the frame
+ * and the modem settings, and the hunter times the rest from reception to output, so no
+ * clock has to be shared between them.
+ */
+class AgeOfInformation {
+public:
+    struct Stats {
+        uint32_t count;
+        uint32_t lastMs;            // Fix to output of the newest frame
+        uint32_t minMs;
+        uint32_t maxMs;
+        uint64_t totalMs;
+        uint64_t fixToTxTotalMs;    // Sent by the tracker
+        uint64_t airtimeTotalUs;
+        uint64_t rxToOutputTotalUs; // Receive callback to the frame being logged
+    };
+
+    AgeOfInformation();
+
+    /**
+     * Record the age of a fix as it is output
+     * @param nodeId Node that sent the fix
+     * @param fixToTxMs Time from the fix to the start of the transmission
+     * @param airtimeUs Time on air of the frame
+     * @param rxToOutputUs Time from reception to output
+     * @return Age of the fix in milliseconds
+     */
+    uint32_t record(uint8_t nodeId, uint32_t fixToTxMs, uint32_t airtimeUs, uint32_t rxToOutputUs);
+
+    /**
+     * @param nodeId Node to look up, at most MAX_NODE_ID
+     */
+    const Stats& node(uint8_t nodeId) const { return nodes[nodeId]; }
+
+    /**
+     * Log the statistics of every node heard
+     */
+    void report() const;
+
+    /**
+     * Statistics shown by the aoi shell command
+     */
+    static AgeOfInformation* instance() { return shellInstance; }
+
+private:
+    static AgeOfInformation* shellInstance;
+
+    Stats nodes[MAX_NODE_ID + 1]{};
+    int64_t lastReportMs{0};
+};
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frame encode/decode and receive path microbenchmarks. The bench shell command times them with
+// the cycle counter, tests/core/benchmark holds each to a budget on native_sim.
+
+namespace Benchmark {
+
+/**
+ * @return Number of benchmark cases
+ */
+size_t caseCount();
+
+/**
+ * @param index Case, below caseCount()
+ * @return Short name of the case, e.g. "rx_decode"
+ */
+const char* caseName(size_t index);
+
+/**
+ * Rebuild the frames the cases work on and forget every node heard, so runs repeat exactly
+ */
+void prepare();
+
+/**
+ * Run one case, untimed so the caller can use whichever clock it has
+ * @param index Case, below caseCount()
+ * @param iterations Times to run the operation
+ * @return Results of every operation folded together, keep it so the work is not optimized out
+ */
+uint32_t run(size_t index, uint32_t iterations);
+
+} // namespace Benchmark
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Points in start-up whose time since reset is recorded, in the order they normally happen
+ */
+enum class BootMilestone : uint8_t {
+    MAIN = 0,
+    CLOCK_READY,
+    SETTINGS_LOADED,
+    RADIO_READY,
+    GNSS_AIDED,
+    FIRST_TX,
+    FIRST_FIX,
+    COUNT,
+};
+
+/**
+ * Record that a milestone has been reached. Only the first call for each milestone counts.
+ * Safe to call from any context.
+ * @param milestone Milestone reached
+ */
+void bootMark(BootMilestone milestone);
+
+/**
+ * Time a milestone was reached
+ * @param milestone Milestone to look up
+ * @return Microseconds since the kernel started, or 0 if not reached yet
+ */
+uint32_t bootMilestoneUs(BootMilestone milestone);
+
+/**
+ * @return Printable name of a milestone
+ */
+const char* bootMilestoneName(BootMilestone milestone);
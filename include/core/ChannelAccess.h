@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+
+class LoraTransceiver;
+
+/**
+ * Listen-before-talk for trackers whose TDMA clock is free running. Without PPS or a hunter
+ * beacon there are no slots to keep trackers apart, and trackers powered on together would
+ * transmit on the same timer edge for the whole flight. Each transmission is delayed by a
+ * random jitter, and deferred with a random, bounded, exponential backoff while another
+ * transmission is heard on the channel.
+ */
+class ChannelAccess {
+public:
+    struct Counters {
+        uint32_t attempts;      // Transmissions that sensed the channel
+        uint32_t busy;          // Times the channel was busy, each a collision avoided
+        uint32_t deferred;      // Backoffs taken
+        uint32_t forced;        // Transmissions sent on a busy channel after the last backoff
+    };
+
+    /**
+     * @param lora Transceiver to sense the channel with
+     * @param nodeId Seeds the backoff so trackers powered on together draw different delays
+     */
+    ChannelAccess(LoraTransceiver& lora, uint8_t nodeId);
+
+    /**
+     * Whether the TDMA clock is synchronized, in which case the channel is not sensed
+     */
+    static bool synchronized();
+
+    /**
+     * Delay before sensing the channel for the next transmission
+     * @return Random jitter while unsynchronized, otherwise no wait
+     */
+    k_timeout_t startDelay();
+
+    /**
+     * Sense the channel before a transmission. The radio must not be receiving.
+     * @param backoff Filled with the delay before sensing again if the channel is busy
+     * @return Whether to transmit now. Always true while synchronized, or once the backoffs
+     *         for this transmission are used up.
+     */
+    bool clearToSend(k_timeout_t& backoff);
+
+    const Counters& counters() const { return stats; }
+
+    /**
+     * Channel access reported by the lbt shell command
+     */
+    static ChannelAccess* instance() { return shellInstance; }
+
+private:
+    static ChannelAccess* shellInstance;
+
+    LoraTransceiver& lora;
+    Counters stats{};
+    uint32_t randomState;
+    // Backoffs already taken for the pending transmission
+    uint8_t backoffs{0};
+
+    /**
+     * Random delay, uniform up to a bound
+     * @param maxMs Largest delay in milliseconds
+     */
+    uint32_t randomMs(uint32_t maxMs);
+};
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(CONFIG_FREQUENCY_HOPPING) && defined(CONFIG_SETTINGS)
+#include "core/Settings.h"
+#endif
+
+// Channel plan and hopping sequence shared by the hunter and trackers, kept free of Zephyr
+// APIs so host tools can follow the same sequence.
+//
+// Channels are evenly spaced up from the configured frequency, which stays channel 0. Every
+// dwell of a few TDMA frames moves to the next channel of a sequence that visits each
+// channel once per cycle, so a node that only knows channel 0 meets the hunter there once a
+// cycle.
+
+class ChannelPlan {
+public:
+    static constexpr uint8_t MAX_CHANNELS = 16;
+
+    ChannelPlan() = default;
+
+    /**
+     * @param baseHz Frequency of channel 0
+     * @param spacingHz Distance between neighbouring channels
+     * @param channels Number of channels, 1 to stay on channel 0, at most MAX_CHANNELS
+     * @param dwellFrames TDMA frames spent on each channel
+     */
+    ChannelPlan(uint32_t baseHz, uint32_t spacingHz, uint8_t channels, uint16_t dwellFrames);
+
+#if defined(CONFIG_FREQUENCY_HOPPING) && defined(CONFIG_SETTINGS)
+    /**
+     * Plan built from the saved frequency and hopping settings, limited to the band
+     * @param changed Setting being changed, whose value is not stored yet
+     * @param value New value of the changed setting
+     */
+    static ChannelPlan fromSettings(Settings::Id changed = Settings::Id::COUNT, uint32_t value = 0);
+#endif
+
+    /**
+     * Drop the channels above a frequency, e.g. the top of the band
+     * @param maxHz Highest frequency allowed
+     * @return Whether channels were dropped
+     */
+    bool limitTo(uint32_t maxHz);
+
+    uint8_t channels() const { return count; }
+
+    bool hopping() const { return count > 1; }
+
+    /**
+     * Frequency of a channel
+     * @param channel Channel, below channels()
+     */
+    uint32_t frequency(uint8_t channel) const { return baseHz + channel * spacingHz; }
+
+    /**
+     * Channel in use during a TDMA frame
+     */
+    uint8_t channelFor(uint32_t frameNumber) const;
+
+    uint32_t frequencyFor(uint32_t frameNumber) const { return frequency(channelFor(frameNumber)); }
+
+    /**
+     * Whether a TDMA frame is the first of its dwell, when the hunter moves channel and
+     * sends its beacon
+     */
+    bool dwellStart(uint32_t frameNumber) const { return frameNumber % dwellFrames == 0; }
+
+private:
+    uint32_t baseHz{0};
+    uint32_t spacingHz{0};
+    uint8_t count{1};
+    uint16_t dwellFrames{1};
+    // Channels moved per dwell, coprime with count so each cycle visits every channel
+    uint8_t stride{1};
+};
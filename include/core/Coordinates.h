@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/defs.h"
+
+// Integer coordinate helpers, so positions can be scaled, compared and printed without
+// floating point on the hunter's Cortex-M0, which has no FPU. Positions are whole degrees scaled by a power of
+// ten: millidegrees over the air, nanodegrees from the GNSS driver and 1e-7 degrees for
+// u-blox aiding.
+
+// Length of one millidegree of latitude, from the mean Earth radius of 6371 km
+inline constexpr int32_t MILLIDEG_LAT_MM = 111'195;
+
+// Largest latitude and longitude magnitudes a real position can have
+inline constexpr int32_t MILLIDEG_MAX_LATITUDE = 90'000;
+inline constexpr int32_t MILLIDEG_MAX_LONGITUDE = 180'000;
+
+// Longest text formatFixedPoint writes, including the terminator
+inline constexpr size_t FIXED_POINT_TEXT_SIZE = 24;
+
+inline int32_t nanoToMilliDeg(const int64_t nano) {
+    return static_cast<int32_t>(nano / 1'000'000);
+}
+
+inline int32_t nanoToE7(const int64_t nano) {
+    return static_cast<int32_t>(nano / 100);
+}
+
+/**
+ * Whether a position is on the globe. Frames from a faulty or foreign transmitter can carry
+ * anything, so check before a position is used for distances or prediction.
+ */
+inline bool validPosition(const int64_t latitude, const int64_t longitude) {
+    return latitude >= -MILLIDEG_MAX_LATITUDE && latitude <= MILLIDEG_MAX_LATITUDE &&
+           longitude >= -MILLIDEG_MAX_LONGITUDE && longitude <= MILLIDEG_MAX_LONGITUDE;
+}
+
+inline bool validPosition(const GnssInfo& position) {
+    return validPosition(position.latitude, position.longitude);
+}
+
+/**
+ * Format a fixed point number as a decimal, the way printf("%.*f") would for positions
+ * @param out Buffer of at least FIXED_POINT_TEXT_SIZE bytes
+ * @param value Value scaled by 10^decimals
+ * @param decimals Decimal places held in value, at most 9
+ * @param places Decimal places to print, padded with zeros or truncated, at most 9
+ * @return Length of the text, not counting the terminator
+ */
+size_t formatFixedPoint(char* out, int32_t value, uint8_t decimals, uint8_t places);
+
+/**
+ * Parse a non-negative decimal into a fixed point number, the inverse of formatFixedPoint
+ * @param text Digits with an optional decimal point, e.g. "903.125"
+ * @param decimals Decimal places to scale by, at most 9. Text with more is rejected
+ * @param value Set to the number scaled by 10^decimals
+ * @return Whether the text is a number that fits in 32 bits once scaled
+ */
+bool parseFixedPoint(const char* text, uint8_t decimals, uint32_t& value);
+
+/**
+ * Cosine of a latitude, for scaling longitude differences to distances
+ * @param milliDeg Latitude in millidegrees
+ * @return Cosine in Q15, 0 at the poles and 32767 at the equator
+ */
+uint16_t cosLatitudeQ15(int32_t milliDeg);
+
+/**
+ * Offset from one position to another on a flat local plane. Accurate to well under the
+ * millidegree resolution of a fix over the tens of kilometres a flight covers.
+ * @param from Origin
+ * @param to Position to measure
+ * @param northM Filled with metres north of the origin, negative for south
+ * @param eastM Filled with metres east of the origin, negative for west
+ */
+void localOffsetM(const GnssInfo& from, const GnssInfo& to, int32_t& northM, int32_t& eastM);
+
+/**
+ * Position at an offset from another, the inverse of localOffsetM
+ * @param origin Position the offset is from
+ * @param northM Metres north of the origin, negative for south
+ * @param eastM Metres east of the origin, negative for west
+ * @return Offset position, with the origin's satellite count and fix status
+ */
+GnssInfo offsetPosition(const GnssInfo& origin, int32_t northM, int32_t eastM);
+
+/**
+ * Distance between two positions
+ * @return Distance in metres
+ */
+uint32_t distanceM(const GnssInfo& from, const GnssInfo& to);
+
+/**
+ * Bearing from one position to another
+ * @return Bearing in tenths of a degree clockwise from north, 0 - 3599
+ */
+uint16_t bearingDeciDeg(const GnssInfo& from, const GnssInfo& to);
+
+/**
+ * Angle of a vector from the north axis
+ * @param north North component
+ * @param east East component
+ * @return Angle in hundredths of a degree clockwise from north, 0 - 35999
+ */
+uint16_t atan2CentiDeg(int32_t north, int32_t east);
+
+/**
+ * Integer square root
+ * @return Largest r with r * r <= value
+ */
+uint32_t isqrt64(uint64_t value);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_DISCOVERY_SCAN
+
+class LoraTransceiver;
+
+/**
+ * Finds trackers on frequencies the hunter does not know, e.g. one set to another channel
+ * and then lost. The hunter first sweeps the range sensing each channel for energy, which
+ * takes a few milliseconds per channel, then listens on each channel where a signal was
+ * sensed long enough to receive frames and tell which nodes are there. It then receives on
+ * the channel with the most frames, or goes back to where it was when none were received.
+ */
+class DiscoveryScan {
+public:
+    static constexpr size_t MAX_CHANNELS = 8;
+
+    struct Channel {
+        uint32_t frequencyHz;
+        uint16_t energyHits;    // Sweeps that sensed a signal on the channel
+        uint16_t frames;        // Valid frames received while listening
+        uint16_t nodes;         // Bit n set once node n was heard
+        int16_t bestRssi;
+    };
+
+    /**
+     * @param lora Transceiver to sweep with, receiving frames for the hunter
+     */
+    explicit DiscoveryScan(LoraTransceiver& lora);
+
+    /**
+     * Start a discovery, taking the radio over until it is done
+     * @return Whether it started, false while one is running
+     */
+    bool start();
+
+    bool running() const { return phase != Phase::IDLE; }
+
+    /**
+     * Record a valid frame, called from the receive callback
+     * @param frequencyHz Frequency it was received on
+     * @param nodeId Node that sent it
+     * @param rssi Received Signal Strength Indicator
+     */
+    void onFrame(uint32_t frequencyHz, uint8_t nodeId, int16_t rssi);
+
+    /**
+     * Channels a signal was sensed on in the last discovery
+     * @param count Filled with the number of channels
+     */
+    const Channel* channels(size_t& count) const {
+        count = found;
+        return found > 0 ? candidates : nullptr;
+    }
+
+    /**
+     * Discovery run by the discover shell command
+     */
+    static DiscoveryScan* instance() { return shellInstance; }
+
+private:
+    enum class Phase : uint8_t {
+        IDLE,
+        SENSING,
+        LISTENING,
+    };
+
+    struct StepWork {
+        k_work_delayable work;
+        DiscoveryScan* owner;
+    };
+
+    static DiscoveryScan* shellInstance;
+
+    static void stepWorkHandler(k_work* work);
+
+    void step();
+    void sense();
+    void listen();
+
+    /**
+     * Receive on a candidate channel for one listening dwell
+     */
+    void listenOn(size_t index);
+
+    /**
+     * Log what was found and go back to normal reception
+     */
+    void finish();
+
+    void noteEnergy(uint32_t frequencyHz);
+
+    LoraTransceiver& lora;
+    StepWork stepWork{};
+    Phase phase{Phase::IDLE};
+    // Frequency received on before the discovery, returned to if nothing is heard
+    uint32_t homeHz{0};
+    uint32_t frequencyHz{0};
+    uint32_t senseStartMs{0};
+    uint16_t sweeps{0};
+    size_t current{0};
+
+    Channel candidates[MAX_CHANNELS]{};
+    size_t found{0};
+};
+
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "core/defs.h"
+
+#ifdef CONFIG_DOWNLINK
+
+class LoraTransceiver;
+
+/**
+ * Commands queued on the hunter, each sent in the listen window that follows an uplink
+ * from the tracker it is addressed to
+ */
+class DownlinkScheduler {
+public:
+    explicit DownlinkScheduler(LoraTransceiver& lora);
+
+    /**
+     * Queue a command, replacing any command still pending for the same target
+     * @param target Node to command, or BROADCAST_NODE_ID for every tracker heard
+     * @param opcode Setting to change
+     * @param value New value for the setting
+     * @return Command ID, or a negative errno if the target is not a valid node or a node ID
+     *         is sent to every tracker
+     */
+    int queue(uint8_t target, CommandOpcode opcode, uint32_t value);
+
+#if defined(CONFIG_SHELL) || defined(CONFIG_DOWNLINK_CONSOLE)
+    /**
+     * Queue a command from its text form, as typed at the shell or console
+     * @param node Node ID, or "all"
+     * @param setting period, sf, power, freq or nodeid
+     * @param value New value for the setting
+     * @param message Filled with the result, or why the command was rejected
+     * @param messageSize Size of message
+     * @return Command ID, or a negative errno
+     */
+    int queueText(const char* node, const char* setting, const char* value, char* message, size_t messageSize);
+#endif
+
+#ifdef CONFIG_DOWNLINK_CONSOLE
+    /**
+     * Read cmd lines from the console and queue them, for builds without the shell. Never returns.
+     */
+    void runConsole();
+#endif
+
+    /**
+     * Called from the receive callback for each frame heard directly from a tracker
+     * @param nodeId Tracker that transmitted the frame
+     */
+    void onUplink(uint8_t nodeId);
+
+    /**
+     * Called from the receive callback for each acknowledgement
+     * @param ack Acknowledgement received
+     */
+    void onAck(const CommandAckFrame& ack);
+
+    /**
+     * Scheduler commands are queued on by the cmd shell command
+     */
+    static DownlinkScheduler* instance() { return shellInstance; }
+
+private:
+    struct Entry {
+        CommandFrame command;
+        uint16_t ackedMask;
+        // Sends to each tracker, a broadcast counts them for every tracker separately
+        uint8_t attempts[MAX_NODE_ID + 1];
+        bool pending;
+    };
+
+    struct SendWork {
+        k_work work;
+        DownlinkScheduler* owner;
+    };
+
+    static constexpr size_t BROADCAST_ENTRY = MAX_NODE_ID + 1;
+
+    static DownlinkScheduler* shellInstance;
+
+    LoraTransceiver& lora;
+    Entry entries[MAX_NODE_ID + 2]{};
+    // Trackers heard directly, the ones a broadcast waits for
+    uint16_t heardMask{0};
+    // Starts at a random ID on each boot, never 0
+    uint8_t nextCommandId{1};
+
+    // Command picked in the receive callback, sent from the system work queue
+    CommandFrame outgoing{};
+    SendWork sendWork{};
+
+    static void sendWorkHandler(k_work* work);
+    static void txDoneCallback(void* userData);
+
+    void send();
+
+    /**
+     * Pick the command to send after an uplink from a node, counting it as an attempt
+     * @return Entry to send, or nullptr if nothing is pending for the node
+     */
+    Entry* pick(uint8_t nodeId);
+
+    /**
+     * Retire the broadcast once every tracker heard has acknowledged it or run out of attempts
+     */
+    void retireBroadcast();
+};
+
+#endif
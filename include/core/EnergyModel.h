@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_ENERGY_MODEL
+
+/**
+ * Charge drawn from the battery, accounted from the time each component spends in each of its
+ * power states and the board's current in that state. The radio and GNSS report their state
+ * changes, the MCU's active and idle time comes from the scheduler. Currents are set per board
+ * in Kconfig, so a report shows what a rate, spreading factor or duty cycle change costs.
+ */
+class EnergyModel {
+public:
+    enum class Component : uint8_t {
+        RADIO = 0,
+        GNSS,
+        MCU,
+        COUNT,
+    };
+
+    enum class State : uint8_t {
+        RADIO_SLEEP = 0,
+        RADIO_RX,
+        RADIO_TX,
+        GNSS_OFF,
+        GNSS_ACQUIRING,
+        GNSS_TRACKING,
+        MCU_IDLE,
+        MCU_ACTIVE,
+        COUNT,
+    };
+
+    static constexpr size_t STATE_COUNT = static_cast<size_t>(State::COUNT);
+    static constexpr size_t COMPONENT_COUNT = static_cast<size_t>(Component::COUNT);
+
+    struct Totals {
+        uint64_t timeUs[STATE_COUNT];
+        uint64_t chargeUaUs[STATE_COUNT];
+        uint64_t elapsedUs;
+    };
+
+    static EnergyModel& instance();
+
+    /**
+     * Move a component to a new state, the component is the one the state belongs to
+     * @param state State entered now
+     */
+    void enter(State state);
+
+    /**
+     * Account a transmission started now. The radio sleeps once it is done.
+     * @param airtimeUs Time on air of the frame
+     * @param powerDbm Transmit power
+     */
+    void radioTx(uint32_t airtimeUs, int8_t powerDbm);
+
+    /**
+     * Bring every component up to now and copy the totals since boot or the last reset
+     * @param out Filled with the totals
+     */
+    void snapshot(Totals& out);
+
+    /**
+     * Start accounting over from now, keeping each component's current state
+     */
+    void reset();
+
+    /**
+     * @param mah Capacity runtime is projected from
+     */
+    void setBatteryMah(uint32_t mah) { batteryMah = mah; }
+    uint32_t getBatteryMah() const { return batteryMah; }
+
+    /**
+     * Board current in a state, TX at full power
+     * @return Current in microamps
+     */
+    static uint32_t currentUa(State state);
+
+    /**
+     * Transmit current, interpolated between the board's figures at 2 and 20 dBm
+     * @return Current in microamps
+     */
+    static uint32_t txCurrentUa(int8_t powerDbm);
+
+    static Component componentOf(State state);
+
+private:
+    EnergyModel();
+
+    /**
+     * Add the time since each component's last change to its current state. Call with lock held.
+     */
+    void accumulate(int64_t nowTicks);
+
+    void add(State state, uint64_t us, uint32_t currentUa);
+
+    k_spinlock lock{};
+    Totals totals{};
+    State current[COMPONENT_COUNT]{};
+    // Each component's time is accounted up to here, which is ahead of now during a transmission
+    int64_t sinceTicks[COMPONENT_COUNT]{};
+    int64_t startTicks{0};
+    uint64_t lastActiveCycles{0};
+    uint64_t lastIdleCycles{0};
+    uint32_t batteryMah{CONFIG_ENERGY_BATTERY_MAH};
+};
+
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Timestamped events kept in a fixed ring buffer, to see why one particular frame was late. Each
+// event costs a cycle counter read and an 8 byte store. A dump is a header line followed by the
+// entries, oldest first, as hex, interleaved with the normal output:
+//   #TRC HDR <cycles per second> <entries> <overwritten>
+//   #TRC <up to 8 entries hex>
+// tools/trace_export turns dumps into a timeline for a trace viewer.
+
+enum class TraceEvent : uint8_t {
+    PPS = 0,        // PPS edge, arg: edge count
+    RADIO_DONE,     // LoRa DIO0 edge, arg: edge count
+    CLOCK_SOURCE,   // TDMA clock source changed, arg: new TdmaClock::Source
+    FRAME,          // TDMA frame started, arg: frame number
+    TX_TIMER,       // Tracker transmit period expired
+    TX_WORK,        // Tracker preparing its transmission
+    TX_KEY_TIMER,   // Armed transmission woke up to key at its slot start
+    TX_START,       // Frame handed to the modem, arg: size
+    TX_DONE,        // TX done handled, arg: 0
+    RX,             // Frame received, arg: size
+    GNSS,           // GNSS data reported, arg: fix status
+    STATE,          // Tracker state machine transition, arg: state entered
+    COUNT,
+};
+
+// Set on entries recorded from an interrupt
+inline constexpr uint8_t TRACE_FLAG_ISR = 0x01;
+
+struct TraceEntry {
+    uint32_t cycles;
+    uint16_t arg;
+    TraceEvent event;
+    uint8_t flags;
+};
+
+struct TraceHeader {
+    uint32_t cycleHz;
+    uint32_t entries;
+    uint32_t overwritten;
+};
+
+inline constexpr char EVENT_TRACE_PREFIX[] = "#TRC";
+inline constexpr size_t EVENT_TRACE_ENTRY_SIZE = 8;
+inline constexpr size_t EVENT_TRACE_LINE_ENTRIES = 8;
+// Prefix, separator, the entries as hex and the terminator
+inline constexpr size_t EVENT_TRACE_LINE_SIZE =
+    sizeof(EVENT_TRACE_PREFIX) + 1 + 2 * EVENT_TRACE_ENTRY_SIZE * EVENT_TRACE_LINE_ENTRIES + 1;
+
+#ifdef CONFIG_EVENT_TRACE
+/**
+ * Record an event. Safe to call from any context.
+ * @param event Event that happened
+ * @param arg Event specific value
+ */
+void traceEvent(TraceEvent event, uint16_t arg = 0);
+
+/**
+ * Print the buffer as a dump with printk. Recording pauses while it prints.
+ */
+void eventTraceDump();
+#else
+inline void traceEvent(TraceEvent, uint16_t = 0) {}
+#endif
+
+/**
+ * @return Printable name of an event
+ */
+const char* traceEventName(TraceEvent event);
+
+/**
+ * Format a dump header line, without a trailing newline
+ * @param out Buffer of at least EVENT_TRACE_LINE_SIZE bytes
+ * @return Length of the line
+ */
+size_t formatTraceHeader(char* out, const TraceHeader& header);
+
+/**
+ * Format entries as a dump line, without a trailing newline
+ * @param out Buffer of at least EVENT_TRACE_LINE_SIZE bytes
+ * @param entries Entries to format
+ * @param count Number of entries, at most EVENT_TRACE_LINE_ENTRIES
+ * @return Length of the line
+ */
+size_t formatTraceEntries(char* out, const TraceEntry* entries, size_t count);
+
+/**
+ * Parse a dump header line
+ * @param line Line to parse, other output lines are rejected
+ * @param header Filled with the header
+ * @return Whether the line is a well formed header line
+ */
+bool parseTraceHeader(const char* line, TraceHeader& header);
+
+/**
+ * Parse a dump entry line
+ * @param line Line to parse, other output lines are rejected
+ * @param entries Filled with the entries, room for EVENT_TRACE_LINE_ENTRIES
+ * @return Number of entries, 0 if the line is not a well formed entry line
+ */
+size_t parseTraceEntries(const char* line, TraceEntry* entries);
@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef CONFIG_FIX_BATCHING
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+#include "core/defs.h"
+
+// Batch frames carry the interval in tenths of a second
+static_assert(CONFIG_FIX_BATCH_INTERVAL_MS % 100 == 0, "CONFIG_FIX_BATCH_INTERVAL_MS must be a multiple of 100");
+
+/**
+ * Ring buffer of the most recent fixes sampled by the tracker, sent together in a
+ * single FixBatchFrame so several fixes share one preamble, header and CRC. Fixes are
+ * pushed from the sample timer's ISR, so every access is under a spinlock.
+ */
+class FixBatch {
+public:
+    static constexpr size_t CAPACITY = CONFIG_FIX_BATCH_SIZE;
+    static constexpr uint8_t INTERVAL_DS = CONFIG_FIX_BATCH_INTERVAL_MS / 100;
+
+    /**
+     * Add a sampled fix, overwriting the oldest once the batch is full
+     * @param info Fix to add
+     */
+    void push(const GnssInfo& info);
+
+    /**
+     * Drop all buffered fixes, e.g. when the fix is lost
+     */
+    void clear();
+
+    /**
+     * Copy the buffered fixes, all from the same moment even if a fix is pushed meanwhile
+     * @param out Filled with the fixes, newest first, room for CAPACITY
+     * @param sampleIndex Set to the running index of the newest sample, used by the hunter to
+     *        drop fixes it has already seen when consecutive batches overlap
+     * @return Number of fixes copied
+     */
+    size_t copy(GnssInfo* out, uint16_t& sampleIndex) const;
+
+    size_t size() const { return count; }
+
+private:
+    mutable k_spinlock lock{};
+    std::array<GnssInfo, CAPACITY> samples{};
+    size_t head{0};
+    size_t count{0};
+    uint16_t newestIndex{0};
+};
+
+#endif
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/defs.h"
+
+// Frame encoding and decoding, kept free of Zephyr APIs so the same code can be
+// benchmarked on target and built into host-side tools.
+//
+// Over the air a frame is an optional callsign prefix followed by one of the bodies in
+// defs.h. The transmit layout is fixed per build by FrameEncoder's prefix size, while the
+// decoders accept both layouts so one hunter hears licensed and unlicensed trackers alike.
+
+/**
+ * Originating node and sequence number of a frame
+ */
+struct FrameId {
+    uint8_t nodeId{0};
+    uint8_t seq{0};
+};
+
+/**
+ * Size of the callsign prefix of a received frame. Bodies start with a version, node ID or
+ * frame type byte, all below 0x20, where a callsign starts with a printable character.
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @return CALLSIGN_CHAR_COUNT for a licensed frame, 0 otherwise
+ */
+inline size_t framePrefixSize(const uint8_t* data, const size_t size) {
+    return size > CALLSIGN_CHAR_COUNT && data[0] >= 0x20 ? CALLSIGN_CHAR_COUNT : 0;
+}
+
+/**
+ * Builds frames with a callsign prefix of PrefixSize bytes, 0 for unlicensed bands. The prefix
+ * is rendered once when the callsign is set, so each frame is the fixed header followed by
+ * the body copied in one piece.
+ */
+template <size_t PrefixSize>
+class FrameEncoder {
+public:
+    static constexpr size_t PREFIX_SIZE = PrefixSize;
+
+    /**
+     * Size of a frame with the given body
+     */
+    template <typename Body>
+    static constexpr size_t frameSize = PrefixSize + sizeof(Body);
+
+    FrameEncoder() = default;
+
+    explicit FrameEncoder(const char* callsign) { setCallsign(callsign); }
+
+    /**
+     * Render the callsign into the frame header, truncated or zero padded to PrefixSize
+     * @param callsign Callsign to send, ignored when PrefixSize is 0
+     */
+    void setCallsign(const char* callsign);
+
+    /**
+     * Whether frames can be sent: always true without a prefix, otherwise once a callsign is set
+     */
+    bool hasCallsign() const;
+
+    /**
+     * Encode a single fix frame
+     * @param out Buffer of at least frameSize<LoraFrame> bytes
+     * @param nodeId Transmitting node
+     * @param seq Sequence number of the frame
+     * @param fix Fix to send
+     * @return Size of the encoded frame
+     */
+    size_t encodeFix(uint8_t* out, uint8_t nodeId, uint8_t seq, const GnssInfo& fix) const;
+
+    /**
+     * Encode a single fix frame that carries the age of the fix
+     * @param out Buffer of at least frameSize<TimedFixFrame> bytes
+     * @param nodeId Transmitting node
+     * @param seq Sequence number of the frame
+     * @param fix Fix to send
+     * @param fixAgeMs Time from the fix to the start of the transmission, saturated to 16 bits
+     * @return Size of the encoded frame
+     */
+    size_t encodeTimedFix(uint8_t* out, uint8_t nodeId, uint8_t seq, const GnssInfo& fix, uint32_t fixAgeMs) const;
+
+    /**
+     * Encode a frame reporting that the node has no fix
+     * @param out Buffer of at least frameSize<NoFixFrame> bytes
+     * @param nodeId Transmitting node
+     * @param seq Sequence number of the frame
+     * @return Size of the encoded frame
+     */
+    size_t encodeNoFix(uint8_t* out, uint8_t nodeId, uint8_t seq) const;
+
+    /**
+     * Encode a fix batch frame
+     * @param out Buffer of at least frameSize<FixBatchFrame> + (count - 1) * FIX_DELTA_SIZE bytes
+     * @param header Header fields, except count and newest which are taken from fixes
+     * @param fixes Fixes to send, newest first
+     * @param count Number of fixes, at least 1
+     * @return Size of the encoded frame, or 0 if there are no fixes
+     */
+    size_t encodeFixBatch(uint8_t* out, const FixBatchFrame& header, const GnssInfo* fixes, size_t count) const;
+
+    /**
+     * Wrap another tracker's frame in a relay envelope
+     * @param out Buffer of at least frameSize<RelayFrame> + size bytes
+     * @param relayNodeId Relaying node
+     * @param hops Hop count to send with the frame
+     * @param frame Original frame as received, with its own prefix if it has one
+     * @param size Size of the original frame, at most RELAY_MAX_INNER_SIZE
+     * @return Size of the encoded frame, or 0 if the original frame does not fit
+     */
+    size_t encodeRelay(uint8_t* out, uint8_t relayNodeId, uint8_t hops, const uint8_t* frame, size_t size) const;
+
+    /**
+     * Encode a command frame
+     * @param out Buffer of at least frameSize<CommandFrame> bytes
+     * @param command Command fields
+     * @return Size of the encoded frame
+     */
+    size_t encodeCommand(uint8_t* out, const CommandFrame& command) const;
+
+    /**
+     * Encode a command acknowledgement frame
+     * @param out Buffer of at least frameSize<CommandAckFrame> bytes
+     * @param ack Acknowledgement fields
+     * @return Size of the encoded frame
+     */
+    size_t encodeCommandAck(uint8_t* out, const CommandAckFrame& ack) const;
+
+    /**
+     * Encode a hunter beacon frame
+     * @param out Buffer of at least frameSize<BeaconFrame> bytes
+     * @param beacon Beacon fields
+     * @return Size of the encoded frame
+     */
+    size_t encodeBeacon(uint8_t* out, const BeaconFrame& beacon) const;
+
+private:
+    // Zero sized arrays are not allowed, the unlicensed encoder just never reads this byte
+    uint8_t header[PrefixSize > 0 ? PrefixSize : 1]{};
+
+    template <typename Body>
+    size_t write(uint8_t* out, const Body& body) const;
+};
+
+// Layout this build transmits with
+using TxFrameEncoder = FrameEncoder<TX_PREFIX_SIZE>;
+
+// Both layouts are instantiated in FrameCodec.cpp
+extern template class FrameEncoder<0>;
+extern template class FrameEncoder<CALLSIGN_CHAR_COUNT>;
+
+static_assert(FrameEncoder<0>::frameSize<LoraFrame> == 13 && FrameEncoder<0>::frameSize<NoFixFrame> == 8,
+              "Unlicensed frame sizes are part of the protocol");
+static_assert(FrameEncoder<CALLSIGN_CHAR_COUNT>::frameSize<LoraFrame> == 19 &&
+                  FrameEncoder<CALLSIGN_CHAR_COUNT>::frameSize<NoFixFrame> == 14,
+              "Licensed frame sizes are part of the protocol");
+
+/**
+ * Identify the originating node and sequence number of a raw tracker frame
+ * @param data Raw frame, with or without a callsign prefix
+ * @param size Size of the raw frame
+ * @param id Filled with the originating node and sequence number
+ * @return Whether the frame is a tracker frame carrying a sequence number
+ */
+bool identifyFrame(const uint8_t* data, size_t size, FrameId& id);
+
+/**
+ * Decode a single fix frame that carries the age of the fix
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @param frame Filled with the frame
+ * @return Whether the frame is a timed fix frame
+ */
+bool decodeTimedFixFrame(const uint8_t* data, size_t size, TimedFixFrame& frame);
+
+/**
+ * Decode a fix batch frame
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @param header Filled with the frame header
+ * @param fixes Filled with the fixes, newest first
+ * @param capacity Number of fixes that fit in fixes
+ * @return Whether the frame is well formed, all its fixes fit and are positions on the globe
+ */
+bool decodeFixBatchFrame(const uint8_t* data, size_t size, FixBatchFrame& header, GnssInfo* fixes,
+                         size_t capacity);
+
+/**
+ * Split a relay envelope from the frame it carries
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @param envelope Filled with the relay header
+ * @param inner Set to the start of the original frame, including its own prefix
+ * @param innerSize Set to the size of the original frame
+ * @return Whether the envelope is well formed and does not nest another envelope
+ */
+bool decodeRelayFrame(const uint8_t* data, size_t size, RelayFrame& envelope, const uint8_t*& inner,
+                      size_t& innerSize);
+
+/**
+ * Decode a command frame
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @param command Filled with the command
+ * @return Whether the frame is a command frame
+ */
+bool decodeCommandFrame(const uint8_t* data, size_t size, CommandFrame& command);
+
+/**
+ * Decode a command acknowledgement frame
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @param ack Filled with the acknowledgement
+ * @return Whether the frame is a command acknowledgement frame
+ */
+bool decodeCommandAckFrame(const uint8_t* data, size_t size, CommandAckFrame& ack);
+
+/**
+ * Decode a hunter beacon frame
+ * @param data Raw frame
+ * @param size Size of the raw frame
+ * @param beacon Filled with the beacon
+ * @return Whether the frame is a beacon frame
+ */
+bool decodeBeaconFrame(const uint8_t* data, size_t size, BeaconFrame& beacon);
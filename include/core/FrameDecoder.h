@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/NodeTable.h"
+#include "core/defs.h"
+
+/**
+ * Reception details passed along with each decoded frame
+ */
+struct RxInfo {
+    size_t size;
+    int16_t rssi;
+    int8_t snr;
+    // CALLSIGN_CHAR_COUNT characters, not terminated, or nullptr for frames without a callsign
+    const char* callsign;
+};
+
+/**
+ * Receives the frames decoded by a FrameDecoder. The hunter prints them, host tools count them.
+ */
+class FrameSink {
+public:
+    virtual void onFix(const LoraFrame& frame, const RxInfo& rx) = 0;
+
+    /**
+     * A single fix sent with its age at transmission
+     */
+    virtual void onTimedFix(const TimedFixFrame& frame, const RxInfo& rx) = 0;
+
+    /**
+     * One fix unpacked from a batch, called oldest first for fixes not reported before. Older
+     * fixes are sent as position deltas only, so every fix in a batch carries the satellite
+     * count and fix status of the newest one.
+     * @param ageMs How long before the newest fix in the batch this one was sampled
+     */
+    virtual void onBatchFix(const FixBatchFrame& header, const GnssInfo& fix, uint32_t ageMs, const RxInfo& rx) = 0;
+
+    virtual void onNoFix(const NoFixFrame& frame, const RxInfo& rx) = 0;
+
+    /**
+     * Called after the frame carried by a relay envelope has been reported
+     */
+    virtual void onRelayed(const RelayFrame& envelope) = 0;
+
+    /**
+     * A command from the hunter, whichever node it is addressed to
+     */
+    virtual void onCommand(const CommandFrame& command, const RxInfo& rx) = 0;
+
+    virtual void onCommandAck(const CommandAckFrame& ack, const RxInfo& rx) = 0;
+
+    /**
+     * A beacon from a frequency hopping hunter
+     */
+    virtual void onBeacon(const BeaconFrame& beacon, const RxInfo& rx) = 0;
+
+    /**
+     * A frame that is not a tracker frame, reported raw
+     */
+    virtual void onUnknown(const uint8_t* data, const RxInfo& rx) = 0;
+
+    /**
+     * A typed frame whose contents do not match its header
+     * @param nodeId Node named in the header
+     */
+    virtual void onMalformed(FrameType type, uint8_t nodeId, const RxInfo& rx) = 0;
+
+protected:
+    ~FrameSink() = default;
+};
+
+/**
+ * Receive path shared by the hunter and host tools: drops duplicates, unwraps relay envelopes
+ * and batches, and keeps the node table up to date
+ */
+class FrameDecoder {
+public:
+    explicit FrameDecoder(FrameSink& sink) : sink(sink) {}
+
+    /**
+     * Decode a received frame and pass its contents to the sink
+     * @param data Raw frame
+     * @param size Size of the raw frame
+     * @param rssi Received Signal Strength Indicator
+     * @param snr Signal to Noise Ratio
+     * @param nowMs Arrival time, in any millisecond clock that only moves forward
+     * @return Whether the frame was passed on, false if it was a duplicate
+     */
+    bool decode(const uint8_t* data, size_t size, int16_t rssi, int8_t snr, uint32_t nowMs);
+
+    const NodeTable& nodeTable() const { return nodes; }
+
+    /**
+     * Forget every node, as after a restart
+     */
+    void reset() { nodes = NodeTable{}; }
+
+private:
+    void decodeFixBatch(const uint8_t* data, const RxInfo& rx);
+    void decodeRelay(const uint8_t* data, const RxInfo& rx, uint32_t nowMs);
+
+    FrameSink& sink;
+    NodeTable nodes;
+};
@@ -2,6 +2,9 @@
 
 #include <atomic>
 #include <zephyr/drivers/gnss.h>
+#include <zephyr/kernel.h>
+
+#include "core/UbxAiding.h"
 
 
 void setGnssReciever(class GnssReceiver* rec);
@@ -18,7 +21,57 @@ public:
 
     const gnss_data& getLatestData() const { return latestData; }
 
+    /**
+     * Time from boot to the first fix
+     * @return Time to first fix in milliseconds, or 0 if there has been no fix yet
+     */
+    uint32_t getTtffMs() const { return ttffMs; }
+
+#ifdef CONFIG_FIX_AGE
+    /**
+     * Uptime at which the latest data was measured, taken back to its PPS edge when one was
+     * captured, otherwise when the data was reported
+     * @return Uptime in milliseconds
+     */
+    int64_t fixUptimeMs() const { return latestUptimeMs; }
+#endif
+
+#ifdef CONFIG_GNSS_AIDING
+    /**
+     * Send the last fix saved before this boot to the receiver as aiding data, so it can
+     * start searching for the right satellites straight away. The UART writes run on the
+     * system work queue so they overlap the rest of start-up.
+     */
+    void startAiding();
+#endif
+
 private:
     gnss_data latestData;
     std::atomic<bool> fixAcquired{false};
+    std::atomic<uint32_t> ttffMs{0};
+    bool aided{false};
+#ifdef CONFIG_FIX_AGE
+    int64_t latestUptimeMs{0};
+#endif
+
+#ifdef CONFIG_GNSS_AIDING
+    static void saveWorkHandler(k_work* work);
+    static void aidingWorkHandler(k_work* work);
+
+    /**
+     * @return Whether aiding data was sent
+     */
+    bool injectAiding();
+
+    struct ReceiverWork {
+        k_work work;
+        GnssReceiver* owner;
+    };
+
+    ReceiverWork saveWork{};
+    ReceiverWork aidingWork{};
+    AidingFix pendingFix{};
+    int64_t lastSaveMs{0};
+    bool savedThisBoot{false};
+#endif
 };
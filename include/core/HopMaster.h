@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+#include "core/ChannelPlan.h"
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+
+class LoraTransceiver;
+
+/**
+ * Keeps the hunter's TDMA frames, which trackers follow through its beacons. At the start of
+ * each dwell the hunter moves to the next channel of the plan and sends a beacon there, so
+ * trackers already on the sequence correct their frame timing and trackers still waiting on
+ * channel 0 pick it up once a cycle.
+ */
+class HopMaster {
+public:
+    /**
+     * @param lora Transceiver to retune and send beacons with
+     * @param plan Channel plan, shared with the trackers
+     */
+    HopMaster(LoraTransceiver& lora, const ChannelPlan& plan);
+
+    /**
+     * Start frame 0 now, on channel 0
+     */
+    void start();
+
+    uint32_t frameNumber() const { return static_cast<uint32_t>(atomic_get(&frame)); }
+
+private:
+    struct DwellWork {
+        k_work work;
+        HopMaster* owner;
+    };
+
+    struct BeaconWork {
+        k_work_delayable work;
+        HopMaster* owner;
+    };
+
+    static void frameExpiry(k_timer* timer);
+    static void dwellWorkHandler(k_work* work);
+    static void beaconWorkHandler(k_work* work);
+    static void txDoneCallback(void* userData);
+
+    void startDwell();
+    void sendBeacon();
+
+    LoraTransceiver& lora;
+    ChannelPlan plan;
+    k_timer frameTimer{};
+    atomic_t frame{0};
+    // Start of the current frame, for the beacon's offset
+    uint32_t frameStartMs{0};
+
+    DwellWork dwellWork{};
+    BeaconWork beaconWork{};
+};
+
+#endif
@@ -4,13 +4,37 @@
 #include <zephyr/drivers/lora.h>
 #include <stdint.h>
 
+#include "core/FrameCodec.h"
+#include "core/FrameDecoder.h"
+#include "core/Relay.h"
+#include "core/defs.h"
 #include "zephyr/drivers/gnss.h"
 
-struct LoraFrame;
+class AgeOfInformation;
+class DiscoveryScan;
+class DownlinkScheduler;
+class FixBatch;
+class PositionPredictor;
+class SfScanner;
+class TdmaClock;
 
-class LoraTransceiver {
+class LoraTransceiver : private FrameSink {
 public:
-    LoraTransceiver(const uint8_t nodeId, const float frequencyMHz);
+    struct TurnaroundTime {
+        uint32_t count;
+        uint32_t lastUs;
+        uint32_t maxUs;
+        uint64_t totalUs;
+    };
+
+    struct TurnaroundStats {
+        TurnaroundTime rxToTx;      // From setTx() until the frame is handed to the modem
+        TurnaroundTime txToRx;      // From setRx() until the modem is receiving
+        uint32_t fastConfigs;       // Configurations that skipped reprogramming the modem
+        uint32_t fullConfigs;       // Configurations that reprogrammed every modem register
+    };
+
+    LoraTransceiver(const uint8_t nodeId, const uint32_t frequencyHz);
 
     /**
      * Transmit payload with no GNSS fix
@@ -21,9 +45,141 @@ public:
     /**
      * Transmit GNSS payload
      * @param gnssData GNSS data to transmit
+     * @param fixUptimeMs Uptime when the fix was taken, sent as the age of the fix with CONFIG_FIX_AGE
+     * @return Whether transmission was successful
+     */
+    bool txGnssPayload(const gnss_data& gnssData, int64_t fixUptimeMs = 0);
+
+#ifdef CONFIG_FIX_BATCHING
+    /**
+     * Transmit the buffered fixes as a single batch frame
+     * @param batch Fixes to transmit, newest first
      * @return Whether transmission was successful
      */
-    bool txGnssPayload(const gnss_data& gnssData);
+    bool txGnssBatch(const FixBatch& batch);
+#endif
+
+    /**
+     * Transmit a frame encoded elsewhere, e.g. by the load generator as many trackers
+     * @param data Frame to transmit, including any callsign prefix
+     * @param size Size of the frame
+     * @return Whether transmission was successful
+     */
+    bool txFrame(uint8_t* data, size_t size) { return tx(data, size); }
+
+    /**
+     * Convert GNSS driver data into the fix carried over the air
+     * @param gnssData GNSS data to convert
+     * @return Fix in frame units
+     */
+    static GnssInfo toGnssInfo(const gnss_data& gnssData);
+
+#ifdef CONFIG_RELAY
+    /**
+     * Re-broadcast another tracker's frame inside a relay envelope
+     * @param frame Original frame as received
+     * @param size Size of the original frame
+     * @param hops Hop count to send with the frame
+     * @return Whether transmission was successful
+     */
+    bool txRelayed(const uint8_t* frame, size_t size, uint8_t hops);
+
+    /**
+     * Hand received frames to a relay cache instead of printing them
+     * @param cache Cache to fill, or nullptr to print received frames again
+     */
+    void setRelayCache(RelayCache* cache) { relayCache = cache; }
+#endif
+
+#ifdef CONFIG_DOWNLINK
+    /**
+     * Transmit a command to one or all trackers
+     * @param command Command to transmit
+     * @return Whether transmission was successful
+     */
+    bool txCommand(const CommandFrame& command);
+
+    /**
+     * Transmit the acknowledgement of a command
+     * @param commandId ID of the command handled
+     * @param status Outcome of the command
+     * @return Whether transmission was successful
+     */
+    bool txCommandAck(uint8_t commandId, CommandStatus status);
+
+    /**
+     * Set a handler for commands addressed to this node or to all nodes, run from the receive callback
+     * @param handler Handler to run, or nullptr to ignore commands
+     * @param userData Passed to the handler
+     */
+    void setCommandHandler(void (*handler)(const CommandFrame& command, void* userData), void* userData);
+
+    /**
+     * Tell a downlink scheduler about uplinks and acknowledgements as they are received
+     * @param scheduler Scheduler to notify, or nullptr to stop
+     */
+    void setDownlink(DownlinkScheduler* scheduler) { downlink = scheduler; }
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+    /**
+     * Transmit the hunter's beacon for the current frame
+     * @param beacon Beacon to transmit
+     * @return Whether transmission was successful
+     */
+    bool txBeacon(const BeaconFrame& beacon);
+
+    /**
+     * Synchronize a TDMA clock to beacons heard from the hunter
+     * @param tdmaClock Clock to synchronize, or nullptr to ignore beacons
+     */
+    void setClock(TdmaClock* tdmaClock) { clock = tdmaClock; }
+#endif
+
+#ifdef CONFIG_POSITION_PREDICTOR
+    /**
+     * Feed received fixes to a position predictor, and flag those it rejects as outliers
+     * @param tracker Predictor to feed, or nullptr to stop
+     */
+    void setPositionPredictor(PositionPredictor* tracker) { predictor = tracker; }
+#endif
+
+#ifdef CONFIG_FIX_AGE
+    /**
+     * Record how old received fixes are when they are output
+     * @param stats Statistics to update, or nullptr to stop
+     */
+    void setAgeOfInformation(AgeOfInformation* stats) { ageStats = stats; }
+#endif
+
+#ifdef CONFIG_SF_SCAN
+    /**
+     * Report received frames to a spreading factor scanner
+     * @param sfScanner Scanner to notify, or nullptr to stop
+     */
+    void setSfScanner(SfScanner* sfScanner) { scanner = sfScanner; }
+
+    /**
+     * Check whether the modem has detected a preamble since reception started
+     * @return Whether the modem is detecting or synchronized to a LoRa signal
+     */
+    bool preambleDetected();
+#endif
+
+#ifdef CONFIG_DISCOVERY_SCAN
+    /**
+     * Report valid frames and the frequency they were received on to a discovery scan
+     * @param scan Discovery to notify, or nullptr to stop
+     */
+    void setDiscovery(DiscoveryScan* scan) { discovery = scan; }
+#endif
+
+    /**
+     * Set a handler run from the system work queue once each transmission completes
+     * @param handler Handler to run, or nullptr to stop tracking completion
+     * @param userData Passed to the handler
+     */
+    void setTxDoneHandler(void (*handler)(void* userData), void* userData);
 
     /**
      * Setup asynchronous reception
@@ -46,12 +202,81 @@ public:
      */
     void receiveCallback(uint8_t *data, uint16_t size, int16_t rssi, int8_t snr);
 
+    /**
+     * Timestamp of the RxDone edge that delivered the last received frame
+     * @param ticks Filled with the capture in TimestampService ticks
+     * @return Whether the last frame had a capture of its own
+     */
+    bool lastRxTimestamp(uint32_t& ticks) const;
+
+    /**
+     * Time on air of a frame with the current modem configuration
+     * @param size Size of the frame
+     * @return Time from the start of the preamble to the end of the frame in microseconds
+     */
+    uint32_t timeOnAirUs(size_t size) const;
+
+    /**
+     * Symbol duration with the current modem configuration
+     * @return Symbol duration in microseconds
+     */
+    uint32_t symbolUs() const;
+
+    /**
+     * Spreading factor the modem is configured for
+     */
+    lora_datarate datarate() const { return config.datarate; }
+
+    /**
+     * Frequency the modem is configured for
+     * @return Frequency in Hz
+     */
+    uint32_t frequency() const { return config.frequency; }
+
     /**
      * Check if the LoRa modem is in TX mode
      * @return Whether the LoRa modem is in TX mode
      */
     bool isTx() const { return config.tx; };
 
+#ifdef CONFIG_SLOT_TX
+    struct SlotStats {
+        uint32_t armed;             // Transmissions held for a start time
+        uint32_t late;              // Armed after their start time had passed
+        uint32_t measured;          // Starts measured from the TxDone capture
+        int32_t lastErrorUs;        // On-air start minus the start time asked for
+        int32_t minErrorUs;
+        int32_t maxErrorUs;
+        int64_t totalErrorUs;
+        uint32_t maxKeyLatencyUs;   // Start time to the modem being keyed, in software
+    };
+
+    /**
+     * Hold the next transmission and key the modem at a set time instead. The frame is
+     * built and the modem configured straight away, so only keying is left for the start
+     * time, from a timer and a high priority work queue.
+     * @param startTicks Time to start transmitting in TimestampService ticks
+     */
+    void armAt(uint32_t startTicks);
+
+    /**
+     * Drop an armed transmission that has not been keyed yet
+     */
+    void disarm();
+
+    const SlotStats& slotStats() const { return slotTxStats; }
+#endif
+
+    /**
+     * Time taken to switch between receiving and transmitting
+     */
+    const TurnaroundStats& turnaround() const { return turnaroundStats; }
+
+    /**
+     * Transceiver reported by the turnaround shell command
+     */
+    static LoraTransceiver* instance() { return shellInstance; }
+
     /**
      * Set the LoRa modem to TX mode
      * @return Whether setting to TX mode was successful
@@ -64,6 +289,17 @@ public:
      */
     bool setRx();
 
+#if defined(CONFIG_LISTEN_BEFORE_TALK) || defined(CONFIG_DISCOVERY_SCAN)
+    /**
+     * Sense the channel for another transmission. The modem must not be receiving, and is
+     * left configured as it was.
+     * @param rssiThresholdDbm Signal strength above which the channel is busy
+     * @param senseMs How long to listen
+     * @return Whether the signal strength stayed below the threshold
+     */
+    bool isChannelClear(int16_t rssiThresholdDbm, uint32_t senseMs);
+#endif
+
     /**
      * Set the LoRa frequency and reconfigure the modem
      * @param frequency Frequency in Hz
@@ -71,6 +307,20 @@ public:
      */
     bool setFrequency(uint32_t frequency);
 
+    /**
+     * Set the LoRa spreading factor and reconfigure the modem
+     * @param datarate Spreading factor
+     * @return Whether reconfiguration was successful
+     */
+    bool setDatarate(lora_datarate datarate);
+
+    /**
+     * Set the LoRa transmit power and reconfigure the modem
+     * @param power Transmit power in dBm
+     * @return Whether reconfiguration was successful
+     */
+    bool setTxPower(int8_t power);
+
 #ifdef CONFIG_LICENSED_FREQUENCY
     /**
      * Set the callsign for transmission to be used for licensed bands
@@ -96,26 +346,148 @@ private:
         .bandwidth = BW_125_KHZ,
         .datarate = SF_10,
         .coding_rate = CR_4_5,
-        .preamble_len = 8,
+        .preamble_len = CONFIG_LORA_PREAMBLE_LEN,
         .tx_power = 20,
         .tx = false,
         .iq_inverted = false,
         .public_network = false,
     };
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-    const char* callsign;
-#endif
-
     const device* dev = DEVICE_DT_GET(DT_ALIAS(lora));
     uint8_t nodeId;
 
+#ifdef CONFIG_LORA_FAST_TURNAROUND
+    // Configuration last pushed to the modem, and the direction programmed with it
+    lora_modem_config applied{};
+    bool rxApplied{false};
+    bool txApplied{false};
+#endif
+
+    // Held across every modem access, the slot keying queue, the system work
+    // queue and the shell all drive the modem
+    k_mutex radioLock{};
+
+    TurnaroundStats turnaroundStats{};
+    TurnaroundTime* turnaroundPending{nullptr};
+    uint32_t turnaroundStartCycles{0};
+
+    static LoraTransceiver* shellInstance;
+
+#ifdef CONFIG_SLOT_TX
+    struct KeyWork {
+        k_work work;
+        LoraTransceiver* owner;
+    };
+
+    static void keyTimerExpiry(k_timer* timer);
+    static void keyWorkHandler(k_work* work);
+
+    /**
+     * Key the armed frame once its start time comes
+     */
+    void keyArmed();
+
+    /**
+     * Compare the start of a keyed frame, from its TxDone capture, with its start time
+     */
+    void measureSlotStart();
+
+    SlotStats slotTxStats{};
+    k_timer keyTimer{};
+    KeyWork keyWork{};
+    bool armPending{false};
+    bool measurePending{false};
+    uint32_t armedStartTicks{0};
+    uint32_t keyedDoneCount{0};
+    size_t armedLength{0};
+    uint8_t armedFrame[UINT8_MAX];
+#endif
+
+    // Random from boot, see init
+    uint8_t txSequence{0};
+    // Holds the callsign prefix on licensed builds, rendered when the callsign is set
+    TxFrameEncoder encoder;
+
+    // RxDone capture of the last received frame
+    uint32_t rxDoneTicks{0};
+    uint32_t rxDoneCount{0};
+    bool rxDoneValid{false};
+    FrameDecoder decoder{*this};
+
+#ifdef CONFIG_RELAY
+    RelayCache* relayCache{nullptr};
+#endif
+
+#ifdef CONFIG_DOWNLINK
+    DownlinkScheduler* downlink{nullptr};
+    void (*commandHandler)(const CommandFrame& command, void* userData){nullptr};
+    void* commandUserData{nullptr};
+#endif
+
+#ifdef CONFIG_POSITION_PREDICTOR
+    PositionPredictor* predictor{nullptr};
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+    TdmaClock* clock{nullptr};
+#endif
+
+#ifdef CONFIG_FIX_AGE
+    AgeOfInformation* ageStats{nullptr};
+    // Cycle count when the frame being decoded was received
+    uint32_t rxCycles{0};
+#endif
+
+#ifdef CONFIG_SF_SCAN
+    SfScanner* scanner{nullptr};
+#endif
+
+#ifdef CONFIG_DISCOVERY_SCAN
+    DiscoveryScan* discovery{nullptr};
+#endif
+
+    struct TxDoneWork {
+        k_work_poll work;
+        LoraTransceiver* owner;
+    };
+
+    TxDoneWork txDoneWork{};
+    k_poll_signal txSignal{};
+    k_poll_event txEvent{};
+    void (*txDoneHandler)(void* userData){nullptr};
+    void* txDoneUserData{nullptr};
+
+    static void txDoneWorkHandler(k_work* work);
+
     /**
      * Initialize the LoRa modem
      * @return Initialization success
      */
     bool init();
 
+    /**
+     * Configure the modem, only pushing what changed since it was last configured
+     * @return Whether configuration was successful
+     */
+    bool configure();
+
+    /**
+     * Configure the modem with radioLock already held
+     * @return Whether configuration was successful
+     */
+    bool configureLocked();
+
+    /**
+     * Start timing a switch between receiving and transmitting
+     * @param time Direction to account the switch to
+     */
+    void startTurnaround(TurnaroundTime& time);
+
+    /**
+     * Finish timing a switch, once the modem transmits or receives
+     */
+    void endTurnaround();
+
     /**
      * Transmit data
      * @param data Data to transmit
@@ -124,6 +496,14 @@ private:
      */
     bool tx(uint8_t* data, uint32_t data_len);
 
+    /**
+     * Hand a frame to the modem
+     * @param data Data to transmit
+     * @param data_len Length of data to transmit
+     * @return Whether transmission was started
+     */
+    bool send(uint8_t* data, uint32_t data_len);
+
 
     /**
      * Check if frequency is in 433MHz band
@@ -133,10 +513,41 @@ private:
         return (config.frequency >= 410'000'000 && config.frequency <= 450'000'000);
     }
 
+#ifdef CONFIG_RX_CAPTURE
+    /**
+     * Print a received frame as a capture line for replay on a host
+     * @param data Data received
+     * @param size Size of the data received
+     * @param rssi Received Signal Strength Indicator
+     * @param snr Signal to Noise Ratio
+     */
+    void captureFrame(const uint8_t* data, uint16_t size, int16_t rssi, int8_t snr);
+#endif
+
+    // FrameSink: print decoded frames for the Dispatch GUI
+    void onFix(const LoraFrame& frame, const RxInfo& rx) override;
+    void onTimedFix(const TimedFixFrame& frame, const RxInfo& rx) override;
+    void onBatchFix(const FixBatchFrame& header, const GnssInfo& fix, uint32_t ageMs, const RxInfo& rx) override;
+    void onNoFix(const NoFixFrame& frame, const RxInfo& rx) override;
+    void onRelayed(const RelayFrame& envelope) override;
+    void onCommand(const CommandFrame& command, const RxInfo& rx) override;
+    void onCommandAck(const CommandAckFrame& ack, const RxInfo& rx) override;
+    void onBeacon(const BeaconFrame& beacon, const RxInfo& rx) override;
+    void onUnknown(const uint8_t* data, const RxInfo& rx) override;
+    void onMalformed(FrameType type, uint8_t nodeId, const RxInfo& rx) override;
+
+    /**
+     * Prints the position fields of a fix
+     * @param info Fix to print
+     */
+    void printGnssInfo(const GnssInfo& info) const;
+
     /**
-     * Prints the contents of a LoRa frame
-     * @param frame LoRa frame containing the data to print
+     * Feed a received fix to the position predictor, if any
+     * @param nodeId Tracker the fix is from
+     * @param fix Fix received
+     * @param ageMs How long before reception the fix was taken
      */
-    void parseLoraFrame(const LoraFrame& frame, const size_t size, const int16_t rssi, const int8_t snr) const;
+    void predictFix(uint8_t nodeId, const GnssInfo& fix, uint32_t ageMs);
 
 };
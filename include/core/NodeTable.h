@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/FrameCodec.h"
+#include "core/defs.h"
+
+/**
+ * Remembers the recent sequence numbers heard from each node so the same frame
+ * heard directly and through one or more relays is only handled once
+ */
+class SeenFrames {
+public:
+    // A node silent for longer than this is taken to have restarted, so its next frame is new
+    // whatever its sequence number. Relayed copies arrive well within it.
+    static constexpr uint32_t SILENCE_MS = 10'000;
+
+    /**
+     * Record a frame as seen
+     * @param id Frame to record
+     * @param nowMs Arrival time, in any millisecond clock that only moves forward
+     * @return True if the frame had not been seen before
+     */
+    bool markSeen(const FrameId& id, uint32_t nowMs);
+
+private:
+    // Bit n set if (newest - n) has been seen. Sequence numbers far behind the newest
+    // are treated as a restarted tracker rather than a stale duplicate.
+    static constexpr int WINDOW = 32;
+
+    uint8_t newest[MAX_NODE_ID + 1]{};
+    uint32_t window[MAX_NODE_ID + 1]{};
+    // When each node's last new frame arrived
+    uint32_t lastNewMs[MAX_NODE_ID + 1]{};
+};
+
+/**
+ * What the hunter knows about each tracker it has heard
+ */
+class NodeTable {
+public:
+    struct Node {
+        uint32_t frames;
+        uint32_t duplicates;
+        int16_t lastRssi;
+        int8_t lastSnr;
+        bool hasFix;
+        GnssInfo lastFix;
+        // Newest batch sample already reported, so overlapping batches are not reported twice
+        bool batchSeen;
+        uint16_t lastBatchSample;
+        uint32_t lastFrameMs;
+    };
+
+    /**
+     * Record a received frame, counting it against its node
+     * @param id Frame to record
+     * @param rssi Received Signal Strength Indicator
+     * @param snr Signal to Noise Ratio
+     * @param nowMs Arrival time, in any millisecond clock that only moves forward
+     * @return True if the frame had not been seen before
+     */
+    bool accept(const FrameId& id, int16_t rssi, int8_t snr, uint32_t nowMs);
+
+    /**
+     * Record the newest fix reported by a node
+     */
+    void recordFix(uint8_t nodeId, const GnssInfo& fix);
+
+    /**
+     * Count the fixes in a batch that have not been reported yet and mark the batch as reported
+     * @param header Header of the received batch
+     * @return Number of fixes, newest first, that are new
+     */
+    size_t takeFreshBatchFixes(const FixBatchFrame& header);
+
+    /**
+     * @param nodeId Node to look up, at most MAX_NODE_ID
+     */
+    const Node& node(uint8_t nodeId) const { return nodes[nodeId]; }
+
+private:
+    SeenFrames seen;
+    Node nodes[MAX_NODE_ID + 1]{};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/defs.h"
+
+/**
+ * Constant velocity Kalman filter per tracker, so the hunter has an estimate of where each
+ * tracker is between frames. Integer arithmetic throughout with a fixed amount of work per
+ * update, for the hunter's Cortex-M0.
+ *
+ * Positions are tracked in metres on a flat plane around each tracker's first fix. North and
+ * east are filtered independently, but as both axes see the same fixes and noise they share
+ * one covariance.
+ */
+class PositionPredictor {
+public:
+    enum class Result {
+        ACCEPTED,   // Fix folded into the estimate
+        STARTED,    // First fix of a new track, after a long gap or a run of outliers
+        OUTLIER,    // Too far from the prediction, ignored
+        STALE,      // Older than the last fix used, ignored
+        INVALID,    // Not a position on the globe, ignored
+    };
+
+    struct Prediction {
+        GnssInfo position;      // Satellite count and fix status are from the last fix used
+        uint32_t uncertaintyM;  // One standard deviation along each axis
+        int32_t northCmPerS;
+        int32_t eastCmPerS;
+        uint32_t ageMs;         // Time since the last fix used
+    };
+
+    // Longest gap bridged by the velocity estimate, after which a track starts over
+    static constexpr uint32_t MAX_GAP_MS = 60'000;
+
+    // Consecutive outliers after which the tracker is taken to really be somewhere else
+    static constexpr uint8_t MAX_OUTLIERS = 3;
+
+    /**
+     * Feed a decoded fix
+     * @param nodeId Tracker the fix is from
+     * @param fix Fix to feed
+     * @param timeMs When the fix was taken, in the same clock as predict
+     * @return What was done with the fix
+     */
+    Result update(uint8_t nodeId, const GnssInfo& fix, uint32_t timeMs);
+
+    /**
+     * Predict where a tracker is
+     * @param nodeId Tracker to predict
+     * @param nowMs Time to predict for, at most MAX_GAP_MS after its last fix is extrapolated
+     * @param out Filled with the prediction
+     * @return Whether the tracker has a track
+     */
+    bool predict(uint8_t nodeId, uint32_t nowMs, Prediction& out) const;
+
+    void reset();
+
+private:
+    struct Covariance {
+        int64_t p00;
+        int64_t p01;
+        int64_t p11;
+    };
+
+    struct Track {
+        GnssInfo origin;
+        GnssInfo last;
+        // Q8 metres and metres per second, north then east
+        int32_t position[2];
+        int32_t velocity[2];
+        Covariance covariance;
+        uint32_t timeMs;
+        uint8_t outliers;
+        // 0 for no track, 1 with a position only, 2 once a velocity is known
+        uint8_t fixes;
+    };
+
+    Track tracks[MAX_NODE_ID + 1]{};
+
+    static void start(Track& track, const GnssInfo& fix, uint32_t timeMs);
+
+    /**
+     * Covariance of the state after dt of constant velocity motion
+     * @param covariance Covariance at the last fix
+     * @param dtMs Time since the last fix, at most MAX_GAP_MS
+     */
+    static Covariance propagate(const Covariance& covariance, uint32_t dtMs);
+};
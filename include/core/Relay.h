@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "core/FrameCodec.h"
+#include "core/NodeTable.h"
+#include "core/defs.h"
+
+#ifdef CONFIG_RELAY
+
+/**
+ * Latest frame heard from each foreign tracker, waiting to be re-broadcast
+ */
+class RelayCache {
+public:
+    explicit RelayCache(uint8_t ownNodeId) : ownNodeId(ownNodeId) {}
+
+    /**
+     * Offer a received frame for relaying. Relay envelopes are unwrapped so frames
+     * are always re-broadcast in a single envelope with an incremented hop count.
+     * @param data Raw received frame
+     * @param size Size of the raw frame
+     * @param nowMs Arrival time, in any millisecond clock that only moves forward
+     * @return Whether the frame was cached for relaying
+     */
+    bool offer(const uint8_t* data, size_t size, uint32_t nowMs);
+
+    /**
+     * Take the next cached frame waiting to be relayed, round robin across nodes
+     * @param out Buffer of at least RELAY_MAX_INNER_SIZE bytes for the original frame
+     * @param hops Hop count to send the frame with
+     * @return Size of the frame, or 0 if nothing is waiting
+     */
+    size_t takeNext(uint8_t* out, uint8_t& hops);
+
+    void setOwnNodeId(uint8_t id) { ownNodeId = id; }
+
+private:
+    struct Entry {
+        uint8_t data[RELAY_MAX_INNER_SIZE];
+        uint8_t size;
+        uint8_t hops;
+        bool pending;
+    };
+
+    Entry entries[MAX_NODE_ID + 1]{};
+    SeenFrames seen;
+    uint8_t ownNodeId;
+    uint8_t nextNode{0};
+};
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Capture lines record every frame the hunter receives so field problems can be replayed on a
+// host. One line per frame, interleaved with the normal output:
+//   #CAP <arrival us> <rssi dBm> <snr dB> <frame hex>
+
+inline constexpr char RX_CAPTURE_PREFIX[] = "#CAP";
+inline constexpr size_t RX_CAPTURE_MAX_FRAME = 255;
+// Prefix, three numbers with separators, the frame as hex and the terminator
+inline constexpr size_t RX_CAPTURE_LINE_SIZE = sizeof(RX_CAPTURE_PREFIX) + 36 + 2 * RX_CAPTURE_MAX_FRAME + 1;
+
+struct RxCaptureRecord {
+    uint64_t arrivalUs;
+    int16_t rssi;
+    int8_t snr;
+    uint8_t size;
+    uint8_t data[RX_CAPTURE_MAX_FRAME];
+};
+
+/**
+ * Format a received frame as a capture line, without a trailing newline
+ * @param out Buffer of at least RX_CAPTURE_LINE_SIZE bytes
+ * @param record Frame to format
+ * @return Length of the line
+ */
+size_t formatRxCapture(char* out, const RxCaptureRecord& record);
+
+/**
+ * Parse a capture line
+ * @param line Line to parse, other output lines are rejected
+ * @param record Filled with the captured frame
+ * @return Whether the line is a well formed capture line
+ */
+bool parseRxCapture(const char* line, RxCaptureRecord& record);
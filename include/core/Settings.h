@@ -1,19 +1,84 @@
 #pragma once
 
-#if defined(CONFIG_SHELL_FREQUENCY) || defined(CONFIG_LICENSED_FREQUENCY) || defined(CONFIG_SHELL_NODE_ID)
+#ifdef CONFIG_SETTINGS
 
+#include <stddef.h>
 #include <stdint.h>
 
+// Persisted settings, kept in one table of typed descriptors in Settings.cpp. The table drives
+// loading from NVS, bounds checks and the config shell command, so a new setting is an Id and
+// a table entry.
+//
+// Values change in RAM straight away and are written to NVS by commit, so changing several
+// settings together costs one pass over flash.
+
 namespace Settings {
 
 #ifdef CONFIG_LICENSED_FREQUENCY
-constexpr uint32_t DEFAULT_FREQUENCY = 435000000;
+constexpr uint32_t DEFAULT_FREQUENCY = 435'000'000;
 #else
-constexpr uint32_t DEFAULT_FREQUENCY = 903.000000;
+constexpr uint32_t DEFAULT_FREQUENCY = 903'000'000;
 #endif
 constexpr int CALLSIGN_LEN = 6;
 constexpr uint8_t DEFAULT_NODE_ID = 1;
+constexpr uint32_t DEFAULT_TX_PERIOD_MS = 5000;
+#ifdef CONFIG_FREQUENCY_HOPPING
+constexpr uint8_t DEFAULT_HOP_CHANNELS = CONFIG_HOP_CHANNELS;
+constexpr uint32_t DEFAULT_HOP_SPACING = CONFIG_HOP_SPACING_KHZ * 1000U;
+#else
+constexpr uint8_t DEFAULT_HOP_CHANNELS = 1;
+constexpr uint32_t DEFAULT_HOP_SPACING = 500'000;
+#endif
 
+/**
+ * Settings in table order
+ */
+enum class Id : uint8_t {
+    FREQUENCY,
+    CALLSIGN,
+    NODE_ID,
+    TX_PERIOD,
+    DATARATE,
+    TX_POWER,
+    HOP_CHANNELS,
+    HOP_SPACING,
+    LAST_FIX,
+    COUNT,
+};
+
+/**
+ * How a setting is stored and entered
+ */
+enum class Type : uint8_t {
+    UINT,   // Unsigned integer of size bytes, from min to max
+    TEXT,   // Zero padded characters. Entries shorter than min clear the setting
+    BLOB,   // Struct saved by the firmware, not settable from the shell
+};
+
+struct Descriptor {
+    Id id;
+    const char* key;        // Name under config/ in NVS
+    const char* name;       // Name of the config shell subcommand
+    const char* help;
+    Type type;
+    uint8_t size;           // Bytes stored
+    uint8_t decimals;       // Scale of shell entry and display, e.g. 6 for Hz entered as MHz
+    bool shell;             // Whether the config shell command offers it in this build
+    uint32_t min;
+    uint32_t max;
+    uint32_t defaultValue;
+};
+
+/**
+ * Run when a setting is changed, before the new value is stored. Always runs on the system
+ * work queue, changes from other threads wait for it there.
+ * @param id Setting changed
+ * @param value New value of a UINT setting, 0 for others
+ * @param userData Passed to setApplyHandler
+ * @return False if the value could not be applied, which leaves the setting as it was. Settings
+ *         only read at boot are accepted as they are.
+ */
+using ApplyHandler = bool (*)(Id id, uint32_t value, void* userData);
 
 /**
  * Initialize the settings subsystem and load persisted values from NVS.
@@ -22,29 +87,55 @@ constexpr uint8_t DEFAULT_NODE_ID = 1;
  */
 int load();
 
-#ifdef CONFIG_SHELL_FREQUENCY
 /**
- * Get the persisted LoRa frequency, or DEFAULT_FREQUENCY if not yet saved.
+ * Description of a setting
  */
-uint32_t getFrequency();
+const Descriptor& describe(Id id);
 
-int saveFrequency(uint32_t frequency);
-#endif
+/**
+ * Get a UINT setting, its default if not yet saved
+ */
+uint32_t get(Id id);
 
-#ifdef CONFIG_LICENSED_FREQUENCY
 /**
- * Copy the persisted callsign into out (exactly CALLSIGN_LEN bytes, zero-padded).
+ * Change a UINT setting, to be written to NVS by commit
+ * @param id Setting to change
+ * @param value New value
+ * @return 0 on success, -EINVAL if out of range or not a UINT setting, -EIO if not applied
  */
-void getCallsign(char out[CALLSIGN_LEN]);
+int set(Id id, uint32_t value);
 
-int saveCallsign(const char callsign[CALLSIGN_LEN]);
-#endif
+/**
+ * Copy a TEXT or BLOB setting
+ * @param id Setting to get
+ * @param out Buffer to fill, zero padded past the setting
+ * @param size Size of out, the setting is truncated if larger
+ * @return Whether the setting has been saved, out holds zeros if not
+ */
+bool getBytes(Id id, void* out, size_t size);
 
-#ifdef CONFIG_SHELL_NODE_ID
-int saveNodeId(uint8_t nodeId);
-uint8_t getNodeId();
-#endif
+/**
+ * Change a TEXT or BLOB setting, to be written to NVS by commit
+ * @param id Setting to change
+ * @param data New value, zero padded to the size of the setting
+ * @param size Size of data
+ * @return 0 on success, -EINVAL if a UINT setting or too large, -EIO if not applied
+ */
+int setBytes(Id id, const void* data, size_t size);
 
-} // namespace OutlawSettings
+/**
+ * Write every setting changed since the last commit to NVS
+ * @return 0 on success, otherwise the first error, with the failed settings left to retry
+ */
+int commit();
 
-#endif
\ No newline at end of file
+/**
+ * Set a handler that applies settings as they change, e.g. from the shell
+ * @param handler Handler to run, or nullptr to only store changes
+ * @param userData Passed to the handler
+ */
+void setApplyHandler(ApplyHandler handler, void* userData);
+
+} // namespace Settings
+
+#endif
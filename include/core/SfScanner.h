@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/lora.h>
+
+#ifdef CONFIG_SF_SCAN
+
+class LoraTransceiver;
+
+/**
+ * Receives trackers on several spreading factors with one radio. The hunter listens on each
+ * configured spreading factor for a few symbols and moves on unless the modem has detected
+ * a preamble, in which case it stays there until the frame arrives or could no longer be
+ * on air. A tracker's preamble must last one scan cycle for it to be caught.
+ */
+class SfScanner {
+public:
+    struct Counters {
+        uint32_t cycles;            // Scan cycles without a lock or transmission in them
+        uint64_t cycleUsTotal;
+        uint32_t cycleUsMax;
+        uint32_t locks;             // Preambles detected
+        uint32_t frames;            // Frames received while locked
+        uint32_t missed;            // Locks that timed out without a frame
+        uint32_t unlocked;          // Frames received before their preamble was seen
+        uint64_t latencyUsTotal;    // Preamble start to detection, over frames received while locked
+        uint32_t latencyUsMax;
+    };
+
+    /**
+     * @param lora Transceiver to scan with, receiving frames for the hunter
+     */
+    explicit SfScanner(LoraTransceiver& lora);
+
+    /**
+     * Start scanning from the lowest configured spreading factor
+     */
+    void start();
+
+    /**
+     * Account for a received frame, called from the receive callback
+     * @param timeOnAirUs Time on air of the frame at the spreading factor it was received on
+     */
+    void onFrame(uint32_t timeOnAirUs);
+
+    const Counters& counters() const { return stats; }
+
+    /**
+     * Log the scan counters
+     */
+    void report() const;
+
+    /**
+     * Scanner reported by the sfscan shell command
+     */
+    static SfScanner* instance() { return shellInstance; }
+
+private:
+    static constexpr size_t MAX_RATES = SF_12 - SF_7 + 1;
+
+    enum class State : uint8_t {
+        SCANNING,
+        LOCKED,
+    };
+
+    struct StepWork {
+        k_work_delayable work;
+        SfScanner* owner;
+    };
+
+    static SfScanner* shellInstance;
+
+    static void stepWorkHandler(k_work* work);
+
+    void step();
+
+    /**
+     * Retune to the next spreading factor and listen for one dwell
+     */
+    void next();
+
+    static uint64_t nowUs() { return k_ticks_to_us_floor64(k_uptime_ticks()); }
+
+    LoraTransceiver& lora;
+    StepWork stepWork{};
+    lora_datarate rates[MAX_RATES]{};
+    uint8_t rateCount{0};
+    uint8_t current{0};
+    State state{State::SCANNING};
+
+    Counters stats{};
+    uint64_t cycleStartUs{0};
+    // A lock or transmission in this cycle, which keeps it out of the cycle time
+    bool cycleInterrupted{true};
+    uint64_t lockUs{0};
+    uint64_t lastReportUs{0};
+};
+
+#endif
@@ -1,11 +1,11 @@
 #pragma once
 
 #include <stdint.h>
-#include <zephyr/device.h>
-#include <zephyr/drivers/gpio.h>
 #include <zephyr/kernel.h>
 #include <zephyr/sys/atomic.h>
 
+#include "core/TimestampService.h"
+
 class TdmaClock {
 public:
     enum class Source : uint8_t {
@@ -14,26 +14,95 @@ public:
         GPS_PPS = 2,
     };
 
+    // Length of a TDMA frame, one PPS interval
+    static constexpr uint32_t FRAME_LEN_MS = 1000;
+
     static TdmaClock& instance();
 
-    void init(const gpio_dt_spec* pps, const device* tim2Dev);
+    /**
+     * Start keeping TDMA time from the PPS captures of a timestamp service
+     * @param timestamps Service providing the timebase and PPS captures
+     */
+    void init(TimestampService& timestamps);
     Source source() const;
     uint32_t epochTicks() const;
     uint32_t frameNumber() const;
 
-    void onHunterBeacon(uint32_t frameNumber, uint32_t timestamp);
+    /**
+     * Follow the frames of a hunter beacon
+     * @param frameNumber Frame the hunter sent the beacon in
+     * @param timestamp Capture of the end of the beacon in TimestampService ticks
+     * @param frameElapsedUs Time from the start of the hunter's frame to the end of the beacon
+     */
+    void onHunterBeacon(uint32_t frameNumber, uint32_t timestamp, uint32_t frameElapsedUs);
+
+    /**
+     * Whether frame numbers follow a hunter beacon heard recently, so they match the hunter's
+     */
+    bool hunterSynced() const;
+
+    /**
+     * Local oscillator frequency error measured against PPS edges
+     * @return Filtered error in parts per billion, positive when the local clock runs fast
+     */
+    int32_t driftPpb() const;
+
+    /**
+     * Whether enough PPS intervals have been measured to correct for drift in holdover
+     */
+    bool driftValid() const;
+
+    /**
+     * Bound on how far the frame boundary may be from true time, for sizing slot guards
+     * @return Error bound in microseconds, or UINT32_MAX if the clock has never been synced
+     */
+    uint32_t timeErrorBoundUs() const;
+
+    /**
+     * Next time an offset into the frame comes round, e.g. the start of a node's slot
+     * @param offsetUs Offset from the frame boundary
+     * @param leadUs Least time from now
+     * @return Time in TimestampService ticks
+     */
+    uint32_t nextFrameOffsetTicks(uint32_t offsetUs, uint32_t leadUs) const;
+
+    /**
+     * Time from now until a TimestampService time
+     * @param ticks Time in TimestampService ticks
+     * @return Microseconds until then, negative if it has passed
+     */
+    int32_t usUntil(uint32_t ticks) const;
 
 private:
+    // Written from the PPS interrupt, so read as a whole under syncLock
+    struct SyncState {
+        // PPS interval measurement for holdover
+        uint32_t lastPpsTicks;
+        bool lastPpsValid;
+        int32_t driftEstimatePpb;
+        int32_t driftDeviationPpb;
+        uint16_t driftSamples;
+
+        // Last PPS edge or hunter beacon
+        int64_t lastSyncUptimeTicks;
+        bool synced;
+    };
+
     TdmaClock() = default;
 
-    static void ppsIsr(const device* dev, gpio_callback* cb, uint32_t pins);
+    SyncState syncState() const;
+    static bool driftValid(const SyncState& state);
+
+    static void onPps(TimestampService::Event event, uint32_t ticks, void* userData);
     static void freerunExpiry(k_timer* timer);
     static void demoteHandler(k_work* work);
 
     void startFreerun();
     void stopFreerun();
-    uint32_t readTim2Ticks() const;
+    void scheduleFreerun();
     void scheduleDemote(k_timeout_t delay);
+    void updateDrift(uint32_t ppsTicks);
+    void setSource(Source next);
 
     atomic_t currentSource;
     atomic_t epochTicksValue;
@@ -42,10 +111,10 @@ private:
 
     k_timer freerunTimer;
     k_work_delayable demoteWork;
-    gpio_callback ppsCallback;
+    TimestampService* timestamps;
 
-    const gpio_dt_spec* ppsSpec;
-    const device* tim2;
-    bool ppsConfigured;
+    mutable k_spinlock syncLock;
+    SyncState sync;
+    // Next FREERUN frame boundary after the last sync
+    uint64_t freerunNextNs;
 };
-
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Stack headroom and CPU use of every thread, for sizing stacks and finding busy threads on the
+// RAM-starved trackers and hunter. Compiled in with CONFIG_THREAD_STATS.
+
+/**
+ * One thread's use since the previous sample
+ */
+struct ThreadSample {
+    const char* name;
+    uint32_t stackSize;
+    uint32_t stackUsed;     // Deepest the stack has been since the thread started
+    uint16_t cpuPermille;   // Share of the interval spent running this thread
+};
+
+struct ThreadStatsSnapshot {
+    ThreadSample threads[CONFIG_THREAD_STATS_MAX_THREADS];
+    size_t count;
+    size_t missed;          // Threads that did not fit in threads
+    uint32_t intervalMs;
+    // Share of the interval spent in interrupt handlers, 0 without CONFIG_THREAD_STATS_ISR
+    uint16_t isrPermille;
+};
+
+/**
+ * Sample every thread. CPU shares cover the time since the previous sample, or since boot for
+ * the first one.
+ * @param out Filled with the sample
+ */
+void threadStatsSample(ThreadStatsSnapshot& out);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+
+/**
+ * Single timebase for PPS and radio interrupt timestamps. TIM2 is extended to 32 bits and
+ * latched as the first action of each edge's ISR, then fanned out to listeners.
+ *
+ * Trackers only: the hunter has no tdma-timer and never calls init, so there now() and
+ * frequency() return 0 and lastCapture() returns false. Callers shared with the hunter must
+ * fall back on those, as LoraTransceiver does for RxDone times.
+ */
+class TimestampService {
+public:
+    enum class Event : uint8_t {
+        PPS = 0,
+        // LoRa DIO0: TxDone while transmitting, RxDone while receiving
+        RADIO_DONE = 1,
+        COUNT,
+    };
+
+    struct Capture {
+        uint32_t ticks;
+        // Number of edges captured for this event so far, to tell a fresh capture from a stale one
+        uint32_t count;
+    };
+
+    /**
+     * Called from ISR context with the captured timestamp
+     */
+    using Listener = void (*)(Event event, uint32_t ticks, void* userData);
+
+    static constexpr size_t MAX_LISTENERS = 4;
+
+    static TimestampService& instance();
+
+    /**
+     * Start the timer that all captures are taken against
+     * @param timerDev Counter device, TIM2 on the trackers
+     * @return Zephyr error code
+     */
+    int init(const device* timerDev);
+
+    /**
+     * Capture PPS edges from the GNSS receiver
+     * @param pps PPS pin
+     * @return Zephyr error code
+     */
+    int attachPps(const gpio_dt_spec* pps);
+
+    /**
+     * Capture radio done edges alongside the LoRa driver, which keeps ownership of the pin
+     * @param dio LoRa DIO0 pin
+     * @return Zephyr error code
+     */
+    int attachRadio(const gpio_dt_spec* dio);
+
+    /**
+     * Register a listener for captures of one event
+     * @return Whether the listener was added
+     */
+    bool addListener(Event event, Listener listener, void* userData);
+
+    /**
+     * @return Current time in timer ticks, 0 if the timer is not running
+     */
+    uint32_t now() const;
+
+    /**
+     * @return Timer tick rate in Hz, 0 if the timer is not running
+     */
+    uint32_t frequency() const { return timerHz; }
+
+    /**
+     * Latest capture of an event
+     * @param event Event to read
+     * @param capture Filled with the latest capture
+     * @return Whether the event has been captured at least once
+     */
+    bool lastCapture(Event event, Capture& capture) const;
+
+private:
+    TimestampService() = default;
+
+    struct Slot {
+        Listener listener;
+        void* userData;
+        Event event;
+    };
+
+    static void ppsIsr(const device* dev, gpio_callback* cb, uint32_t pins);
+    static void radioIsr(const device* dev, gpio_callback* cb, uint32_t pins);
+    static void timerWrap(const device* dev, void* userData);
+
+    void capture(Event event);
+
+    const device* timer{nullptr};
+    uint32_t timerHz{0};
+    uint32_t timerPeriod{0};
+    atomic_t timerWraps{ATOMIC_INIT(0)};
+
+    gpio_callback ppsCallback{};
+    gpio_callback radioCallback{};
+
+    Capture captures[static_cast<size_t>(Event::COUNT)]{};
+    Slot listeners[MAX_LISTENERS]{};
+    size_t listenerCount{0};
+};
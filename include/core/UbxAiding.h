@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Last good fix kept across reboots, in the units UBX-MGA-INI expects
+ */
+struct AidingFix {
+    int32_t latitudeE7;
+    int32_t longitudeE7;
+    int32_t altitudeCm;
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+};
+
+// Class, ID, length, checksum and sync characters around each UBX payload
+inline constexpr size_t UBX_FRAME_OVERHEAD = 8;
+inline constexpr size_t UBX_MGA_INI_POS_LLH_SIZE = UBX_FRAME_OVERHEAD + 20;
+inline constexpr size_t UBX_MGA_INI_TIME_UTC_SIZE = UBX_FRAME_OVERHEAD + 24;
+
+/**
+ * Encode a UBX-MGA-INI-POS_LLH message giving the receiver an approximate position
+ * @param out Buffer of at least UBX_MGA_INI_POS_LLH_SIZE bytes
+ * @param fix Position to send
+ * @param accuracyCm Standard deviation of the position
+ * @return Size of the message
+ */
+size_t encodeMgaIniPosLlh(uint8_t* out, const AidingFix& fix, uint32_t accuracyCm);
+
+/**
+ * Encode a UBX-MGA-INI-TIME_UTC message giving the receiver an approximate time
+ * @param out Buffer of at least UBX_MGA_INI_TIME_UTC_SIZE bytes
+ * @param fix Time to send
+ * @param accuracyS Uncertainty of the time in seconds
+ * @return Size of the message
+ */
+size_t encodeMgaIniTimeUtc(uint8_t* out, const AidingFix& fix, uint16_t accuracyS);
@@ -4,14 +4,49 @@
 #include <stddef.h>
 
 
-#ifdef CONFIG_LICENSED_FREQUENCY
+// Frames sent on licensed bands start with the callsign, zero padded. The structs below
+// are the frame bodies that follow it; see FrameCodec.h for the over-the-air layouts.
 inline constexpr size_t CALLSIGN_CHAR_COUNT = 6;
-inline constexpr size_t NODE_ID_START_INDEX = CALLSIGN_CHAR_COUNT;
+
+#ifdef CONFIG_LICENSED_FREQUENCY
+inline constexpr size_t TX_PREFIX_SIZE = CALLSIGN_CHAR_COUNT;
 #else
-inline constexpr size_t CALLSIGN_CHAR_COUNT = 0;
-inline constexpr size_t NODE_ID_START_INDEX = 0;
+inline constexpr size_t TX_PREFIX_SIZE = 0;
 #endif
 inline constexpr uint8_t NOFIX[] = "NOFIX";
+inline constexpr uint8_t MAX_NODE_ID = 9;
+
+// Frame type byte at the start of the body. NOFIX frames carry the node ID (0-9) in
+// this position, so types introduced after the original GNSS frame start at 0x10.
+enum class FrameType : uint8_t {
+    GNSS = 0x01,
+    FIX_BATCH = 0x11,
+    RELAY = 0x12,
+    COMMAND = 0x13,
+    COMMAND_ACK = 0x14,
+    BEACON = 0x15,
+    TIMED_FIX = 0x16,
+};
+
+inline constexpr uint8_t FIRST_TYPED_FRAME = 0x10;
+
+// Target of a command addressed to every tracker that hears it
+inline constexpr uint8_t BROADCAST_NODE_ID = 0xFF;
+
+enum class CommandOpcode : uint8_t {
+    SET_TX_PERIOD = 0x01,  // Milliseconds between transmissions
+    SET_DATARATE = 0x02,   // LoRa spreading factor
+    SET_TX_POWER = 0x03,   // dBm
+    SET_FREQUENCY = 0x04,  // Hz
+    SET_NODE_ID = 0x05,
+};
+
+enum class CommandStatus : uint8_t {
+    APPLIED = 0x00,
+    INVALID = 0x01,
+    UNSUPPORTED = 0x02,
+    FAILED = 0x03,
+};
 
 #pragma pack(push, 1)
 struct GnssInfo {
@@ -24,27 +59,100 @@ struct GnssInfo {
 
 #pragma pack(push, 1)
 struct LoraFrame {
-#ifdef CONFIG_LICENSED_FREQUENCY
-    char callsign[CALLSIGN_CHAR_COUNT]{0};
-#endif
     uint8_t version {0x01};
     uint8_t node_id {0};
     GnssInfo gnssInfo {};
+    uint8_t seq {0};
 };
 #pragma pack(pop)
 
 #pragma pack(push, 1)
 struct NoFixFrame {
-#ifdef CONFIG_LICENSED_FREQUENCY
-    char callsign[CALLSIGN_CHAR_COUNT]{0};
-#endif
     uint8_t node_id {0};
     const uint8_t nofix[sizeof(NOFIX)]{'N', 'O', 'F', 'I', 'X'};
+    uint8_t seq {0};
 };
+#pragma pack(pop)
 
-inline constexpr size_t GNSS_INFO_SIZE = sizeof(GnssInfo);
-inline constexpr size_t NODE_ID_SIZE = 1;
-inline constexpr size_t NOFIX_PACKET_SIZE = NODE_ID_SIZE + sizeof(NOFIX) + CALLSIGN_CHAR_COUNT;
-inline constexpr size_t MAX_PAYLOAD_SIZE = NODE_ID_SIZE + GNSS_INFO_SIZE + CALLSIGN_CHAR_COUNT;
+#pragma pack(push, 1)
+struct FixDelta {
+    int16_t latitude {0};
+    int16_t longitude {0};
+};
+#pragma pack(pop)
 
+// Followed by (count - 1) FixDelta entries, each relative to the newest fix and
+// stepping back one sample interval at a time.
+#pragma pack(push, 1)
+struct FixBatchFrame {
+    uint8_t type {static_cast<uint8_t>(FrameType::FIX_BATCH)};
+    uint8_t node_id {0};
+    uint8_t seq {0};
+    uint16_t sample_index {0};
+    uint8_t count {0};
+    uint8_t interval_ds {0};
+    GnssInfo newest {};
+};
+#pragma pack(pop)
 
+// Wraps another tracker's frame, byte for byte, as re-broadcast by a relaying tracker
+#pragma pack(push, 1)
+struct RelayFrame {
+    uint8_t type {static_cast<uint8_t>(FrameType::RELAY)};
+    uint8_t relay_node_id {0};
+    uint8_t hops {0};
+};
+#pragma pack(pop)
+
+// Sent by the hunter in the listen window that follows a tracker's transmission
+#pragma pack(push, 1)
+struct CommandFrame {
+    uint8_t type {static_cast<uint8_t>(FrameType::COMMAND)};
+    uint8_t target_node {BROADCAST_NODE_ID};
+    uint8_t command_id {0};
+    uint8_t opcode {0};
+    uint32_t value {0};
+};
+#pragma pack(pop)
+
+// Sent by a tracker before its next own frame once it has handled a command
+#pragma pack(push, 1)
+struct CommandAckFrame {
+    uint8_t type {static_cast<uint8_t>(FrameType::COMMAND_ACK)};
+    uint8_t node_id {0};
+    uint8_t command_id {0};
+    uint8_t status {0};
+};
+#pragma pack(pop)
+
+// Sent by a frequency hopping hunter at the start of each dwell, on the new channel
+#pragma pack(push, 1)
+struct BeaconFrame {
+    uint8_t type {static_cast<uint8_t>(FrameType::BEACON)};
+    uint32_t frame_number {0};
+    // Time from the start of the frame to the start of the transmission
+    uint16_t offset_ms {0};
+};
+#pragma pack(pop)
+
+// A single fix sent with its age, so the hunter can tell how old a position is when it is output
+#pragma pack(push, 1)
+struct TimedFixFrame {
+    uint8_t type {static_cast<uint8_t>(FrameType::TIMED_FIX)};
+    uint8_t node_id {0};
+    uint8_t seq {0};
+    // Time from the fix to the start of the transmission, saturating
+    uint16_t fix_age_ms {0};
+    GnssInfo fix {};
+};
+#pragma pack(pop)
+
+inline constexpr size_t GNSS_INFO_SIZE = sizeof(GnssInfo);
+inline constexpr size_t NODE_ID_SIZE = 1;
+inline constexpr size_t SEQ_SIZE = 1;
+inline constexpr size_t FIX_DELTA_SIZE = sizeof(FixDelta);
+inline constexpr size_t FIX_BATCH_HEADER_SIZE = sizeof(FixBatchFrame);
+// Upper bound of CONFIG_FIX_BATCH_SIZE, so receivers can size decode buffers without it
+inline constexpr size_t FIX_BATCH_MAX_FIXES = 16;
+inline constexpr size_t RELAY_HEADER_SIZE = sizeof(RelayFrame);
+inline constexpr size_t RELAY_MAX_INNER_SIZE = 96;
@@ -2,7 +2,6 @@
 
 #include <stdint.h>
 
-struct gpio_dt_spec;
-int time_setup_pps(const gpio_dt_spec* pps_pin);
+int time_setup_pps();
 
 uint32_t time_get_gps_seconds();
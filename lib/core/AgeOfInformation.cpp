@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/AgeOfInformation.h"
+
+#ifdef CONFIG_FIX_AGE
+
+#include <zephyr/logging/log.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(age_of_information);
+
+namespace {
+uint32_t average(const uint64_t total, const uint32_t count) {
+    return count == 0 ? 0 : static_cast<uint32_t>(total / count);
+}
+}
+
+AgeOfInformation* AgeOfInformation::shellInstance = nullptr;
+
+AgeOfInformation::AgeOfInformation() {
+    lastReportMs = k_uptime_get();
+    shellInstance = this;
+}
+
+uint32_t AgeOfInformation::record(const uint8_t nodeId, const uint32_t fixToTxMs, const uint32_t airtimeUs,
+                                  const uint32_t rxToOutputUs) {
+    const uint32_t ageMs = fixToTxMs + (airtimeUs + rxToOutputUs + 500U) / 1000U;
+    if (nodeId > MAX_NODE_ID) {
+        return ageMs;
+    }
+
+    Stats& stats = nodes[nodeId];
+    stats.minMs = stats.count == 0 ? ageMs : MIN(stats.minMs, ageMs);
+    stats.count++;
+    stats.lastMs = ageMs;
+    stats.maxMs = MAX(stats.maxMs, ageMs);
+    stats.totalMs += ageMs;
+    stats.fixToTxTotalMs += fixToTxMs;
+    stats.airtimeTotalUs += airtimeUs;
+    stats.rxToOutputTotalUs += rxToOutputUs;
+
+    const int64_t now = k_uptime_get();
+    if (CONFIG_FIX_AGE_REPORT_S > 0 && now - lastReportMs >= CONFIG_FIX_AGE_REPORT_S * 1000LL) {
+        lastReportMs = now;
+        report();
+    }
+    return ageMs;
+}
+
+void AgeOfInformation::report() const {
+    for (uint8_t nodeId = 0; nodeId <= MAX_NODE_ID; nodeId++) {
+        const Stats& stats = nodes[nodeId];
+        if (stats.count == 0) {
+            continue;
+        }
+        LOG_INF("Node %u age: %u fixes, %u ms average, %u-%u ms, fix to TX %u ms, airtime %u ms, RX to output %u us",
+                nodeId, stats.count, average(stats.totalMs, stats.count), stats.minMs, stats.maxMs,
+                average(stats.fixToTxTotalMs, stats.count), average(stats.airtimeTotalUs, stats.count) / 1000U,
+                average(stats.rxToOutputTotalUs, stats.count));
+    }
+}
+
+#ifdef CONFIG_SHELL
+
+static int cmd_aoi(const struct shell *sh, size_t argc, char **argv) {
+    const AgeOfInformation* aoi = AgeOfInformation::instance();
+    if (!aoi) {
+        shell_error(sh, "Receiver not started");
+        return -ENODEV;
+    }
+
+    for (uint8_t nodeId = 0; nodeId <= MAX_NODE_ID; nodeId++) {
+        const AgeOfInformation::Stats& stats = aoi->node(nodeId);
+        if (stats.count == 0) {
+            continue;
+        }
+        shell_print(sh, "Node %u: %u fixes, last %u ms, average %u ms, min %u ms, max %u ms", nodeId, stats.count,
+                    stats.lastMs, average(stats.totalMs, stats.count), stats.minMs, stats.maxMs);
+        shell_print(sh, "  fix to TX %u ms, airtime %u us, RX to output %u us average",
+                    average(stats.fixToTxTotalMs, stats.count), average(stats.airtimeTotalUs, stats.count),
+                    average(stats.rxToOutputTotalUs, stats.count));
+    }
+    return 0;
+}
+
+SHELL_CMD_REGISTER(aoi, NULL, "Show the age of each tracker's fixes when output", cmd_aoi);
+
+#endif
+
+#endif
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifdef CONFIG_CORE_BENCHMARK
+
+#include "core/Benchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <zephyr/kernel.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "core/Coordinates.h"
+#include "core/FrameCodec.h"
+#include "core/FrameDecoder.h"
+#include "core/PositionPredictor.h"
+#include "core/Relay.h"
+#include "core/defs.h"
+
+namespace {
+constexpr size_t batchFixes = 5;
+constexpr uint8_t benchNodeId = 3;
+constexpr char benchCallsign[] = "KK7XYZ";
+
+struct BenchCase {
+    const char* name;
+    // Runs one operation and returns a value folded into the result so it is not optimized out
+    uint32_t (*op)(uint32_t iteration);
+};
+
+GnssInfo sampleFix(const uint32_t iteration) {
+    GnssInfo fix{};
+    fix.latitude = 47'654 + static_cast<int32_t>(iteration & 0xFF);
+    fix.longitude = -122'308 - static_cast<int32_t>(iteration & 0xFF);
+    fix.satellites_cnt = 9;
+    fix.fix_status = 1;
+    return fix;
+}
+
+// Frames are built with the layout this build transmits
+const TxFrameEncoder encoder{benchCallsign};
+
+uint8_t fixFrame[TxFrameEncoder::frameSize<LoraFrame>];
+uint8_t batchFrame[TxFrameEncoder::frameSize<FixBatchFrame> + (batchFixes - 1) * FIX_DELTA_SIZE];
+size_t batchFrameSize;
+uint8_t relayFrame[TxFrameEncoder::frameSize<RelayFrame> + sizeof(fixFrame)];
+size_t relayFrameSize;
+SeenFrames seenFrames;
+
+// Stands in for the hunter's printing so only decoding is timed
+class CountingSink : public FrameSink {
+public:
+    uint32_t count{0};
+
+    void onFix(const LoraFrame&, const RxInfo&) override { count++; }
+    void onTimedFix(const TimedFixFrame&, const RxInfo&) override { count++; }
+    void onBatchFix(const FixBatchFrame&, const GnssInfo&, uint32_t, const RxInfo&) override { count++; }
+    void onNoFix(const NoFixFrame&, const RxInfo&) override { count++; }
+    void onRelayed(const RelayFrame&) override { count++; }
+    void onCommand(const CommandFrame&, const RxInfo&) override { count++; }
+    void onCommandAck(const CommandAckFrame&, const RxInfo&) override { count++; }
+    void onBeacon(const BeaconFrame&, const RxInfo&) override { count++; }
+    void onUnknown(const uint8_t*, const RxInfo&) override { count++; }
+    void onMalformed(FrameType, uint8_t, const RxInfo&) override { count++; }
+};
+
+CountingSink countingSink;
+FrameDecoder decoder{countingSink};
+PositionPredictor predictor;
+
+void prepareFrames() {
+    GnssInfo fixes[batchFixes];
+    for (size_t i = 0; i < batchFixes; i++) {
+        fixes[i] = sampleFix(i * 17);
+    }
+
+    FixBatchFrame header{};
+    header.node_id = benchNodeId;
+    header.interval_ds = 10;
+
+    encoder.encodeFix(fixFrame, benchNodeId, 0, fixes[0]);
+    batchFrameSize = encoder.encodeFixBatch(batchFrame, header, fixes, batchFixes);
+    relayFrameSize = encoder.encodeRelay(relayFrame, benchNodeId + 1, 1, fixFrame, sizeof(fixFrame));
+    seenFrames = SeenFrames{};
+    countingSink.count = 0;
+    decoder.reset();
+    predictor.reset();
+}
+
+uint32_t benchEncodeFix(const uint32_t iteration) {
+    uint8_t out[sizeof(fixFrame)];
+    return encoder.encodeFix(out, benchNodeId, iteration, sampleFix(iteration)) + out[0];
+}
+
+uint32_t benchEncodeBatch(const uint32_t iteration) {
+    GnssInfo fixes[batchFixes];
+    for (size_t i = 0; i < batchFixes; i++) {
+        fixes[i] = sampleFix(iteration + i);
+    }
+
+    FixBatchFrame header{};
+    header.node_id = benchNodeId;
+    header.seq = iteration;
+    header.sample_index = iteration;
+
+    uint8_t out[sizeof(batchFrame)];
+    return encoder.encodeFixBatch(out, header, fixes, batchFixes) + out[0];
+}
+
+uint32_t benchDecodeBatch(const uint32_t iteration) {
+    ARG_UNUSED(iteration);
+
+    FixBatchFrame header{};
+    GnssInfo fixes[FIX_BATCH_MAX_FIXES];
+    return decodeFixBatchFrame(batchFrame, batchFrameSize, header, fixes, FIX_BATCH_MAX_FIXES) + fixes[1].latitude;
+}
+
+uint32_t benchRelayUnwrap(const uint32_t iteration) {
+    ARG_UNUSED(iteration);
+
+    RelayFrame envelope{};
+    const uint8_t* inner = nullptr;
+    size_t innerSize = 0;
+    return decodeRelayFrame(relayFrame, relayFrameSize, envelope, inner, innerSize) + innerSize;
+}
+
+// Receive path up to printing: identify the frame, then drop it if already seen
+uint32_t benchRxDedup(const uint32_t iteration) {
+    fixFrame[sizeof(fixFrame) - SEQ_SIZE] = static_cast<uint8_t>(iteration);
+
+    FrameId id{};
+    return identifyFrame(fixFrame, sizeof(fixFrame), id) && seenFrames.markSeen(id, iteration);
+}
+
+// Full receive path, as the hunter runs it, for a relayed batch
+uint32_t benchRxDecode(const uint32_t iteration) {
+    uint8_t frame[TxFrameEncoder::frameSize<RelayFrame> + sizeof(batchFrame)];
+    // Each iteration is a new batch one sample on from the last
+    FixBatchFrame header{};
+    memcpy(&header, batchFrame + TxFrameEncoder::PREFIX_SIZE, sizeof(header));
+    header.seq = static_cast<uint8_t>(iteration);
+    header.sample_index = static_cast<uint16_t>(iteration);
+    memcpy(batchFrame + TxFrameEncoder::PREFIX_SIZE, &header, sizeof(header));
+
+    const size_t size = encoder.encodeRelay(frame, benchNodeId + 1, 1, batchFrame, batchFrameSize);
+
+    decoder.decode(frame, size, -80, 7, iteration);
+    return countingSink.count;
+}
+
+// Per-packet position formatting on the hunter, as printed for the Dispatch GUI
+uint32_t benchFormatFix(const uint32_t iteration) {
+    const GnssInfo fix = sampleFix(iteration);
+    char text[FIXED_POINT_TEXT_SIZE];
+    return formatFixedPoint(text, fix.latitude, 3, 6) + formatFixedPoint(text, fix.longitude, 3, 6) + text[0];
+}
+
+uint32_t benchDistance(const uint32_t iteration) {
+    const GnssInfo from = sampleFix(0);
+    const GnssInfo to = sampleFix(iteration);
+    return distanceM(from, to) + bearingDeciDeg(from, to);
+}
+
+// Hunter's per-fix predictor update, a fix a second from a drifting tracker
+uint32_t benchPredict(const uint32_t iteration) {
+    return static_cast<uint32_t>(predictor.update(benchNodeId, sampleFix(iteration), iteration * 1000));
+}
+
+constexpr BenchCase cases[] = {
+    {"encode_fix", benchEncodeFix},
+    {"encode_batch", benchEncodeBatch},
+    {"decode_batch", benchDecodeBatch},
+    {"relay_unwrap", benchRelayUnwrap},
+    {"rx_dedup", benchRxDedup},
+    {"rx_decode", benchRxDecode},
+    {"format_fix", benchFormatFix},
+    {"distance", benchDistance},
+    {"predict", benchPredict},
+};
+} // namespace
+
+namespace Benchmark {
+
+void prepare() {
+    prepareFrames();
+}
+
+size_t caseCount() {
+    return ARRAY_SIZE(cases);
+}
+
+const char* caseName(const size_t index) {
+    return cases[index].name;
+}
+
+uint32_t run(const size_t index, const uint32_t iterations) {
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        acc += cases[index].op(i);
+    }
+    return acc;
+}
+
+} // namespace Benchmark
+
+#ifdef CONFIG_SHELL
+namespace {
+volatile uint32_t sink;
+}
+
+static int cmd_bench(const struct shell *sh, size_t argc, char **argv) {
+    uint32_t iterations = CONFIG_CORE_BENCHMARK_ITERATIONS;
+    if (argc > 1) {
+        char *end;
+        iterations = strtoul(argv[1], &end, 10);
+        if (*end != '\0' || iterations == 0) {
+            shell_error(sh, "Invalid iteration count '%s'", argv[1]);
+            return -EINVAL;
+        }
+    }
+
+    int ret = 0;
+    for (size_t index = 0; index < Benchmark::caseCount(); index++) {
+        Benchmark::prepare();
+        const uint32_t start = k_cycle_get_32();
+        sink = Benchmark::run(index, iterations);
+        const uint32_t cycles = k_cycle_get_32() - start;
+
+        const uint32_t cyclesPerOp = cycles / iterations;
+        const uint32_t nsPerOp = static_cast<uint32_t>(k_cyc_to_ns_floor64(cycles) / iterations);
+        const bool overBudget = CONFIG_CORE_BENCHMARK_BUDGET_NS != 0 && nsPerOp > CONFIG_CORE_BENCHMARK_BUDGET_NS;
+
+        shell_print(sh, "%-14s %8u cycles/op %8u ns/op%s", Benchmark::caseName(index), cyclesPerOp, nsPerOp,
+                    overBudget ? " OVER BUDGET" : "");
+        if (overBudget) {
+            ret = -ETIME;
+        }
+    }
+
+    return ret;
+}
+
+SHELL_CMD_ARG_REGISTER(bench, NULL, "Benchmark frame encode/decode and the receive path [iterations]", cmd_bench, 1, 1);
+#endif
+
+#endif
@@ -0,0 +1,69 @@
+#include "core/BootTimeline.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/atomic.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(boot, LOG_LEVEL_INF);
+
+static constexpr size_t MILESTONE_COUNT = static_cast<size_t>(BootMilestone::COUNT);
+
+static atomic_t milestoneUs[MILESTONE_COUNT];
+
+static constexpr const char* MILESTONE_NAMES[MILESTONE_COUNT] = {
+    "main",
+    "clock ready",
+    "settings loaded",
+    "radio ready",
+    "gnss aided",
+    "first tx",
+    "first fix",
+};
+
+void bootMark(const BootMilestone milestone) {
+    const size_t index = static_cast<size_t>(milestone);
+    if (index >= MILESTONE_COUNT) {
+        return;
+    }
+
+    // Never record 0, which means not reached
+    const uint32_t now = MAX(static_cast<uint32_t>(k_ticks_to_us_floor64(k_uptime_ticks())), 1U);
+    if (!atomic_cas(&milestoneUs[index], 0, static_cast<atomic_val_t>(now))) {
+        return;
+    }
+
+    if (milestone == BootMilestone::FIRST_TX) {
+        LOG_INF("First packet sent %u ms after boot", now / 1000U);
+    }
+}
+
+uint32_t bootMilestoneUs(const BootMilestone milestone) {
+    const size_t index = static_cast<size_t>(milestone);
+    return index < MILESTONE_COUNT ? static_cast<uint32_t>(atomic_get(&milestoneUs[index])) : 0U;
+}
+
+const char* bootMilestoneName(const BootMilestone milestone) {
+    const size_t index = static_cast<size_t>(milestone);
+    return index < MILESTONE_COUNT ? MILESTONE_NAMES[index] : "unknown";
+}
+
+#ifdef CONFIG_SHELL
+static int cmd_boot(const struct shell *sh, size_t argc, char **argv) {
+    for (size_t i = 0; i < MILESTONE_COUNT; i++) {
+        const auto milestone = static_cast<BootMilestone>(i);
+        const uint32_t us = bootMilestoneUs(milestone);
+        if (us == 0) {
+            shell_print(sh, "%-16s -", bootMilestoneName(milestone));
+        } else {
+            shell_print(sh, "%-16s %8u.%03u ms", bootMilestoneName(milestone), us / 1000U, us % 1000U);
+        }
+    }
+    return 0;
+}
+
+SHELL_CMD_REGISTER(boot, NULL, "Show time since reset of each start-up milestone", cmd_boot);
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/ChannelAccess.h"
+
+#ifdef CONFIG_LISTEN_BEFORE_TALK
+
+#include <zephyr/logging/log.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "core/LoraTransceiver.h"
+#include "core/TdmaClock.h"
+
+LOG_MODULE_REGISTER(channel_access);
+
+ChannelAccess* ChannelAccess::shellInstance = nullptr;
+
+ChannelAccess::ChannelAccess(LoraTransceiver& lora, const uint8_t nodeId) : lora(lora) {
+    // The parts have no hardware RNG. The node ID keeps trackers that boot in lockstep apart,
+    // the cycle counter varies the sequence from one power-up to the next.
+    randomState = (nodeId + 1U) * 0x9E3779B9U ^ k_cycle_get_32();
+    if (randomState == 0) {
+        randomState = 1;
+    }
+    shellInstance = this;
+}
+
+bool ChannelAccess::synchronized() {
+    return TdmaClock::instance().source() != TdmaClock::Source::FREERUN;
+}
+
+uint32_t ChannelAccess::randomMs(const uint32_t maxMs) {
+    // xorshift32, plenty to spread transmissions apart
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return maxMs == 0 ? 0 : randomState % (maxMs + 1);
+}
+
+k_timeout_t ChannelAccess::startDelay() {
+    if (synchronized()) {
+        return K_NO_WAIT;
+    }
+    return K_MSEC(randomMs(CONFIG_LBT_JITTER_MS));
+}
+
+bool ChannelAccess::clearToSend(k_timeout_t& backoff) {
+    if (synchronized()) {
+        backoffs = 0;
+        return true;
+    }
+
+    if (backoffs == 0) {
+        stats.attempts++;
+    }
+
+    if (lora.isChannelClear(CONFIG_LBT_RSSI_THRESHOLD_DBM, CONFIG_LBT_SENSE_MS)) {
+        backoffs = 0;
+        return true;
+    }
+
+    stats.busy++;
+    if (backoffs >= CONFIG_LBT_MAX_BACKOFFS) {
+        // Bounded so the frame still goes out before the next one is due
+        stats.forced++;
+        backoffs = 0;
+        LOG_DBG("Channel still busy, transmitting anyway");
+        return true;
+    }
+
+    // Binary exponential: a window of one backoff slot, doubling with each busy sense
+    backoffs++;
+    stats.deferred++;
+    const uint32_t windowMs = CONFIG_LBT_BACKOFF_MS << (backoffs - 1);
+    backoff = K_MSEC(CONFIG_LBT_BACKOFF_MS + randomMs(windowMs));
+    LOG_DBG("Channel busy, backoff %u", backoffs);
+    return false;
+}
+
+#ifdef CONFIG_SHELL
+
+static int cmd_lbt(const struct shell *sh, size_t argc, char **argv) {
+    const ChannelAccess* access = ChannelAccess::instance();
+    if (!access) {
+        shell_error(sh, "Transmitter not started");
+        return -ENODEV;
+    }
+
+    const ChannelAccess::Counters& stats = access->counters();
+    shell_print(sh, "Clock: %s", ChannelAccess::synchronized() ? "synchronized, not sensing" : "free running");
+    shell_print(sh, "Sensed: %u, busy: %u, deferred: %u, sent busy: %u", stats.attempts, stats.busy,
+                stats.deferred, stats.forced);
+    return 0;
+}
+
+SHELL_CMD_REGISTER(lbt, NULL, "Show listen-before-talk counters", cmd_lbt);
+
+#endif
+
+#endif
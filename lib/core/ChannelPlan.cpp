@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/ChannelPlan.h"
+
+namespace {
+uint8_t gcd(uint8_t a, uint8_t b) {
+    while (b != 0) {
+        const uint8_t rest = a % b;
+        a = b;
+        b = rest;
+    }
+    return a;
+}
+
+// About half the plan, so consecutive dwells land far apart and a narrowband interferer
+// is not met twice in a row
+uint8_t strideFor(const uint8_t channels) {
+    uint8_t stride = channels / 2 > 0 ? channels / 2 : 1;
+    while (gcd(stride, channels) != 1) {
+        stride++;
+    }
+    return stride;
+}
+}
+
+ChannelPlan::ChannelPlan(const uint32_t baseHz, const uint32_t spacingHz, const uint8_t channels,
+                         const uint16_t dwellFrames)
+    : baseHz(baseHz), spacingHz(spacingHz), dwellFrames(dwellFrames > 0 ? dwellFrames : 1) {
+    count = channels == 0 ? 1 : channels > MAX_CHANNELS ? MAX_CHANNELS : channels;
+    if (spacingHz == 0) {
+        count = 1;
+    }
+    stride = strideFor(count);
+}
+
+bool ChannelPlan::limitTo(const uint32_t maxHz) {
+    const uint8_t before = count;
+    while (count > 1 && frequency(count - 1) > maxHz) {
+        count--;
+    }
+    stride = strideFor(count);
+    return count != before;
+}
+
+uint8_t ChannelPlan::channelFor(const uint32_t frameNumber) const {
+    if (count == 1) {
+        return 0;
+    }
+
+    // Each cycle starts one channel on from the last, so the order differs from cycle to cycle
+    const uint32_t hop = frameNumber / dwellFrames;
+    const uint32_t cycle = hop / count;
+    const uint32_t position = hop % count;
+    return static_cast<uint8_t>((position * stride + cycle) % count);
+}
+
+#if defined(CONFIG_FREQUENCY_HOPPING) && defined(CONFIG_SETTINGS)
+ChannelPlan ChannelPlan::fromSettings(const Settings::Id changed, const uint32_t value) {
+    const auto setting = [changed, value](const Settings::Id id) {
+        return id == changed ? value : Settings::get(id);
+    };
+
+    ChannelPlan plan(setting(Settings::Id::FREQUENCY), setting(Settings::Id::HOP_SPACING),
+                     static_cast<uint8_t>(setting(Settings::Id::HOP_CHANNELS)), CONFIG_HOP_DWELL_FRAMES);
+    plan.limitTo(Settings::describe(Settings::Id::FREQUENCY).max);
+    return plan;
+}
+#endif
@@ -0,0 +1,227 @@
+#include "core/Coordinates.h"
+
+#include <cstdlib>
+
+namespace {
+// cos(d) in Q15 for each whole degree 0 - 90
+constexpr uint16_t cosTable[] = {
+    32767, 32763, 32748, 32723, 32688, 32643, 32588, 32524, 32449, 32365, 32270, 32166, 32052, 31928,
+    31795, 31651, 31499, 31336, 31164, 30983, 30792, 30592, 30382, 30163, 29935, 29698, 29452, 29197,
+    28932, 28660, 28378, 28088, 27789, 27482, 27166, 26842, 26510, 26170, 25822, 25466, 25102, 24730,
+    24351, 23965, 23571, 23170, 22763, 22348, 21926, 21498, 21063, 20622, 20174, 19720, 19261, 18795,
+    18324, 17847, 17364, 16877, 16384, 15886, 15384, 14876, 14365, 13848, 13328, 12803, 12275, 11743,
+    11207, 10668, 10126, 9580,  9032,  8481,  7927,  7371,  6813,  6252,  5690,  5126,  4560,  3993,
+    3425,  2856,  2286,  1715,  1144,  572,   0,
+};
+
+// atan(i / 32) in hundredths of a degree for i = 0 - 32
+constexpr uint16_t atanTable[] = {
+    0,    179,  358,  536,  713,  888,  1062, 1234, 1404, 1571, 1735, 1897, 2056, 2211, 2363, 2511, 2657,
+    2798, 2936, 3070, 3201, 3327, 3451, 3571, 3687, 3800, 3909, 4016, 4119, 4218, 4315, 4409, 4500,
+};
+
+constexpr uint32_t POW10[] = {1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000, 1'000'000'000};
+
+constexpr int32_t MILLIDEG_FULL_TURN = 360'000;
+
+/**
+ * atan of a ratio between 0 and 1
+ * @param ratioQ15 Ratio in Q15
+ * @return Angle in hundredths of a degree, 0 - 4500
+ */
+uint32_t atanRatio(const uint32_t ratioQ15) {
+    // 32 table steps of 1024 in Q15, interpolated linearly
+    const uint32_t index = ratioQ15 >> 10;
+    if (index >= 32) {
+        return atanTable[32];
+    }
+    const uint32_t frac = ratioQ15 & 0x3FF;
+    return atanTable[index] + (((atanTable[index + 1] - atanTable[index]) * frac + 512) >> 10);
+}
+
+// Divide rounding to the nearest integer, for a positive divisor
+int64_t divRound(const int64_t value, const int64_t divisor) {
+    return value >= 0 ? (value + divisor / 2) / divisor : (value - divisor / 2) / divisor;
+}
+
+size_t writeUnsigned(char* out, uint32_t value, const size_t minDigits) {
+    char digits[10];
+    size_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0 || count < minDigits);
+
+    for (size_t i = 0; i < count; i++) {
+        out[i] = digits[count - 1 - i];
+    }
+    return count;
+}
+}
+
+size_t formatFixedPoint(char* out, const int32_t value, const uint8_t decimals, const uint8_t places) {
+    size_t len = 0;
+    // Widen before negating so INT32_MIN does not overflow
+    const uint32_t magnitude =
+        value < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(value)) : static_cast<uint32_t>(value);
+    if (value < 0) {
+        out[len++] = '-';
+    }
+
+    const uint32_t scale = POW10[decimals];
+    len += writeUnsigned(out + len, magnitude / scale, 1);
+
+    if (places > 0) {
+        out[len++] = '.';
+        uint32_t fraction = magnitude % scale;
+        if (places < decimals) {
+            fraction /= POW10[decimals - places];
+            len += writeUnsigned(out + len, fraction, places);
+        } else {
+            len += decimals > 0 ? writeUnsigned(out + len, fraction, decimals) : 0;
+            for (uint8_t i = decimals; i < places; i++) {
+                out[len++] = '0';
+            }
+        }
+    }
+
+    out[len] = '\0';
+    return len;
+}
+
+bool parseFixedPoint(const char* text, const uint8_t decimals, uint32_t& value) {
+    uint64_t result = 0;
+    size_t digits = 0;
+    // Digits after the point, or -1 before it
+    int fractionDigits = -1;
+
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '.' && fractionDigits < 0) {
+            fractionDigits = 0;
+            continue;
+        }
+        if (*c < '0' || *c > '9' || fractionDigits >= decimals) {
+            return false;
+        }
+
+        result = result * 10 + static_cast<uint64_t>(*c - '0');
+        if (result > UINT32_MAX) {
+            return false;
+        }
+        digits++;
+        if (fractionDigits >= 0) {
+            fractionDigits++;
+        }
+    }
+
+    result *= POW10[decimals - (fractionDigits > 0 ? fractionDigits : 0)];
+    if (digits == 0 || result > UINT32_MAX) {
+        return false;
+    }
+
+    value = static_cast<uint32_t>(result);
+    return true;
+}
+
+uint16_t cosLatitudeQ15(const int32_t milliDeg) {
+    const uint32_t magnitude = static_cast<uint32_t>(std::abs(static_cast<int64_t>(milliDeg)));
+    const uint32_t degrees = magnitude / 1000;
+    if (degrees >= 90) {
+        return 0;
+    }
+
+    const uint32_t frac = magnitude % 1000;
+    const int32_t step = static_cast<int32_t>(cosTable[degrees + 1]) - cosTable[degrees];
+    return static_cast<uint16_t>(cosTable[degrees] + step * static_cast<int32_t>(frac) / 1000);
+}
+
+void localOffsetM(const GnssInfo& from, const GnssInfo& to, int32_t& northM, int32_t& eastM) {
+    // In 64 bits so positions from corrupt frames cannot overflow
+    int64_t dLon = static_cast<int64_t>(to.longitude) - from.longitude;
+    if (dLon > MILLIDEG_FULL_TURN / 2) {
+        dLon -= MILLIDEG_FULL_TURN;
+    } else if (dLon < -MILLIDEG_FULL_TURN / 2) {
+        dLon += MILLIDEG_FULL_TURN;
+    }
+
+    // Longitude lines converge at the mean latitude of the two positions
+    const int64_t dLat = static_cast<int64_t>(to.latitude) - from.latitude;
+    const int64_t meanLatitude = from.latitude + dLat / 2;
+    northM = static_cast<int32_t>(dLat * MILLIDEG_LAT_MM / 1000);
+    eastM = static_cast<int32_t>(
+        ((dLon * MILLIDEG_LAT_MM * cosLatitudeQ15(static_cast<int32_t>(meanLatitude))) >> 15) / 1000);
+}
+
+GnssInfo offsetPosition(const GnssInfo& origin, const int32_t northM, const int32_t eastM) {
+    GnssInfo position = origin;
+    const int64_t dLat = divRound(static_cast<int64_t>(northM) * 1000, MILLIDEG_LAT_MM);
+    position.latitude = static_cast<int32_t>(origin.latitude + dLat);
+
+    const int64_t meanLatitude = origin.latitude + dLat / 2;
+    const int64_t cosQ15 = cosLatitudeQ15(static_cast<int32_t>(meanLatitude));
+    if (cosQ15 > 0) {
+        int64_t longitude = origin.longitude + divRound(static_cast<int64_t>(eastM) * 1000 * 32768,
+                                                        MILLIDEG_LAT_MM * cosQ15);
+        if (longitude > MILLIDEG_FULL_TURN / 2) {
+            longitude -= MILLIDEG_FULL_TURN;
+        } else if (longitude < -MILLIDEG_FULL_TURN / 2) {
+            longitude += MILLIDEG_FULL_TURN;
+        }
+        position.longitude = static_cast<int32_t>(longitude);
+    }
+    return position;
+}
+
+uint32_t distanceM(const GnssInfo& from, const GnssInfo& to) {
+    int32_t north = 0;
+    int32_t east = 0;
+    localOffsetM(from, to, north, east);
+    return isqrt64(static_cast<uint64_t>(static_cast<int64_t>(north) * north) +
+                   static_cast<uint64_t>(static_cast<int64_t>(east) * east));
+}
+
+uint16_t bearingDeciDeg(const GnssInfo& from, const GnssInfo& to) {
+    int32_t north = 0;
+    int32_t east = 0;
+    localOffsetM(from, to, north, east);
+    return static_cast<uint16_t>(((atan2CentiDeg(north, east) + 5U) / 10U) % 3600U);
+}
+
+uint16_t atan2CentiDeg(const int32_t north, const int32_t east) {
+    const uint32_t n = static_cast<uint32_t>(std::abs(static_cast<int64_t>(north)));
+    const uint32_t e = static_cast<uint32_t>(std::abs(static_cast<int64_t>(east)));
+    if (n == 0 && e == 0) {
+        return 0;
+    }
+
+    // Angle from the north axis in the first quadrant, folded about 45 degrees
+    const uint32_t angle = e <= n ? atanRatio(static_cast<uint32_t>((static_cast<uint64_t>(e) << 15) / n))
+                                  : 9000 - atanRatio(static_cast<uint32_t>((static_cast<uint64_t>(n) << 15) / e));
+
+    uint32_t bearing;
+    if (north >= 0) {
+        bearing = east >= 0 ? angle : 36000 - angle;
+    } else {
+        bearing = east >= 0 ? 18000 - angle : 18000 + angle;
+    }
+    return static_cast<uint16_t>(bearing % 36000);
+}
+
+uint32_t isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return static_cast<uint32_t>(root);
+}
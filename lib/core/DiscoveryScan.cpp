@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/DiscoveryScan.h"
+
+#ifdef CONFIG_DISCOVERY_SCAN
+
+#include <zephyr/logging/log.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "core/Coordinates.h"
+#include "core/LoraTransceiver.h"
+#include "core/defs.h"
+
+LOG_MODULE_REGISTER(discovery_scan);
+
+namespace {
+constexpr uint32_t START_HZ = CONFIG_DISCOVERY_START_KHZ * 1000U;
+constexpr uint32_t STOP_HZ = CONFIG_DISCOVERY_STOP_KHZ * 1000U;
+constexpr uint32_t STEP_HZ = CONFIG_DISCOVERY_STEP_KHZ * 1000U;
+
+// Node IDs heard on a channel as a space separated list
+void formatNodes(char* out, const size_t outSize, const uint16_t nodes) {
+    size_t length = 0;
+    out[0] = '\0';
+    for (uint8_t nodeId = 0; nodeId <= MAX_NODE_ID && length + 3 < outSize; nodeId++) {
+        if (nodes & BIT(nodeId)) {
+            length += snprintk(out + length, outSize - length, length > 0 ? " %u" : "%u", nodeId);
+        }
+    }
+}
+}
+
+DiscoveryScan* DiscoveryScan::shellInstance = nullptr;
+
+DiscoveryScan::DiscoveryScan(LoraTransceiver& lora) : lora(lora) {
+    stepWork.owner = this;
+    k_work_init_delayable(&stepWork.work, stepWorkHandler);
+    shellInstance = this;
+}
+
+bool DiscoveryScan::start() {
+    if (running()) {
+        return false;
+    }
+
+    LOG_INF("Discovery: sweeping %u-%u kHz in %u kHz steps", CONFIG_DISCOVERY_START_KHZ,
+            CONFIG_DISCOVERY_STOP_KHZ, CONFIG_DISCOVERY_STEP_KHZ);
+    homeHz = lora.frequency();
+    found = 0;
+    sweeps = 0;
+    frequencyHz = START_HZ;
+    senseStartMs = k_uptime_get_32();
+    phase = Phase::SENSING;
+
+    // Sensing needs the modem out of LoRa reception
+    lora.awaitCancel();
+    k_work_schedule(&stepWork.work, K_NO_WAIT);
+    return true;
+}
+
+void DiscoveryScan::stepWorkHandler(k_work* work) {
+    auto* delayable = k_work_delayable_from_work(work);
+    CONTAINER_OF(delayable, StepWork, work)->owner->step();
+}
+
+void DiscoveryScan::step() {
+    if (phase == Phase::SENSING) {
+        sense();
+    } else if (phase == Phase::LISTENING) {
+        listen();
+    }
+}
+
+void DiscoveryScan::sense() {
+    // One channel per run, so the rest of the work queue keeps going through a sweep
+    lora.setFrequency(frequencyHz);
+    if (!lora.isChannelClear(CONFIG_DISCOVERY_RSSI_THRESHOLD_DBM, CONFIG_DISCOVERY_SENSE_MS)) {
+        noteEnergy(frequencyHz);
+    }
+
+    frequencyHz += STEP_HZ;
+    if (frequencyHz <= STOP_HZ) {
+        k_work_schedule(&stepWork.work, K_NO_WAIT);
+        return;
+    }
+
+    // Whole sweeps only, so every channel had the same chance
+    sweeps++;
+    frequencyHz = START_HZ;
+    if (found > 0) {
+        LOG_INF("Discovery: signal on %u channels after %u sweeps, listening", found, sweeps);
+        phase = Phase::LISTENING;
+        listenOn(0);
+    } else if (k_uptime_get_32() - senseStartMs >= CONFIG_DISCOVERY_SENSE_S * 1000U) {
+        finish();
+    } else {
+        k_work_schedule(&stepWork.work, K_NO_WAIT);
+    }
+}
+
+void DiscoveryScan::noteEnergy(const uint32_t frequencyHz) {
+    for (size_t i = 0; i < found; i++) {
+        if (candidates[i].frequencyHz == frequencyHz) {
+            candidates[i].energyHits++;
+            return;
+        }
+    }
+
+    if (found < MAX_CHANNELS) {
+        candidates[found++] = {frequencyHz, 1, 0, 0, INT16_MIN};
+    }
+}
+
+void DiscoveryScan::listenOn(const size_t index) {
+    current = index;
+    lora.awaitCancel();
+    lora.setFrequency(candidates[index].frequencyHz);
+    lora.awaitRxPacket();
+    k_work_schedule(&stepWork.work, K_MSEC(CONFIG_DISCOVERY_LISTEN_MS));
+}
+
+void DiscoveryScan::listen() {
+    if (current + 1 < found) {
+        listenOn(current + 1);
+    } else {
+        finish();
+    }
+}
+
+void DiscoveryScan::onFrame(const uint32_t frequencyHz, const uint8_t nodeId, const int16_t rssi) {
+    // The receive callback runs on the system work queue like the sweep, so nothing to lock
+    if (phase != Phase::LISTENING) {
+        return;
+    }
+
+    for (size_t i = 0; i < found; i++) {
+        Channel& channel = candidates[i];
+        if (channel.frequencyHz == frequencyHz) {
+            channel.frames++;
+            channel.nodes |= BIT(nodeId);
+            channel.bestRssi = MAX(channel.bestRssi, rssi);
+            return;
+        }
+    }
+}
+
+void DiscoveryScan::finish() {
+    const Channel* best = nullptr;
+    char frequency[FIXED_POINT_TEXT_SIZE];
+    char nodes[2 * (MAX_NODE_ID + 1)];
+
+    for (size_t i = 0; i < found; i++) {
+        const Channel& channel = candidates[i];
+        formatFixedPoint(frequency, static_cast<int32_t>(channel.frequencyHz), 6, 6);
+        if (channel.frames == 0) {
+            LOG_INF("Discovery: %s MHz, signal in %u sweeps, no frames", frequency, channel.energyHits);
+            continue;
+        }
+
+        formatNodes(nodes, sizeof(nodes), channel.nodes);
+        LOG_INF("Discovery: %s MHz, %u frames, best %d dBm, nodes %s", frequency, channel.frames,
+                channel.bestRssi, nodes);
+        if (!best || channel.frames > best->frames ||
+            (channel.frames == best->frames && channel.bestRssi > best->bestRssi)) {
+            best = &channel;
+        }
+    }
+
+    const uint32_t receiveHz = best ? best->frequencyHz : homeHz;
+    formatFixedPoint(frequency, static_cast<int32_t>(receiveHz), 6, 6);
+    if (best) {
+        LOG_INF("Discovery: receiving on %s MHz", frequency);
+    } else {
+        LOG_INF("Discovery: no trackers found, back on %s MHz", frequency);
+    }
+
+    phase = Phase::IDLE;
+    lora.awaitCancel();
+    lora.setFrequency(receiveHz);
+    lora.awaitRxPacket();
+}
+
+#ifdef CONFIG_SHELL
+
+static int cmd_discover(const struct shell *sh, size_t argc, char **argv) {
+    DiscoveryScan* discovery = DiscoveryScan::instance();
+    if (!discovery) {
+        shell_error(sh, "Receiver not started");
+        return -ENODEV;
+    }
+
+    if (!discovery->start()) {
+        shell_error(sh, "Discovery already running");
+        return -EBUSY;
+    }
+    shell_print(sh, "Discovery started, results are logged");
+    return 0;
+}
+
+SHELL_CMD_REGISTER(discover, NULL, "Sweep for trackers on other frequencies", cmd_discover);
+
+#endif
+
+#endif
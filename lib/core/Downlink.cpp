@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/Downlink.h"
+
+#ifdef CONFIG_DOWNLINK
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <zephyr/logging/log.h>
+#include <zephyr/random/random.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#ifdef CONFIG_DOWNLINK_CONSOLE
+#include <zephyr/console/console.h>
+#include <zephyr/sys/printk.h>
+#endif
+
+#include "core/LoraTransceiver.h"
+
+LOG_MODULE_REGISTER(downlink);
+
+DownlinkScheduler* DownlinkScheduler::shellInstance = nullptr;
+
+DownlinkScheduler::DownlinkScheduler(LoraTransceiver& lora) : lora(lora) {
+    // Trackers remember the last command they handled across a hunter reboot, so don't start
+    // the IDs where the last boot did
+    nextCommandId = static_cast<uint8_t>(sys_rand32_get() % UINT8_MAX + 1);
+    sendWork.owner = this;
+    k_work_init(&sendWork.work, sendWorkHandler);
+    shellInstance = this;
+}
+
+int DownlinkScheduler::queue(const uint8_t target, const CommandOpcode opcode, const uint32_t value) {
+    if (target > MAX_NODE_ID && target != BROADCAST_NODE_ID) {
+        return -EINVAL;
+    }
+    // Every tracker would end up with the same ID
+    if (target == BROADCAST_NODE_ID && opcode == CommandOpcode::SET_NODE_ID) {
+        return -EINVAL;
+    }
+
+    // pick() and onAck() read the entries from the receive callback
+    Entry& entry = entries[target == BROADCAST_NODE_ID ? BROADCAST_ENTRY : target];
+    const unsigned int key = irq_lock();
+    const uint8_t id = nextCommandId;
+    // Zero is left unused so a tracker that has never been commanded cannot match an ID
+    nextCommandId = nextCommandId == UINT8_MAX ? 1 : nextCommandId + 1;
+    entry.command = CommandFrame{};
+    entry.command.target_node = target;
+    entry.command.command_id = id;
+    entry.command.opcode = static_cast<uint8_t>(opcode);
+    entry.command.value = value;
+    entry.ackedMask = 0;
+    memset(entry.attempts, 0, sizeof(entry.attempts));
+    entry.pending = true;
+    irq_unlock(key);
+
+    return id;
+}
+
+DownlinkScheduler::Entry* DownlinkScheduler::pick(const uint8_t nodeId) {
+    Entry* entry = &entries[nodeId];
+    const bool broadcast = !entry->pending;
+    if (broadcast) {
+        entry = &entries[BROADCAST_ENTRY];
+        if (!entry->pending || (entry->ackedMask & (1U << nodeId)) != 0) {
+            return nullptr;
+        }
+    }
+
+    uint8_t& attempts = entry->attempts[nodeId];
+    if (attempts >= CONFIG_DOWNLINK_MAX_ATTEMPTS) {
+        if (!broadcast) {
+            LOG_WRN("Command %u to node %u not acknowledged, dropped", entry->command.command_id, nodeId);
+            entry->pending = false;
+        } else {
+            retireBroadcast();
+        }
+        return nullptr;
+    }
+
+    attempts++;
+    return entry;
+}
+
+void DownlinkScheduler::retireBroadcast() {
+    Entry& entry = entries[BROADCAST_ENTRY];
+    if (!entry.pending || heardMask == 0) {
+        return;
+    }
+
+    uint16_t unackedMask = 0;
+    for (uint8_t id = 0; id <= MAX_NODE_ID; id++) {
+        const uint16_t bit = 1U << id;
+        if ((heardMask & bit) == 0 || (entry.ackedMask & bit) != 0) {
+            continue;
+        }
+        if (entry.attempts[id] < CONFIG_DOWNLINK_MAX_ATTEMPTS) {
+            return;
+        }
+        unackedMask |= bit;
+    }
+
+    if (unackedMask != 0) {
+        LOG_WRN("Command %u to all not acknowledged by nodes 0x%03x, dropped", entry.command.command_id,
+                unackedMask);
+    }
+    entry.pending = false;
+}
+
+void DownlinkScheduler::onUplink(const uint8_t nodeId) {
+    if (nodeId > MAX_NODE_ID) {
+        return;
+    }
+    heardMask |= 1U << nodeId;
+    if (k_work_is_pending(&sendWork.work)) {
+        return;
+    }
+
+    const Entry* entry = pick(nodeId);
+    if (!entry) {
+        return;
+    }
+
+    // The tracker only listens briefly after its transmission, so answer straight away
+    outgoing = entry->command;
+    k_work_submit(&sendWork.work);
+}
+
+void DownlinkScheduler::onAck(const CommandAckFrame& ack) {
+    if (ack.node_id > MAX_NODE_ID) {
+        return;
+    }
+
+    for (Entry& entry : entries) {
+        if (!entry.pending || entry.command.command_id != ack.command_id) {
+            continue;
+        }
+
+        if (entry.command.target_node == BROADCAST_NODE_ID) {
+            entry.ackedMask |= 1U << ack.node_id;
+        } else {
+            entry.pending = false;
+        }
+    }
+    retireBroadcast();
+}
+
+void DownlinkScheduler::sendWorkHandler(k_work* work) {
+    CONTAINER_OF(work, SendWork, work)->owner->send();
+}
+
+void DownlinkScheduler::txDoneCallback(void* userData) {
+    auto* scheduler = static_cast<DownlinkScheduler*>(userData);
+    scheduler->lora.setTxDoneHandler(nullptr, nullptr);
+    scheduler->lora.setRx();
+    scheduler->lora.awaitRxPacket();
+}
+
+void DownlinkScheduler::send() {
+    lora.awaitCancel();
+    lora.setTx();
+    lora.setTxDoneHandler(txDoneCallback, this);
+
+    if (!lora.txCommand(outgoing)) {
+        txDoneCallback(this);
+    }
+}
+
+#if defined(CONFIG_SHELL) || defined(CONFIG_DOWNLINK_CONSOLE)
+
+struct CommandName {
+    const char* name;
+    CommandOpcode opcode;
+};
+
+static constexpr CommandName commandNames[] = {
+    {"period", CommandOpcode::SET_TX_PERIOD},
+    {"sf", CommandOpcode::SET_DATARATE},
+    {"power", CommandOpcode::SET_TX_POWER},
+    {"freq", CommandOpcode::SET_FREQUENCY},
+    {"nodeid", CommandOpcode::SET_NODE_ID},
+};
+
+int DownlinkScheduler::queueText(const char* node, const char* setting, const char* value, char* message,
+                                 const size_t messageSize) {
+    uint8_t target = BROADCAST_NODE_ID;
+    if (strcmp(node, "all") != 0) {
+        char *end;
+        const unsigned long id = strtoul(node, &end, 10);
+        if (*end != '\0' || id > MAX_NODE_ID) {
+            snprintf(message, messageSize, "Invalid node '%s' (expected 0-%u or all)", node, MAX_NODE_ID);
+            return -EINVAL;
+        }
+        target = static_cast<uint8_t>(id);
+    }
+
+    const CommandName* command = nullptr;
+    for (const CommandName& candidate : commandNames) {
+        if (strcmp(setting, candidate.name) == 0) {
+            command = &candidate;
+        }
+    }
+    if (!command) {
+        snprintf(message, messageSize, "Unknown setting '%s' (period, sf, power, freq or nodeid)", setting);
+        return -EINVAL;
+    }
+    if (target == BROADCAST_NODE_ID && command->opcode == CommandOpcode::SET_NODE_ID) {
+        snprintf(message, messageSize, "The node ID can only be set on one node at a time");
+        return -EINVAL;
+    }
+
+    char *end;
+    const unsigned long parsed = strtoul(value, &end, 10);
+    if (*end != '\0') {
+        snprintf(message, messageSize, "Invalid value '%s'", value);
+        return -EINVAL;
+    }
+
+    // Trackers validate the value themselves and acknowledge with a status
+    const int id = queue(target, command->opcode, static_cast<uint32_t>(parsed));
+    if (id < 0) {
+        snprintf(message, messageSize, "Queue failed: %d", id);
+        return id;
+    }
+
+    snprintf(message, messageSize, "Command %d queued, sent after the next frame from %s", id, node);
+    return id;
+}
+
+#endif
+
+#ifdef CONFIG_DOWNLINK_CONSOLE
+void DownlinkScheduler::runConsole() {
+    console_getline_init();
+
+    while (true) {
+        char* line = console_getline();
+        char* save = nullptr;
+        const char* words[4] = {};
+        size_t count = 0;
+        for (char* word = strtok_r(line, " ", &save); word; word = strtok_r(nullptr, " ", &save)) {
+            if (count < ARRAY_SIZE(words)) {
+                words[count] = word;
+            }
+            count++;
+        }
+
+        if (count == 0) {
+            continue;
+        }
+        if (count != ARRAY_SIZE(words) || strcmp(words[0], "cmd") != 0) {
+            printk("Usage: cmd <node|all> <period|sf|power|freq|nodeid> <value>\n");
+            continue;
+        }
+
+        char message[80];
+        queueText(words[1], words[2], words[3], message, sizeof(message));
+        printk("%s\n", message);
+    }
+}
+#endif
+
+#ifdef CONFIG_SHELL
+
+static int cmd_downlink(const struct shell *sh, size_t argc, char **argv) {
+    DownlinkScheduler* scheduler = DownlinkScheduler::instance();
+    if (!scheduler) {
+        shell_error(sh, "Downlink not started");
+        return -ENODEV;
+    }
+
+    char message[80];
+    const int id = scheduler->queueText(argv[1], argv[2], argv[3], message, sizeof(message));
+    if (id < 0) {
+        shell_error(sh, "%s", message);
+        return id;
+    }
+
+    shell_print(sh, "%s", message);
+    return 0;
+}
+
+SHELL_CMD_ARG_REGISTER(cmd, NULL,
+                       "Send a setting to a tracker <node|all> <period|sf|power|freq|nodeid> <value>\n"
+                       "period in ms, power in dBm, freq in Hz",
+                       cmd_downlink, 4, 0);
+
+#endif
+
+#endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/EnergyModel.h"
+
+#ifdef CONFIG_ENERGY_MODEL
+
+#include <cstdlib>
+
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(energy, LOG_LEVEL_INF);
+
+namespace {
+using State = EnergyModel::State;
+using Component = EnergyModel::Component;
+
+constexpr const char* componentNames[EnergyModel::COMPONENT_COUNT] = {"Radio", "GNSS", "MCU"};
+constexpr const char* stateNames[EnergyModel::STATE_COUNT] = {
+    "sleep", "RX", "TX", "off", "acquiring", "tracking", "idle", "active",
+};
+
+// 1 uAh is 3600 s of 1 uA
+constexpr uint64_t uaUsPerUah = 3'600'000'000ULL;
+
+constexpr size_t REPORT_LINES = 2 + EnergyModel::COMPONENT_COUNT;
+constexpr size_t LINE_LEN = 96;
+
+uint16_t permille(const uint64_t part, const uint64_t whole) {
+    if (whole == 0) {
+        return 0;
+    }
+    return static_cast<uint16_t>(MIN(part * 1000U / whole, 1000U));
+}
+
+/**
+ * Format totals as report lines, shared by the periodic log and the shell
+ * @return Number of lines filled
+ */
+size_t formatReport(const EnergyModel::Totals& totals, const uint32_t batteryMah, char (*lines)[LINE_LEN]) {
+    uint64_t chargeUaUs = 0;
+    for (const uint64_t charge : totals.chargeUaUs) {
+        chargeUaUs += charge;
+    }
+    const auto usedUah = static_cast<uint32_t>(chargeUaUs / uaUsPerUah);
+    const auto averageUa =
+        static_cast<uint32_t>(totals.elapsedUs == 0 ? 0 : chargeUaUs / totals.elapsedUs);
+
+    size_t count = 0;
+    snprintk(lines[count++], LINE_LEN, "Energy over %u s: %u.%03u mAh, average %u uA",
+             static_cast<uint32_t>(totals.elapsedUs / 1'000'000U), usedUah / 1000U, usedUah % 1000U, averageUa);
+
+    if (averageUa == 0) {
+        snprintk(lines[count++], LINE_LEN, "Battery %u mAh: no draw measured yet", batteryMah);
+    } else {
+        const uint64_t batteryUah = batteryMah * 1000ULL;
+        const uint64_t leftUah = batteryUah > usedUah ? batteryUah - usedUah : 0;
+        const auto leftMin = static_cast<uint32_t>(leftUah * 60U / averageUa);
+        snprintk(lines[count++], LINE_LEN, "Battery %u mAh: %u h at this rate, %u h %02u min left", batteryMah,
+                 static_cast<uint32_t>(batteryUah / averageUa), leftMin / 60U, leftMin % 60U);
+    }
+
+    for (size_t component = 0; component < EnergyModel::COMPONENT_COUNT; component++) {
+        uint64_t componentTimeUs = 0;
+        uint64_t componentUaUs = 0;
+        for (size_t state = 0; state < EnergyModel::STATE_COUNT; state++) {
+            if (static_cast<size_t>(EnergyModel::componentOf(static_cast<State>(state))) == component) {
+                componentTimeUs += totals.timeUs[state];
+                componentUaUs += totals.chargeUaUs[state];
+            }
+        }
+
+        const auto componentUah = static_cast<uint32_t>(componentUaUs / uaUsPerUah);
+        char* line = lines[count++];
+        int len = snprintk(line, LINE_LEN, "  %-5s %4u.%03u mAh,", componentNames[component], componentUah / 1000U,
+                           componentUah % 1000U);
+        for (size_t state = 0; state < EnergyModel::STATE_COUNT && len > 0 && len < static_cast<int>(LINE_LEN);
+             state++) {
+            if (static_cast<size_t>(EnergyModel::componentOf(static_cast<State>(state))) != component) {
+                continue;
+            }
+            const uint16_t share = permille(totals.timeUs[state], componentTimeUs);
+            len += snprintk(line + len, LINE_LEN - len, " %s %u.%u%%", stateNames[state], share / 10U, share % 10U);
+        }
+    }
+    return count;
+}
+}
+
+EnergyModel& EnergyModel::instance() {
+    static EnergyModel model;
+    return model;
+}
+
+EnergyModel::EnergyModel() {
+    current[static_cast<size_t>(Component::RADIO)] = State::RADIO_SLEEP;
+    current[static_cast<size_t>(Component::GNSS)] = State::GNSS_OFF;
+    current[static_cast<size_t>(Component::MCU)] = State::MCU_ACTIVE;
+}
+
+EnergyModel::Component EnergyModel::componentOf(const State state) {
+    switch (state) {
+    case State::RADIO_SLEEP:
+    case State::RADIO_RX:
+    case State::RADIO_TX:
+        return Component::RADIO;
+    case State::GNSS_OFF:
+    case State::GNSS_ACQUIRING:
+    case State::GNSS_TRACKING:
+        return Component::GNSS;
+    default:
+        return Component::MCU;
+    }
+}
+
+uint32_t EnergyModel::currentUa(const State state) {
+    switch (state) {
+    case State::RADIO_SLEEP:
+        return CONFIG_ENERGY_RADIO_SLEEP_UA;
+    case State::RADIO_RX:
+        return CONFIG_ENERGY_RADIO_RX_UA;
+    case State::RADIO_TX:
+        return CONFIG_ENERGY_RADIO_TX_20DBM_UA;
+    case State::GNSS_ACQUIRING:
+        return CONFIG_ENERGY_GNSS_ACQUIRING_UA;
+    case State::GNSS_TRACKING:
+        return CONFIG_ENERGY_GNSS_TRACKING_UA;
+    case State::MCU_IDLE:
+        return CONFIG_ENERGY_MCU_IDLE_UA;
+    case State::MCU_ACTIVE:
+        return CONFIG_ENERGY_MCU_ACTIVE_UA;
+    default:
+        return 0;
+    }
+}
+
+uint32_t EnergyModel::txCurrentUa(const int8_t powerDbm) {
+    constexpr int32_t lowUa = CONFIG_ENERGY_RADIO_TX_2DBM_UA;
+    constexpr int32_t highUa = CONFIG_ENERGY_RADIO_TX_20DBM_UA;
+    const int32_t dbm = CLAMP(powerDbm, 2, 20);
+    return static_cast<uint32_t>(lowUa + (highUa - lowUa) * (dbm - 2) / 18);
+}
+
+void EnergyModel::add(const State state, const uint64_t us, const uint32_t currentUa) {
+    const auto index = static_cast<size_t>(state);
+    totals.timeUs[index] += us;
+    totals.chargeUaUs[index] += us * currentUa;
+}
+
+void EnergyModel::accumulate(const int64_t nowTicks) {
+    // The MCU's time comes from the scheduler instead, in snapshot()
+    for (size_t index = 0; index < static_cast<size_t>(Component::MCU); index++) {
+        if (nowTicks > sinceTicks[index]) {
+            add(current[index], k_ticks_to_us_floor64(static_cast<uint64_t>(nowTicks - sinceTicks[index])),
+                currentUa(current[index]));
+            sinceTicks[index] = nowTicks;
+        }
+    }
+    totals.elapsedUs = k_ticks_to_us_floor64(static_cast<uint64_t>(nowTicks - startTicks));
+}
+
+void EnergyModel::enter(const State state) {
+    const auto index = static_cast<size_t>(componentOf(state));
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    accumulate(k_uptime_ticks());
+    current[index] = state;
+    k_spin_unlock(&lock, key);
+}
+
+void EnergyModel::radioTx(const uint32_t airtimeUs, const int8_t powerDbm) {
+    const auto index = static_cast<size_t>(Component::RADIO);
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    const int64_t now = k_uptime_ticks();
+    accumulate(now);
+    add(State::RADIO_TX, airtimeUs, txCurrentUa(powerDbm));
+    // The modem sleeps after TxDone, the frame's airtime is already accounted
+    current[index] = State::RADIO_SLEEP;
+    sinceTicks[index] = now + static_cast<int64_t>(k_us_to_ticks_near64(airtimeUs));
+    k_spin_unlock(&lock, key);
+}
+
+void EnergyModel::snapshot(Totals& out) {
+    // The scheduler counts cycles in idle and in every other thread, interrupts included
+    k_thread_runtime_stats_t stats{};
+    k_thread_runtime_stats_all_get(&stats);
+
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    accumulate(k_uptime_ticks());
+    add(State::MCU_ACTIVE, k_cyc_to_us_floor64(stats.total_cycles - lastActiveCycles), CONFIG_ENERGY_MCU_ACTIVE_UA);
+    add(State::MCU_IDLE, k_cyc_to_us_floor64(stats.idle_cycles - lastIdleCycles), CONFIG_ENERGY_MCU_IDLE_UA);
+    lastActiveCycles = stats.total_cycles;
+    lastIdleCycles = stats.idle_cycles;
+    out = totals;
+    k_spin_unlock(&lock, key);
+}
+
+void EnergyModel::reset() {
+    k_thread_runtime_stats_t stats{};
+    k_thread_runtime_stats_all_get(&stats);
+
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    const int64_t now = k_uptime_ticks();
+    totals = Totals{};
+    for (int64_t& since : sinceTicks) {
+        // Keep the rest of a transmission on air out of the new totals
+        since = MAX(since, now);
+    }
+    startTicks = now;
+    lastActiveCycles = stats.total_cycles;
+    lastIdleCycles = stats.idle_cycles;
+    k_spin_unlock(&lock, key);
+}
+
+#if CONFIG_ENERGY_REPORT_S > 0
+static void reportWorkHandler(k_work* work);
+
+K_WORK_DELAYABLE_DEFINE(reportWork, reportWorkHandler);
+
+static void reportWorkHandler(k_work* work) {
+    ARG_UNUSED(work);
+
+    EnergyModel& model = EnergyModel::instance();
+    EnergyModel::Totals totals{};
+    model.snapshot(totals);
+
+    char lines[REPORT_LINES][LINE_LEN];
+    const size_t count = formatReport(totals, model.getBatteryMah(), lines);
+    for (size_t i = 0; i < count; i++) {
+        LOG_INF("%s", lines[i]);
+    }
+
+    k_work_schedule(&reportWork, K_SECONDS(CONFIG_ENERGY_REPORT_S));
+}
+
+static int startEnergyReports() {
+    k_work_schedule(&reportWork, K_SECONDS(CONFIG_ENERGY_REPORT_S));
+    return 0;
+}
+
+SYS_INIT(startEnergyReports, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
+
+#ifdef CONFIG_SHELL
+static int cmd_energy_show(const struct shell* sh, size_t argc, char** argv) {
+    EnergyModel& model = EnergyModel::instance();
+    EnergyModel::Totals totals{};
+    model.snapshot(totals);
+
+    char lines[REPORT_LINES][LINE_LEN];
+    const size_t count = formatReport(totals, model.getBatteryMah(), lines);
+    for (size_t i = 0; i < count; i++) {
+        shell_print(sh, "%s", lines[i]);
+    }
+    return 0;
+}
+
+static int cmd_energy_reset(const struct shell* sh, size_t argc, char** argv) {
+    EnergyModel::instance().reset();
+    shell_print(sh, "Energy accounting restarted");
+    return 0;
+}
+
+static int cmd_energy_battery(const struct shell* sh, size_t argc, char** argv) {
+    char* end = nullptr;
+    const unsigned long mah = strtoul(argv[1], &end, 10);
+    if (end == argv[1] || *end != '\0' || mah == 0 || mah > 100'000) {
+        shell_error(sh, "Invalid capacity '%s' (expected 1-100000 mAh)", argv[1]);
+        return -EINVAL;
+    }
+
+    EnergyModel::instance().setBatteryMah(static_cast<uint32_t>(mah));
+    return cmd_energy_show(sh, 1, argv);
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_energy,
+    SHELL_CMD(show, NULL, "Show charge used and projected battery life", cmd_energy_show),
+    SHELL_CMD(reset, NULL, "Start accounting over, e.g. after changing settings", cmd_energy_reset),
+    SHELL_CMD_ARG(battery, NULL, "Project runtime for a battery of <mAh>", cmd_energy_battery, 2, 0),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(energy, &sub_energy, "Energy use per component and battery life", cmd_energy_show);
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/EventTrace.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static constexpr size_t EVENT_COUNT = static_cast<size_t>(TraceEvent::COUNT);
+
+static constexpr const char* EVENT_NAMES[EVENT_COUNT] = {
+    "pps",
+    "radio done",
+    "clock source",
+    "frame",
+    "tx timer",
+    "tx work",
+    "tx key timer",
+    "tx start",
+    "tx done",
+    "rx",
+    "gnss",
+    "state",
+};
+
+static constexpr char HEADER_TAG[] = "HDR";
+
+static int hexValue(const char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+const char* traceEventName(const TraceEvent event) {
+    const auto index = static_cast<size_t>(event);
+    return index < EVENT_COUNT ? EVENT_NAMES[index] : "unknown";
+}
+
+size_t formatTraceHeader(char* out, const TraceHeader& header) {
+    const int len = snprintf(out, EVENT_TRACE_LINE_SIZE, "%s %s %" PRIu32 " %" PRIu32 " %" PRIu32, EVENT_TRACE_PREFIX,
+                             HEADER_TAG, header.cycleHz, header.entries, header.overwritten);
+    return len < 0 ? 0 : static_cast<size_t>(len);
+}
+
+size_t formatTraceEntries(char* out, const TraceEntry* entries, const size_t count) {
+    static constexpr char digits[] = "0123456789abcdef";
+
+    size_t pos = strlen(EVENT_TRACE_PREFIX);
+    memcpy(out, EVENT_TRACE_PREFIX, pos);
+    out[pos++] = ' ';
+
+    for (size_t i = 0; i < count && i < EVENT_TRACE_LINE_ENTRIES; i++) {
+        // Little endian, whatever the host
+        const TraceEntry& entry = entries[i];
+        const uint8_t bytes[EVENT_TRACE_ENTRY_SIZE] = {
+            static_cast<uint8_t>(entry.cycles),       static_cast<uint8_t>(entry.cycles >> 8),
+            static_cast<uint8_t>(entry.cycles >> 16), static_cast<uint8_t>(entry.cycles >> 24),
+            static_cast<uint8_t>(entry.arg),          static_cast<uint8_t>(entry.arg >> 8),
+            static_cast<uint8_t>(entry.event),        entry.flags,
+        };
+        for (const uint8_t byte : bytes) {
+            out[pos++] = digits[byte >> 4];
+            out[pos++] = digits[byte & 0x0F];
+        }
+    }
+    out[pos] = '\0';
+
+    return pos;
+}
+
+bool parseTraceHeader(const char* line, TraceHeader& header) {
+    const size_t prefixLen = strlen(EVENT_TRACE_PREFIX);
+    const size_t tagLen = strlen(HEADER_TAG);
+    if (strncmp(line, EVENT_TRACE_PREFIX, prefixLen) != 0 || line[prefixLen] != ' ' ||
+        strncmp(line + prefixLen + 1, HEADER_TAG, tagLen) != 0) {
+        return false;
+    }
+
+    const char* pos = line + prefixLen + 1 + tagLen;
+    uint32_t values[3] = {};
+    for (uint32_t& value : values) {
+        char* end = nullptr;
+        const unsigned long parsed = strtoul(pos, &end, 10);
+        if (end == pos || parsed > UINT32_MAX) {
+            return false;
+        }
+        value = static_cast<uint32_t>(parsed);
+        pos = end;
+    }
+
+    header.cycleHz = values[0];
+    header.entries = values[1];
+    header.overwritten = values[2];
+    return header.cycleHz != 0;
+}
+
+size_t parseTraceEntries(const char* line, TraceEntry* entries) {
+    const size_t prefixLen = strlen(EVENT_TRACE_PREFIX);
+    if (strncmp(line, EVENT_TRACE_PREFIX, prefixLen) != 0 || line[prefixLen] != ' ') {
+        return 0;
+    }
+
+    const char* pos = line + prefixLen + 1;
+    size_t count = 0;
+    while (pos[0] != '\0' && pos[0] != '\r' && pos[0] != '\n') {
+        if (count >= EVENT_TRACE_LINE_ENTRIES) {
+            return 0;
+        }
+
+        uint8_t bytes[EVENT_TRACE_ENTRY_SIZE];
+        for (uint8_t& byte : bytes) {
+            const int high = hexValue(pos[0]);
+            const int low = high < 0 ? -1 : hexValue(pos[1]);
+            if (low < 0) {
+                return 0;
+            }
+            byte = static_cast<uint8_t>((high << 4) | low);
+            pos += 2;
+        }
+
+        TraceEntry& entry = entries[count++];
+        entry.cycles = static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+                       static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+        entry.arg = static_cast<uint16_t>(bytes[4] | bytes[5] << 8);
+        entry.event = static_cast<TraceEvent>(bytes[6]);
+        entry.flags = bytes[7];
+    }
+
+    return count;
+}
+
+#ifdef CONFIG_EVENT_TRACE
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+static constexpr uint32_t ENTRY_COUNT = CONFIG_EVENT_TRACE_ENTRIES;
+static_assert((ENTRY_COUNT & (ENTRY_COUNT - 1)) == 0, "CONFIG_EVENT_TRACE_ENTRIES must be a power of two");
+
+// Written with interrupts locked
+static TraceEntry traceEntries[ENTRY_COUNT];
+// Events recorded since the last clear, the next one goes in traceEntries[traceHead % ENTRY_COUNT]
+static uint32_t traceHead;
+static bool traceRecording = true;
+
+void traceEvent(const TraceEvent event, const uint16_t arg) {
+    const uint8_t flags = k_is_in_isr() ? TRACE_FLAG_ISR : 0;
+    const unsigned int key = irq_lock();
+    if (traceRecording) {
+        traceEntries[traceHead & (ENTRY_COUNT - 1)] = TraceEntry{k_cycle_get_32(), arg, event, flags};
+        traceHead++;
+    }
+    irq_unlock(key);
+}
+
+void eventTraceDump() {
+    // Only ever called from the shell, so the line can be shared
+    static char line[EVENT_TRACE_LINE_SIZE];
+
+    // Keep the entries still while they are printed, printing records events of its own
+    unsigned int key = irq_lock();
+    const bool wasRecording = traceRecording;
+    traceRecording = false;
+    const uint32_t total = traceHead;
+    irq_unlock(key);
+
+    const uint32_t count = MIN(total, ENTRY_COUNT);
+    const uint32_t first = total - count;
+    const TraceHeader header{static_cast<uint32_t>(sys_clock_hw_cycles_per_sec()), count, first};
+    if (formatTraceHeader(line, header) > 0) {
+        printk("%s\n", line);
+    }
+
+    TraceEntry chunk[EVENT_TRACE_LINE_ENTRIES];
+    for (uint32_t i = 0; i < count; i += EVENT_TRACE_LINE_ENTRIES) {
+        const size_t chunkCount = MIN(count - i, EVENT_TRACE_LINE_ENTRIES);
+        for (size_t j = 0; j < chunkCount; j++) {
+            chunk[j] = traceEntries[(first + i + j) & (ENTRY_COUNT - 1)];
+        }
+        formatTraceEntries(line, chunk, chunkCount);
+        printk("%s\n", line);
+    }
+
+    key = irq_lock();
+    traceRecording = wasRecording;
+    irq_unlock(key);
+}
+
+#ifdef CONFIG_SHELL
+static void setRecording(const bool recording, const bool clear) {
+    const unsigned int key = irq_lock();
+    traceRecording = recording;
+    if (clear) {
+        traceHead = 0;
+    }
+    irq_unlock(key);
+}
+
+static int cmd_trace_show(const struct shell* sh, size_t argc, char** argv) {
+    const unsigned int key = irq_lock();
+    const uint32_t total = traceHead;
+    const bool recording = traceRecording;
+    irq_unlock(key);
+
+    shell_print(sh, "%u events recorded, %u overwritten, %s", MIN(total, ENTRY_COUNT),
+                total > ENTRY_COUNT ? total - ENTRY_COUNT : 0U, recording ? "recording" : "stopped");
+    return 0;
+}
+
+static int cmd_trace_dump(const struct shell* sh, size_t argc, char** argv) {
+    eventTraceDump();
+    return 0;
+}
+
+static int cmd_trace_start(const struct shell* sh, size_t argc, char** argv) {
+    setRecording(true, false);
+    return 0;
+}
+
+static int cmd_trace_stop(const struct shell* sh, size_t argc, char** argv) {
+    setRecording(false, false);
+    return 0;
+}
+
+static int cmd_trace_clear(const struct shell* sh, size_t argc, char** argv) {
+    setRecording(true, true);
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_trace,
+    SHELL_CMD(show, NULL, "Show how many events are in the buffer", cmd_trace_show),
+    SHELL_CMD(dump, NULL, "Print the buffer as #TRC lines for tools/trace_export", cmd_trace_dump),
+    SHELL_CMD(start, NULL, "Resume recording", cmd_trace_start),
+    SHELL_CMD(stop, NULL, "Stop recording to keep the events leading up to now", cmd_trace_stop),
+    SHELL_CMD(clear, NULL, "Empty the buffer and resume recording", cmd_trace_clear),
+    SHELL_SUBCMD_SET_END);
+
+SHELL_CMD_REGISTER(trace, &sub_trace, "Timestamped event trace", cmd_trace_show);
+#endif
+
+#endif
@@ -0,0 +1,33 @@
+#include "core/FixBatch.h"
+
+#ifdef CONFIG_FIX_BATCHING
+
+void FixBatch::push(const GnssInfo& info) {
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    head = (head + 1) % CAPACITY;
+    samples[head] = info;
+    newestIndex++;
+    if (count < CAPACITY) {
+        count++;
+    }
+    k_spin_unlock(&lock, key);
+}
+
+void FixBatch::clear() {
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    count = 0;
+    k_spin_unlock(&lock, key);
+}
+
+size_t FixBatch::copy(GnssInfo* out, uint16_t& sampleIndex) const {
+    const k_spinlock_key_t key = k_spin_lock(&lock);
+    for (size_t age = 0; age < count; age++) {
+        out[age] = samples[(head + CAPACITY - age) % CAPACITY];
+    }
+    sampleIndex = newestIndex;
+    const size_t copied = count;
+    k_spin_unlock(&lock, key);
+    return copied;
+}
+
+#endif
@@ -0,0 +1,273 @@
+#include "core/FrameCodec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/Coordinates.h"
+
+static int16_t clampDelta(const int32_t delta) {
+    return static_cast<int16_t>(std::clamp<int32_t>(delta, INT16_MIN, INT16_MAX));
+}
+
+/**
+ * Body of a received frame, after any callsign prefix
+ * @param data Raw frame, advanced to the body
+ * @param size Size of the raw frame, reduced to the size of the body
+ */
+static void skipPrefix(const uint8_t*& data, size_t& size) {
+    const size_t prefix = framePrefixSize(data, size);
+    data += prefix;
+    size -= prefix;
+}
+
+template <size_t PrefixSize>
+void FrameEncoder<PrefixSize>::setCallsign(const char* callsign) {
+    if constexpr (PrefixSize > 0) {
+        memset(header, 0, sizeof(header));
+        if (callsign) {
+            memcpy(header, callsign, strnlen(callsign, PrefixSize));
+        }
+    } else {
+        (void)callsign;
+    }
+}
+
+template <size_t PrefixSize>
+bool FrameEncoder<PrefixSize>::hasCallsign() const {
+    return PrefixSize == 0 || header[0] != 0;
+}
+
+template <size_t PrefixSize>
+template <typename Body>
+size_t FrameEncoder<PrefixSize>::write(uint8_t* out, const Body& body) const {
+    if constexpr (PrefixSize > 0) {
+        memcpy(out, header, PrefixSize);
+    }
+    memcpy(out + PrefixSize, &body, sizeof(body));
+    return frameSize<Body>;
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeFix(uint8_t* out, const uint8_t nodeId, const uint8_t seq,
+                                           const GnssInfo& fix) const {
+    LoraFrame frame{};
+    frame.node_id = nodeId;
+    frame.gnssInfo = fix;
+    frame.seq = seq;
+
+    return write(out, frame);
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeTimedFix(uint8_t* out, const uint8_t nodeId, const uint8_t seq,
+                                                const GnssInfo& fix, const uint32_t fixAgeMs) const {
+    TimedFixFrame frame{};
+    frame.node_id = nodeId;
+    frame.seq = seq;
+    frame.fix_age_ms = static_cast<uint16_t>(std::min<uint32_t>(fixAgeMs, UINT16_MAX));
+    frame.fix = fix;
+
+    return write(out, frame);
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeNoFix(uint8_t* out, const uint8_t nodeId, const uint8_t seq) const {
+    NoFixFrame frame{};
+    frame.node_id = nodeId;
+    frame.seq = seq;
+
+    return write(out, frame);
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeFixBatch(uint8_t* out, const FixBatchFrame& header, const GnssInfo* fixes,
+                                                const size_t count) const {
+    if (count == 0 || count > UINT8_MAX) {
+        return 0;
+    }
+
+    FixBatchFrame frame = header;
+    frame.type = static_cast<uint8_t>(FrameType::FIX_BATCH);
+    frame.count = static_cast<uint8_t>(count);
+    frame.newest = fixes[0];
+
+    size_t len = write(out, frame);
+    for (size_t age = 1; age < count; age++) {
+        const FixDelta delta{
+            .latitude = clampDelta(fixes[age].latitude - frame.newest.latitude),
+            .longitude = clampDelta(fixes[age].longitude - frame.newest.longitude),
+        };
+        memcpy(out + len, &delta, sizeof(delta));
+        len += sizeof(delta);
+    }
+
+    return len;
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeRelay(uint8_t* out, const uint8_t relayNodeId, const uint8_t hops,
+                                             const uint8_t* frame, const size_t size) const {
+    if (!frame || size > RELAY_MAX_INNER_SIZE) {
+        return 0;
+    }
+
+    RelayFrame envelope{};
+    envelope.relay_node_id = relayNodeId;
+    envelope.hops = hops;
+
+    const size_t len = write(out, envelope);
+    memcpy(out + len, frame, size);
+    return len + size;
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeCommand(uint8_t* out, const CommandFrame& command) const {
+    CommandFrame frame = command;
+    frame.type = static_cast<uint8_t>(FrameType::COMMAND);
+
+    return write(out, frame);
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeCommandAck(uint8_t* out, const CommandAckFrame& ack) const {
+    CommandAckFrame frame = ack;
+    frame.type = static_cast<uint8_t>(FrameType::COMMAND_ACK);
+
+    return write(out, frame);
+}
+
+template <size_t PrefixSize>
+size_t FrameEncoder<PrefixSize>::encodeBeacon(uint8_t* out, const BeaconFrame& beacon) const {
+    BeaconFrame frame = beacon;
+    frame.type = static_cast<uint8_t>(FrameType::BEACON);
+
+    return write(out, frame);
+}
+
+template class FrameEncoder<0>;
+template class FrameEncoder<CALLSIGN_CHAR_COUNT>;
+
+bool identifyFrame(const uint8_t* data, size_t size, FrameId& id) {
+    if (!data || size == 0) {
+        return false;
+    }
+    skipPrefix(data, size);
+
+    const uint8_t type = data[0];
+    if (type == static_cast<uint8_t>(FrameType::FIX_BATCH)) {
+        if (size < FIX_BATCH_HEADER_SIZE) {
+            return false;
+        }
+        FixBatchFrame frame{};
+        memcpy(&frame, data, sizeof(frame));
+        id = {frame.node_id, frame.seq};
+    } else if (type == static_cast<uint8_t>(FrameType::TIMED_FIX)) {
+        if (size != sizeof(TimedFixFrame)) {
+            return false;
+        }
+        TimedFixFrame frame{};
+        memcpy(&frame, data, sizeof(frame));
+        id = {frame.node_id, frame.seq};
+    } else if (type >= FIRST_TYPED_FRAME) {
+        return false;
+    } else if (size == sizeof(LoraFrame)) {
+        LoraFrame frame{};
+        memcpy(&frame, data, sizeof(frame));
+        id = {frame.node_id, frame.seq};
+    } else if (size == sizeof(NoFixFrame)) {
+        // NOFIX carries the node ID where other frames carry their type
+        id = {data[0], data[size - SEQ_SIZE]};
+    } else {
+        return false;
+    }
+
+    return id.nodeId <= MAX_NODE_ID;
+}
+
+bool decodeTimedFixFrame(const uint8_t* data, size_t size, TimedFixFrame& frame) {
+    skipPrefix(data, size);
+    if (size != sizeof(TimedFixFrame) || data[0] != static_cast<uint8_t>(FrameType::TIMED_FIX)) {
+        return false;
+    }
+
+    memcpy(&frame, data, sizeof(frame));
+    return frame.node_id <= MAX_NODE_ID;
+}
+
+bool decodeFixBatchFrame(const uint8_t* data, size_t size, FixBatchFrame& header, GnssInfo* fixes,
+                         const size_t capacity) {
+    skipPrefix(data, size);
+    if (size < FIX_BATCH_HEADER_SIZE) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+
+    const size_t expected = sizeof(header) + (header.count - 1U) * FIX_DELTA_SIZE;
+    if (header.count == 0 || header.count > capacity || size != expected || header.node_id > MAX_NODE_ID ||
+        !validPosition(header.newest)) {
+        return false;
+    }
+
+    fixes[0] = header.newest;
+    for (size_t age = 1; age < header.count; age++) {
+        FixDelta delta{};
+        memcpy(&delta, data + sizeof(header) + (age - 1) * FIX_DELTA_SIZE, sizeof(delta));
+        // In 64 bits, a corrupt delta can take the position anywhere
+        const int64_t latitude = static_cast<int64_t>(header.newest.latitude) + delta.latitude;
+        const int64_t longitude = static_cast<int64_t>(header.newest.longitude) + delta.longitude;
+        if (!validPosition(latitude, longitude)) {
+            return false;
+        }
+        fixes[age] = header.newest;
+        fixes[age].latitude = static_cast<int32_t>(latitude);
+        fixes[age].longitude = static_cast<int32_t>(longitude);
+    }
+
+    return true;
+}
+
+bool decodeRelayFrame(const uint8_t* data, size_t size, RelayFrame& envelope, const uint8_t*& inner,
+                      size_t& innerSize) {
+    skipPrefix(data, size);
+    if (size <= RELAY_HEADER_SIZE) {
+        return false;
+    }
+    memcpy(&envelope, data, sizeof(envelope));
+
+    inner = data + sizeof(envelope);
+    innerSize = size - sizeof(envelope);
+
+    // The relayed frame keeps the prefix, if any, of the tracker that sent it
+    const size_t innerPrefix = framePrefixSize(inner, innerSize);
+    return innerSize > innerPrefix && inner[innerPrefix] != static_cast<uint8_t>(FrameType::RELAY);
+}
+
+bool decodeCommandFrame(const uint8_t* data, size_t size, CommandFrame& command) {
+    skipPrefix(data, size);
+    if (size != sizeof(CommandFrame) || data[0] != static_cast<uint8_t>(FrameType::COMMAND)) {
+        return false;
+    }
+
+    memcpy(&command, data, sizeof(command));
+    return true;
+}
+
+bool decodeCommandAckFrame(const uint8_t* data, size_t size, CommandAckFrame& ack) {
+    skipPrefix(data, size);
+    if (size != sizeof(CommandAckFrame) || data[0] != static_cast<uint8_t>(FrameType::COMMAND_ACK)) {
+        return false;
+    }
+
+    memcpy(&ack, data, sizeof(ack));
+    return ack.node_id <= MAX_NODE_ID;
+}
+
+bool decodeBeaconFrame(const uint8_t* data, size_t size, BeaconFrame& beacon) {
+    skipPrefix(data, size);
+    if (size != sizeof(BeaconFrame) || data[0] != static_cast<uint8_t>(FrameType::BEACON)) {
+        return false;
+    }
+
+    memcpy(&beacon, data, sizeof(beacon));
+    return true;
+}
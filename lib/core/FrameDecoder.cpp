@@ -0,0 +1,122 @@
+#include "core/FrameDecoder.h"
+
+#include <cstring>
+
+#include "core/FrameCodec.h"
+
+bool FrameDecoder::decode(const uint8_t* data, const size_t size, const int16_t rssi, const int8_t snr,
+                          const uint32_t nowMs) {
+    if (!data || size == 0) {
+        return false;
+    }
+
+    const size_t prefix = framePrefixSize(data, size);
+    const RxInfo rx{size, rssi, snr, prefix > 0 ? reinterpret_cast<const char*>(data) : nullptr};
+    FrameId id{};
+    if (identifyFrame(data, size, id) && !nodes.accept(id, rssi, snr, nowMs)) {
+        return false;
+    }
+
+    const uint8_t* body = data + prefix;
+    const size_t bodySize = size - prefix;
+    if (bodySize > 0 && body[0] >= FIRST_TYPED_FRAME) {
+        switch (static_cast<FrameType>(body[0])) {
+        case FrameType::FIX_BATCH:
+            if (bodySize >= FIX_BATCH_HEADER_SIZE) {
+                decodeFixBatch(data, rx);
+                return true;
+            }
+            break;
+        case FrameType::RELAY:
+            if (bodySize > RELAY_HEADER_SIZE) {
+                decodeRelay(data, rx, nowMs);
+                return true;
+            }
+            break;
+        case FrameType::COMMAND: {
+            CommandFrame command{};
+            if (decodeCommandFrame(data, size, command)) {
+                sink.onCommand(command, rx);
+                return true;
+            }
+            break;
+        }
+        case FrameType::COMMAND_ACK: {
+            CommandAckFrame ack{};
+            if (decodeCommandAckFrame(data, size, ack)) {
+                sink.onCommandAck(ack, rx);
+                return true;
+            }
+            break;
+        }
+        case FrameType::TIMED_FIX: {
+            TimedFixFrame frame{};
+            if (decodeTimedFixFrame(data, size, frame)) {
+                nodes.recordFix(frame.node_id, frame.fix);
+                sink.onTimedFix(frame, rx);
+                return true;
+            }
+            break;
+        }
+        case FrameType::BEACON: {
+            BeaconFrame beacon{};
+            if (decodeBeaconFrame(data, size, beacon)) {
+                sink.onBeacon(beacon, rx);
+                return true;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    switch (bodySize) {
+    case sizeof(LoraFrame): {
+        LoraFrame frame{};
+        memcpy(&frame, body, sizeof(frame));
+        nodes.recordFix(frame.node_id, frame.gnssInfo);
+        sink.onFix(frame, rx);
+        break;
+    }
+    case sizeof(NoFixFrame): {
+        NoFixFrame frame{};
+        memcpy(static_cast<void*>(&frame), body, sizeof(frame));
+        sink.onNoFix(frame, rx);
+        break;
+    }
+    default:
+        sink.onUnknown(data, rx);
+        break;
+    }
+
+    return true;
+}
+
+void FrameDecoder::decodeFixBatch(const uint8_t* data, const RxInfo& rx) {
+    FixBatchFrame header{};
+    GnssInfo fixes[FIX_BATCH_MAX_FIXES];
+    if (!decodeFixBatchFrame(data, rx.size, header, fixes, FIX_BATCH_MAX_FIXES)) {
+        sink.onMalformed(FrameType::FIX_BATCH, header.node_id, rx);
+        return;
+    }
+
+    nodes.recordFix(header.node_id, fixes[0]);
+    for (size_t age = nodes.takeFreshBatchFixes(header); age-- > 0;) {
+        sink.onBatchFix(header, fixes[age], static_cast<uint32_t>(age * header.interval_ds * 100U), rx);
+    }
+}
+
+void FrameDecoder::decodeRelay(const uint8_t* data, const RxInfo& rx, const uint32_t nowMs) {
+    RelayFrame envelope{};
+    const uint8_t* inner = nullptr;
+    size_t innerSize = 0;
+    if (!decodeRelayFrame(data, rx.size, envelope, inner, innerSize)) {
+        sink.onMalformed(FrameType::RELAY, envelope.relay_node_id, rx);
+        return;
+    }
+
+    if (decode(inner, innerSize, rx.rssi, rx.snr, nowMs)) {
+        sink.onRelayed(envelope);
+    }
+}
@@ -3,8 +3,18 @@
 #include <atomic>
 #include <cstring>
 
+#include "core/BootTimeline.h"
+#include "core/Coordinates.h"
+#include "core/EnergyModel.h"
+#include "core/EventTrace.h"
+#include "core/Settings.h"
+#include "core/TimestampService.h"
 #include "zephyr/logging/log.h"
 
+#ifdef CONFIG_GNSS_AIDING
+#include <zephyr/drivers/uart.h>
+#endif
+
 LOG_MODULE_REGISTER(GnssReciever);
 
 static GnssReceiver* receiver = nullptr;
@@ -25,12 +35,138 @@ void gnssCallback(const device* dev, const gnss_data* data) {
 
     receiver->callback(*data);
 }
-GnssReceiver::GnssReceiver() {
 
+#ifdef CONFIG_GNSS_AIDING
+static AidingFix toAidingFix(const gnss_data& data) {
+    return AidingFix{
+        .latitudeE7 = nanoToE7(data.nav_data.latitude),
+        .longitudeE7 = nanoToE7(data.nav_data.longitude),
+        .altitudeCm = data.nav_data.altitude / 10,
+        .year = static_cast<uint16_t>(2000 + data.utc.century_year),
+        .month = data.utc.month,
+        .day = data.utc.month_day,
+        .hour = data.utc.hour,
+        .minute = data.utc.minute,
+        .second = static_cast<uint8_t>(data.utc.millisecond / 1000),
+    };
+}
+#endif
+
+GnssReceiver::GnssReceiver() {
+#ifdef CONFIG_ENERGY_MODEL
+    // The receiver is powered from boot and searches until its first fix
+    EnergyModel::instance().enter(EnergyModel::State::GNSS_ACQUIRING);
+#endif
+#ifdef CONFIG_GNSS_AIDING
+    saveWork.owner = this;
+    k_work_init(&saveWork.work, saveWorkHandler);
+    aidingWork.owner = this;
+    k_work_init(&aidingWork.work, aidingWorkHandler);
+#endif
 }
 
 void GnssReceiver::callback(const gnss_data& data) {
+    traceEvent(TraceEvent::GNSS, data.info.fix_status);
     std::memcpy(&latestData, &data, sizeof(gnss_data));
     const bool has_fix = data.info.fix_status != GNSS_FIX_STATUS_NO_FIX;
     fixAcquired.store(has_fix, std::memory_order_relaxed);
+#ifdef CONFIG_ENERGY_MODEL
+    EnergyModel::instance().enter(has_fix ? EnergyModel::State::GNSS_TRACKING : EnergyModel::State::GNSS_ACQUIRING);
+#endif
+
+#ifdef CONFIG_FIX_AGE
+    // The sentences arrive a few hundred ms after the epoch they describe. The epoch is
+    // on the PPS edge plus the fraction of the second in the UTC time, so when the latest
+    // edge is recent enough to be this epoch's, count back to it instead.
+    latestUptimeMs = k_uptime_get();
+    const TimestampService& timestamps = TimestampService::instance();
+    TimestampService::Capture pps{};
+    if (timestamps.frequency() != 0 && timestamps.lastCapture(TimestampService::Event::PPS, pps)) {
+        const uint32_t sincePpsMs = static_cast<uint32_t>(
+            static_cast<uint64_t>(timestamps.now() - pps.ticks) * 1000U / timestamps.frequency());
+        const uint32_t intoSecondMs = data.utc.millisecond % 1000U;
+        if (sincePpsMs < 1000U && sincePpsMs >= intoSecondMs) {
+            latestUptimeMs -= sincePpsMs - intoSecondMs;
+        }
+    }
+#endif
+
+    if (!has_fix) {
+        return;
+    }
+
+    if (ttffMs == 0) {
+        ttffMs = static_cast<uint32_t>(k_uptime_get());
+        bootMark(BootMilestone::FIRST_FIX);
+        LOG_INF("First fix %u ms after boot (%s)", ttffMs.load(), aided ? "aided" : "unaided");
+    }
+
+#ifdef CONFIG_GNSS_AIDING
+    // Save the first fix of each boot, then throttle to limit flash wear
+    const int64_t now = k_uptime_get();
+    if (!savedThisBoot || now - lastSaveMs >= CONFIG_GNSS_AIDING_SAVE_INTERVAL_S * 1000LL) {
+        if (!k_work_is_pending(&saveWork.work)) {
+            pendingFix = toAidingFix(data);
+            k_work_submit(&saveWork.work);
+        }
+        savedThisBoot = true;
+        lastSaveMs = now;
+    }
+#endif
+}
+
+#ifdef CONFIG_GNSS_AIDING
+void GnssReceiver::saveWorkHandler(k_work* work) {
+    GnssReceiver* gnss = CONTAINER_OF(work, ReceiverWork, work)->owner;
+    Settings::setBytes(Settings::Id::LAST_FIX, &gnss->pendingFix, sizeof(gnss->pendingFix));
+    Settings::commit();
+}
+
+void GnssReceiver::aidingWorkHandler(k_work* work) {
+    GnssReceiver* gnss = CONTAINER_OF(work, ReceiverWork, work)->owner;
+    if (gnss->injectAiding()) {
+        bootMark(BootMilestone::GNSS_AIDED);
+    }
+}
+
+void GnssReceiver::startAiding() {
+    k_work_submit(&aidingWork.work);
+}
+
+bool GnssReceiver::injectAiding() {
+    const device* uart = DEVICE_DT_GET(DT_ALIAS(gnss_uart));
+
+    AidingFix fix{};
+    if (!Settings::getBytes(Settings::Id::LAST_FIX, &fix, sizeof(fix))) {
+        LOG_INF("No saved fix, GNSS starting unaided");
+        return false;
+    }
+
+    if (!device_is_ready(uart)) {
+        LOG_WRN("GNSS UART not ready, cannot send aiding data");
+        return false;
+    }
+
+    // The NMEA driver only receives, so messages to the receiver can be written directly
+    uint8_t message[UBX_MGA_INI_TIME_UTC_SIZE];
+    size_t len = encodeMgaIniPosLlh(message, fix, CONFIG_GNSS_AIDING_POS_ACC_KM * 100'000U);
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(uart, message[i]);
+    }
+
+#ifdef CONFIG_GNSS_AIDING_TIME
+    len = encodeMgaIniTimeUtc(message, fix, CONFIG_GNSS_AIDING_TIME_ACC_S);
+    for (size_t i = 0; i < len; i++) {
+        uart_poll_out(uart, message[i]);
+    }
+#endif
+
+    aided = true;
+    char latitude[FIXED_POINT_TEXT_SIZE];
+    char longitude[FIXED_POINT_TEXT_SIZE];
+    formatFixedPoint(latitude, fix.latitudeE7, 7, 7);
+    formatFixedPoint(longitude, fix.longitudeE7, 7, 7);
+    LOG_INF("GNSS aided with saved fix %s, %s", latitude, longitude);
+    return true;
 }
+#endif
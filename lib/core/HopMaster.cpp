@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/HopMaster.h"
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+
+#include <zephyr/logging/log.h>
+
+#include "core/LoraTransceiver.h"
+#include "core/TdmaClock.h"
+
+LOG_MODULE_REGISTER(hop_master);
+
+HopMaster::HopMaster(LoraTransceiver& lora, const ChannelPlan& plan) : lora(lora), plan(plan) {
+    k_timer_init(&frameTimer, frameExpiry, nullptr);
+    k_timer_user_data_set(&frameTimer, this);
+    dwellWork.owner = this;
+    k_work_init(&dwellWork.work, dwellWorkHandler);
+    beaconWork.owner = this;
+    k_work_init_delayable(&beaconWork.work, beaconWorkHandler);
+}
+
+void HopMaster::start() {
+    LOG_INF("Hopping over %u channels, %u frames each", plan.channels(), CONFIG_HOP_DWELL_FRAMES);
+    atomic_set(&frame, 0);
+    frameStartMs = k_uptime_get_32();
+    k_work_submit(&dwellWork.work);
+    k_timer_start(&frameTimer, K_MSEC(TdmaClock::FRAME_LEN_MS), K_MSEC(TdmaClock::FRAME_LEN_MS));
+}
+
+void HopMaster::frameExpiry(k_timer* timer) {
+    auto* master = static_cast<HopMaster*>(k_timer_user_data_get(timer));
+    master->frameStartMs = k_uptime_get_32();
+    const uint32_t next = static_cast<uint32_t>(atomic_inc(&master->frame)) + 1;
+    if (master->plan.dwellStart(next)) {
+        // Retuning touches SPI, so leave the timer ISR first
+        k_work_submit(&master->dwellWork.work);
+    }
+}
+
+void HopMaster::dwellWorkHandler(k_work* work) {
+    CONTAINER_OF(work, DwellWork, work)->owner->startDwell();
+}
+
+void HopMaster::beaconWorkHandler(k_work* work) {
+    auto* delayable = k_work_delayable_from_work(work);
+    CONTAINER_OF(delayable, BeaconWork, work)->owner->sendBeacon();
+}
+
+void HopMaster::startDwell() {
+    const uint32_t frameNumber = this->frameNumber();
+    lora.awaitCancel();
+    lora.setFrequency(plan.frequencyFor(frameNumber));
+    lora.setRx();
+    lora.awaitRxPacket();
+
+    // Trackers retune on their own frame boundaries, give them time to get there first
+    k_work_schedule(&beaconWork.work, K_MSEC(CONFIG_HOP_BEACON_DELAY_MS));
+}
+
+void HopMaster::txDoneCallback(void* userData) {
+    auto* master = static_cast<HopMaster*>(userData);
+    master->lora.setTxDoneHandler(nullptr, nullptr);
+    master->lora.setRx();
+    master->lora.awaitRxPacket();
+}
+
+void HopMaster::sendBeacon() {
+    BeaconFrame beacon{};
+    beacon.frame_number = frameNumber();
+    beacon.offset_ms = static_cast<uint16_t>(k_uptime_get_32() - frameStartMs);
+
+    lora.awaitCancel();
+    lora.setTx();
+    lora.setTxDoneHandler(txDoneCallback, this);
+
+    if (!lora.txBeacon(beacon)) {
+        txDoneCallback(this);
+    }
+}
+
+#endif
@@ -3,12 +3,59 @@
 #include <array>
 #include <cstring>
 
+#include "core/AgeOfInformation.h"
+#include "core/BootTimeline.h"
+#include "core/EnergyModel.h"
+#include "core/EventTrace.h"
+#include "core/Coordinates.h"
+#include "core/DiscoveryScan.h"
+#include "core/Downlink.h"
+#include "core/FixBatch.h"
+#include "core/FrameCodec.h"
+#include "core/PositionPredictor.h"
+#include "core/RxCapture.h"
+#include "core/SfScanner.h"
+#include "core/TdmaClock.h"
+#include "core/TimestampService.h"
 #include "core/defs.h"
 #include "zephyr/drivers/gnss.h"
 #include "zephyr/logging/log.h"
+#include "zephyr/random/random.h"
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#if defined(CONFIG_LISTEN_BEFORE_TALK) || defined(CONFIG_SF_SCAN) ||           \
+    defined(CONFIG_DISCOVERY_SCAN) || defined(CONFIG_LORA_FAST_TURNAROUND)
+#include <radio.h>
+#endif
 
 LOG_MODULE_REGISTER(LoraTransceiver);
 
+LoraTransceiver *LoraTransceiver::shellInstance = nullptr;
+
+#ifdef CONFIG_SLOT_TX
+// Keys armed transmissions, above everything the system work queue runs
+K_THREAD_STACK_DEFINE(slotTxStack, CONFIG_SLOT_TX_STACK_SIZE);
+static k_work_q slotTxQueue;
+
+static void startSlotTxQueue() {
+  static bool started;
+  if (started) {
+    return;
+  }
+  started = true;
+
+  k_work_queue_config queueConfig{};
+  queueConfig.name = "slot_tx";
+  k_work_queue_init(&slotTxQueue);
+  k_work_queue_start(&slotTxQueue, slotTxStack,
+                     K_THREAD_STACK_SIZEOF(slotTxStack), K_PRIO_COOP(0),
+                     &queueConfig);
+}
+#endif
+
 static void loraReceiveCallback(const device *dev, uint8_t *data, uint16_t size,
                                 int16_t rssi, int8_t snr, void *userData) {
   if (auto *transceiver = static_cast<LoraTransceiver *>(userData)) {
@@ -16,46 +63,158 @@ static void loraReceiveCallback(const device *dev, uint8_t *data, uint16_t size,
   }
 }
 
-static int32_t nanoToMilli(const int64_t nano) {
-  return static_cast<int32_t>(nano / 1'000'000);
+LoraTransceiver::LoraTransceiver(const uint8_t nodeId,
+                                 const uint32_t frequencyHz)
+    : nodeId(nodeId) {
+  config.frequency = frequencyHz;
+  txDoneWork.owner = this;
+  k_work_poll_init(&txDoneWork.work, txDoneWorkHandler);
+  k_poll_signal_init(&txSignal);
+  k_mutex_init(&radioLock);
+#ifdef CONFIG_SLOT_TX
+  startSlotTxQueue();
+  k_timer_init(&keyTimer, keyTimerExpiry, nullptr);
+  k_timer_user_data_set(&keyTimer, this);
+  keyWork.owner = this;
+  k_work_init(&keyWork.work, keyWorkHandler);
+#endif
+  shellInstance = this;
+  init();
 }
 
-static double milliToDeg(const int32_t milli) {
-  return static_cast<double>(milli) / 1'000.0;
+bool LoraTransceiver::txNoFixPayload() {
+  uint8_t buffer[TxFrameEncoder::frameSize<NoFixFrame>];
+  const size_t len = encoder.encodeNoFix(buffer, nodeId, txSequence++);
+
+  return tx(buffer, len);
 }
 
-LoraTransceiver::LoraTransceiver(const uint8_t nodeId, const float frequencyMHz)
-    : nodeId(nodeId) {
-  config.frequency = static_cast<uint32_t>(frequencyMHz * 1'000'000);
-  init();
+bool LoraTransceiver::txGnssPayload(const gnss_data &gnssData,
+                                    const int64_t fixUptimeMs) {
+#ifdef CONFIG_FIX_AGE
+  int64_t ageMs = k_uptime_get() - fixUptimeMs;
+#ifdef CONFIG_SLOT_TX
+  // An armed frame goes on air at its start time, not now
+  if (armPending) {
+    ageMs += MAX(TdmaClock::instance().usUntil(armedStartTicks), 0) / 1000;
+  }
+#endif
+  uint8_t buffer[TxFrameEncoder::frameSize<TimedFixFrame>];
+  const size_t len = encoder.encodeTimedFix(
+      buffer, nodeId, txSequence++, toGnssInfo(gnssData),
+      static_cast<uint32_t>(CLAMP(ageMs, 0, UINT16_MAX)));
+#else
+  ARG_UNUSED(fixUptimeMs);
+  uint8_t buffer[TxFrameEncoder::frameSize<LoraFrame>];
+  const size_t len =
+      encoder.encodeFix(buffer, nodeId, txSequence++, toGnssInfo(gnssData));
+#endif
+
+  return tx(buffer, len);
 }
 
-bool LoraTransceiver::txNoFixPayload() {
-  NoFixFrame packet{};
-#ifdef CONFIG_LICENSED_FREQUENCY
-  memcpy(&packet.callsign, callsign,
-         std::min(strlen(callsign), CALLSIGN_CHAR_COUNT));
+#ifdef CONFIG_FIX_BATCHING
+bool LoraTransceiver::txGnssBatch(const FixBatch &batch) {
+  // The sample timer keeps pushing while this encodes, so work from a copy
+  GnssInfo fixes[FixBatch::CAPACITY];
+  uint16_t sampleIndex = 0;
+  const size_t count = batch.copy(fixes, sampleIndex);
+  if (count == 0) {
+    return false;
+  }
+
+  FixBatchFrame header{};
+  header.node_id = nodeId;
+  header.sample_index = sampleIndex;
+  header.seq = txSequence++;
+  header.interval_ds = FixBatch::INTERVAL_DS;
+
+  uint8_t buffer[TxFrameEncoder::frameSize<FixBatchFrame> +
+                 (FixBatch::CAPACITY - 1) * FIX_DELTA_SIZE];
+  const size_t len = encoder.encodeFixBatch(buffer, header, fixes, count);
+
+  return tx(buffer, len);
+}
 #endif
-  packet.node_id = nodeId;
 
-  return tx(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
+#ifdef CONFIG_RELAY
+bool LoraTransceiver::txRelayed(const uint8_t *frame, const size_t size,
+                                const uint8_t hops) {
+  uint8_t buffer[TxFrameEncoder::frameSize<RelayFrame> + RELAY_MAX_INNER_SIZE];
+  const size_t len = encoder.encodeRelay(buffer, nodeId, hops, frame, size);
+  if (len == 0) {
+    return false;
+  }
+
+  return tx(buffer, len);
 }
+#endif
 
-bool LoraTransceiver::txGnssPayload(const gnss_data &gnssData) {
-  LoraFrame packet{};
+#ifdef CONFIG_DOWNLINK
+bool LoraTransceiver::txCommand(const CommandFrame &command) {
+  uint8_t buffer[TxFrameEncoder::frameSize<CommandFrame>];
+  const size_t len = encoder.encodeCommand(buffer, command);
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-  memcpy(&packet.callsign, callsign,
-         std::min(strlen(callsign), CALLSIGN_CHAR_COUNT));
+  return tx(buffer, len);
+}
+
+bool LoraTransceiver::txCommandAck(const uint8_t commandId,
+                                   const CommandStatus status) {
+  CommandAckFrame ack{};
+  ack.node_id = nodeId;
+  ack.command_id = commandId;
+  ack.status = static_cast<uint8_t>(status);
+
+  uint8_t buffer[TxFrameEncoder::frameSize<CommandAckFrame>];
+  const size_t len = encoder.encodeCommandAck(buffer, ack);
+
+  return tx(buffer, len);
+}
+
+void LoraTransceiver::setCommandHandler(
+    void (*handler)(const CommandFrame &command, void *userData),
+    void *userData) {
+  commandHandler = handler;
+  commandUserData = userData;
+}
+#endif
+
+#ifdef CONFIG_FREQUENCY_HOPPING
+bool LoraTransceiver::txBeacon(const BeaconFrame &beacon) {
+  uint8_t buffer[TxFrameEncoder::frameSize<BeaconFrame>];
+  const size_t len = encoder.encodeBeacon(buffer, beacon);
+
+  return tx(buffer, len);
+}
+#endif
+
+void LoraTransceiver::setTxDoneHandler(void (*handler)(void *userData),
+                                       void *userData) {
+  txDoneHandler = handler;
+  txDoneUserData = userData;
+}
+
+void LoraTransceiver::txDoneWorkHandler(k_work *work) {
+  auto *txDone = CONTAINER_OF(work, TxDoneWork, work);
+  LoraTransceiver *transceiver = txDone->owner;
+  traceEvent(TraceEvent::TX_DONE);
+
+#ifdef CONFIG_SLOT_TX
+  transceiver->measureSlotStart();
 #endif
-  packet.node_id = nodeId;
-  packet.gnssInfo.latitude = nanoToMilli(gnssData.nav_data.latitude);
-  packet.gnssInfo.longitude = nanoToMilli(gnssData.nav_data.longitude);
-  packet.gnssInfo.satellites_cnt =
-      static_cast<uint8_t>(gnssData.info.satellites_cnt);
-  packet.gnssInfo.fix_status = gnssData.info.fix_status;
 
-  return tx(reinterpret_cast<uint8_t *>(&packet), sizeof(packet));
+  if (transceiver->txDoneHandler) {
+    transceiver->txDoneHandler(transceiver->txDoneUserData);
+  }
+}
+
+GnssInfo LoraTransceiver::toGnssInfo(const gnss_data &gnssData) {
+  GnssInfo info{};
+  info.latitude = nanoToMilliDeg(gnssData.nav_data.latitude);
+  info.longitude = nanoToMilliDeg(gnssData.nav_data.longitude);
+  info.satellites_cnt = static_cast<uint8_t>(gnssData.info.satellites_cnt);
+  info.fix_status = gnssData.info.fix_status;
+  return info;
 }
 
 int LoraTransceiver::awaitRxPacket() {
@@ -64,19 +223,32 @@ int LoraTransceiver::awaitRxPacket() {
     return -1;
   }
 
-  if (lora_recv_async(dev, loraReceiveCallback, this) != 0) {
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const int ret = lora_recv_async(dev, loraReceiveCallback, this);
+  k_mutex_unlock(&radioLock);
+  if (ret != 0) {
     LOG_ERR("LoRa async receive setup failed");
     return -1;
   }
+  endTurnaround();
+#ifdef CONFIG_ENERGY_MODEL
+  EnergyModel::instance().enter(EnergyModel::State::RADIO_RX);
+#endif
 
   return 0;
 }
 
 int LoraTransceiver::awaitCancel() {
-  if (lora_recv_async(dev, nullptr, nullptr) != 0) {
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const int ret = lora_recv_async(dev, nullptr, nullptr);
+  k_mutex_unlock(&radioLock);
+  if (ret != 0) {
     LOG_ERR("LoRa async cancel setup failed");
     return -1;
   }
+#ifdef CONFIG_ENERGY_MODEL
+  EnergyModel::instance().enter(EnergyModel::State::RADIO_SLEEP);
+#endif
 
   return 0;
 }
@@ -85,66 +257,264 @@ void LoraTransceiver::receiveCallback(uint8_t *data, uint16_t size,
                                       int16_t rssi, int8_t snr) {
   if (config.tx || !data || size == 0)
     return;
+  traceEvent(TraceEvent::RX, size);
 
-  switch (size) {
-  case sizeof(LoraFrame): {
-    const auto frame = reinterpret_cast<LoraFrame *>(data);
-    parseLoraFrame(*frame, size, rssi, snr);
-    break;
+#ifdef CONFIG_FIX_AGE
+  rxCycles = k_cycle_get_32();
+#endif
+
+  // DIO0 only raises RxDone while receiving, so a capture newer than the last
+  // frame's belongs to this one
+  TimestampService::Capture rxDone{};
+  rxDoneValid = TimestampService::instance().lastCapture(
+                    TimestampService::Event::RADIO_DONE, rxDone) &&
+                rxDone.count != rxDoneCount;
+  rxDoneTicks = rxDone.ticks;
+  rxDoneCount = rxDone.count;
+
+#ifdef CONFIG_SF_SCAN
+  if (scanner) {
+    scanner->onFrame(timeOnAirUs(size));
   }
-  case NOFIX_PACKET_SIZE: {
-    const auto frame = reinterpret_cast<NoFixFrame *>(data);
-#ifdef CONFIG_LICENSED_FREQUENCY
-    LOG_INF("%.6s-%d: (%d bytes | %d dBm | %d dB):", frame->callsign,
-            frame->node_id, size, rssi, snr);
-#else
-    LOG_INF("Node %d: (%d bytes | %d dBm | %d dB):", frame->node_id, size, rssi,
-            snr);
 #endif
-    LOG_INF("\tNo fix acquired!");
-    break;
+
+#ifdef CONFIG_DISCOVERY_SCAN
+  FrameId heard{};
+  if (discovery && identifyFrame(data, size, heard)) {
+    discovery->onFrame(config.frequency, heard.nodeId, rssi);
   }
-  default:
-    LOG_INF("(%d bytes | %d dBm | %d dB):", size, rssi, snr);
-#ifdef CONFIG_LICENSED_FREQUENCY
-    LOG_INF("\tCallsign: %.*s", CALLSIGN_CHAR_COUNT, data);
 #endif
-    LOG_INF("\tReceived data: %s", data);
-    break;
+
+#ifdef CONFIG_RX_CAPTURE
+  captureFrame(data, size, rssi, snr);
+#endif
+
+#ifdef CONFIG_RELAY
+  // Commands are never relayed, the hunter repeats them after the target's
+  // own uplinks instead. Beacons are only good for timing when heard directly.
+  const size_t prefix = framePrefixSize(data, size);
+  const bool fromHunter =
+      size > prefix &&
+      (data[prefix] == static_cast<uint8_t>(FrameType::COMMAND) ||
+       data[prefix] == static_cast<uint8_t>(FrameType::BEACON));
+  if (relayCache && !fromHunter) {
+    relayCache->offer(data, size, k_uptime_get_32());
+    return;
+  }
+#endif
+
+  decoder.decode(data, size, rssi, snr, k_uptime_get_32());
+
+#ifdef CONFIG_DOWNLINK
+  // Only frames heard directly: the sender is listening for a reply right now
+  FrameId id{};
+  if (downlink && identifyFrame(data, size, id)) {
+    downlink->onUplink(id.nodeId);
+  }
+#endif
+}
+
+#ifdef CONFIG_RX_CAPTURE
+void LoraTransceiver::captureFrame(const uint8_t *data, const uint16_t size,
+                                   const int16_t rssi, const int8_t snr) {
+  // Only ever called from the receive callback, so these can be shared
+  static RxCaptureRecord record;
+  static char line[RX_CAPTURE_LINE_SIZE];
+
+  record.arrivalUs = k_ticks_to_us_floor64(k_uptime_ticks());
+  record.rssi = rssi;
+  record.snr = snr;
+  record.size = static_cast<uint8_t>(MIN(size, RX_CAPTURE_MAX_FRAME));
+  memcpy(record.data, data, record.size);
+
+  if (formatRxCapture(line, record) > 0) {
+    printk("%s\n", line);
   }
 }
+#endif
+
+bool LoraTransceiver::lastRxTimestamp(uint32_t &ticks) const {
+  ticks = rxDoneTicks;
+  return rxDoneValid;
+}
+
+uint32_t LoraTransceiver::symbolUs() const {
+  uint32_t bandwidthHz = 125'000;
+  if (config.bandwidth == BW_250_KHZ) {
+    bandwidthHz = 250'000;
+  } else if (config.bandwidth == BW_500_KHZ) {
+    bandwidthHz = 500'000;
+  }
+
+  return static_cast<uint32_t>((uint64_t{1} << config.datarate) * 1'000'000U /
+                               bandwidthHz);
+}
+
+uint32_t LoraTransceiver::timeOnAirUs(const size_t size) const {
+  const int32_t sf = config.datarate;
+  const uint32_t symbolUs = this->symbolUs();
+  // The driver turns on low data rate optimization for symbols over 16 ms
+  const int32_t lowRate = symbolUs > 16'000 ? 1 : 0;
+
+  // Explicit header and payload CRC, as the driver sends
+  const int32_t bits = 8 * static_cast<int32_t>(size) - 4 * sf + 28 + 16;
+  const int32_t bitsPerBlock = 4 * (sf - 2 * lowRate);
+  const int32_t blocks = bits > 0 ? (bits + bitsPerBlock - 1) / bitsPerBlock : 0;
+  const uint32_t payloadSymbols = 8 + blocks * (config.coding_rate + 4);
+
+  // Preamble plus 4.25 symbols of sync word
+  return (config.preamble_len * 4U + 17U) * symbolUs / 4U +
+         payloadSymbols * symbolUs;
+}
 
 bool LoraTransceiver::setTx() {
-  config.tx = true;
-  const int ret = lora_config(dev, &config);
-  if (ret != 0) {
-    LOG_ERR("LoRa configuration failed %d", ret);
-    return false;
+  if (!config.tx) {
+    startTurnaround(turnaroundStats.rxToTx);
   }
-  return true;
+  config.tx = true;
+  return configure();
 };
 
 bool LoraTransceiver::setRx() {
+  if (config.tx) {
+    startTurnaround(turnaroundStats.txToRx);
+  }
   config.tx = false;
+  return configure();
+};
+
+bool LoraTransceiver::configure() {
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const bool configured = configureLocked();
+  k_mutex_unlock(&radioLock);
+  return configured;
+}
+
+bool LoraTransceiver::configureLocked() {
+#ifdef CONFIG_LORA_FAST_TURNAROUND
+  // The driver programs RX and TX differently, the payload CRC is only on for
+  // TX, so a full configuration is only reused in the direction it was
+  // written for, e.g. a tracker retransmitting or hopping frequency
+  const bool sameModem = applied.bandwidth == config.bandwidth &&
+                         applied.datarate == config.datarate &&
+                         applied.coding_rate == config.coding_rate &&
+                         applied.preamble_len == config.preamble_len &&
+                         applied.iq_inverted == config.iq_inverted &&
+                         applied.public_network == config.public_network;
+  if (!sameModem) {
+    rxApplied = false;
+    txApplied = false;
+  }
+  if (applied.tx_power != config.tx_power) {
+    txApplied = false;
+  }
+
+  // SetChannel bypasses the driver's lock on the modem, so only while no
+  // asynchronous RX or TX is running
+  const bool sameFrequency = applied.frequency == config.frequency;
+  if ((config.tx ? txApplied : rxApplied) &&
+      (sameFrequency || Radio.GetStatus() == RF_IDLE)) {
+    if (!sameFrequency) {
+      Radio.SetChannel(config.frequency);
+      applied.frequency = config.frequency;
+    }
+    turnaroundStats.fastConfigs++;
+    return true;
+  }
+#endif
+
   const int ret = lora_config(dev, &config);
   if (ret != 0) {
     LOG_ERR("LoRa configuration failed %d", ret);
     return false;
   }
+
+#ifdef CONFIG_LORA_FAST_TURNAROUND
+  applied = config;
+  txApplied = config.tx;
+  rxApplied = !config.tx;
+#endif
+  turnaroundStats.fullConfigs++;
   return true;
-};
+}
+
+void LoraTransceiver::startTurnaround(TurnaroundTime &time) {
+  turnaroundPending = &time;
+  turnaroundStartCycles = k_cycle_get_32();
+}
+
+void LoraTransceiver::endTurnaround() {
+  if (!turnaroundPending) {
+    return;
+  }
+
+  const uint32_t us =
+      k_cyc_to_us_floor32(k_cycle_get_32() - turnaroundStartCycles);
+  TurnaroundTime &time = *turnaroundPending;
+  time.count++;
+  time.lastUs = us;
+  time.maxUs = MAX(time.maxUs, us);
+  time.totalUs += us;
+  turnaroundPending = nullptr;
+}
+
+#if defined(CONFIG_LISTEN_BEFORE_TALK) || defined(CONFIG_DISCOVERY_SCAN)
+bool LoraTransceiver::isChannelClear(const int16_t rssiThresholdDbm,
+                                     const uint32_t senseMs) {
+  // Zephyr's LoRa API has no channel activity detection, so sense energy on
+  // the channel through the SX12xx radio driver underneath it. Its receive
+  // bandwidth tops out at 250 kHz.
+  const uint32_t bandwidthHz = config.bandwidth == BW_125_KHZ ? 125'000 : 250'000;
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const bool clear = Radio.IsChannelFree(config.frequency, bandwidthHz,
+                                         rssiThresholdDbm, senseMs);
+
+  // Sensing leaves the modem asleep in FSK mode, so reprogram it in full
+#ifdef CONFIG_LORA_FAST_TURNAROUND
+  rxApplied = false;
+  txApplied = false;
+#endif
+  configureLocked();
+  k_mutex_unlock(&radioLock);
+  return clear;
+}
+#endif
+
+#ifdef CONFIG_SF_SCAN
+bool LoraTransceiver::preambleDetected() {
+  // The SX127x raises no interrupt for a preamble while receiving, but flags
+  // it in the modem status register. Zephyr's LoRa API has no channel
+  // activity detection to use instead.
+  static constexpr uint32_t REG_MODEM_STAT = 0x18;
+  static constexpr uint8_t SIGNAL_DETECTED = 0x01;
+  static constexpr uint8_t SIGNAL_SYNCHRONIZED = 0x02;
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const uint8_t status = Radio.Read(REG_MODEM_STAT);
+  k_mutex_unlock(&radioLock);
+  return (status & (SIGNAL_DETECTED | SIGNAL_SYNCHRONIZED)) != 0;
+}
+#endif
 
 bool LoraTransceiver::setFrequency(uint32_t frequency) {
   config.frequency = frequency;
-  const int ret = lora_config(dev, &config);
-  if (ret != 0) {
-    LOG_ERR("LoRa configuration failed %d", ret);
-    return false;
-  }
-  return true;
+  return configure();
 };
 
+bool LoraTransceiver::setDatarate(const lora_datarate datarate) {
+  config.datarate = datarate;
+  return configure();
+}
+
+bool LoraTransceiver::setTxPower(const int8_t power) {
+  config.tx_power = power;
+  return configure();
+}
+
 bool LoraTransceiver::init() {
+  // Start away from the numbers sent before a reboot, receivers also forget a
+  // node's numbers once it has been silent for SeenFrames::SILENCE_MS
+  txSequence = static_cast<uint8_t>(sys_rand32_get());
+
   if (!device_is_ready(dev)) {
     LOG_ERR("LoRa device not ready (dev ptr %p)", dev);
     return false;
@@ -153,9 +523,7 @@ bool LoraTransceiver::init() {
   LOG_INF("LoRa device name: %s, addr: %p", dev->name ? dev->name : "UNKNOWN",
           dev);
 
-  const int ret = lora_config(dev, &config);
-  if (ret != 0) {
-    LOG_ERR("LoRa configuration failed, rc=%d", ret);
+  if (!configure()) {
     return false;
   }
 
@@ -164,6 +532,7 @@ bool LoraTransceiver::init() {
           config.frequency, config.datarate, config.bandwidth,
           config.coding_rate, config.tx_power, config.public_network);
 
+  bootMark(BootMilestone::RADIO_READY);
   return true;
 }
 
@@ -173,42 +542,329 @@ bool LoraTransceiver::tx(uint8_t *data, uint32_t data_len) {
     return false;
   }
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-  if (strnlen(callsign, CALLSIGN_CHAR_COUNT) == 0) {
+  if (!encoder.hasCallsign()) {
     LOG_ERR("Callsign not set, cannot transmit on licensed frequency");
     return false;
   }
+
+#ifdef CONFIG_SLOT_TX
+  if (armPending) {
+    armPending = false;
+    if (data_len <= sizeof(armedFrame) &&
+        TimestampService::instance().frequency() != 0) {
+      memcpy(armedFrame, data, data_len);
+      armedLength = data_len;
+      slotTxStats.armed++;
+
+      // Wake a little early and spin out the rest on the capture timer, the
+      // kernel tick is too coarse for the start time
+      const int32_t untilUs =
+          TdmaClock::instance().usUntil(armedStartTicks);
+      if (untilUs > CONFIG_SLOT_TX_LEAD_US) {
+        k_timer_start(&keyTimer, K_USEC(untilUs - CONFIG_SLOT_TX_LEAD_US),
+                      K_NO_WAIT);
+      } else {
+        if (untilUs < 0) {
+          slotTxStats.late++;
+        }
+        k_work_submit_to_queue(&slotTxQueue, &keyWork.work);
+      }
+      return true;
+    }
+  }
 #endif
 
-  if (lora_send_async(dev, data, data_len, nullptr) != 0) {
+  return send(data, data_len);
+}
+
+bool LoraTransceiver::send(uint8_t *data, const uint32_t data_len) {
+  traceEvent(TraceEvent::TX_START, static_cast<uint16_t>(data_len));
+  k_poll_signal *signal = txDoneHandler ? &txSignal : nullptr;
+  if (signal) {
+    k_poll_signal_reset(signal);
+  }
+
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const int ret = lora_send_async(dev, data, data_len, signal);
+  k_mutex_unlock(&radioLock);
+  if (ret != 0) {
     LOG_ERR("LoRa send failed");
     return false;
   }
+  endTurnaround();
+#ifdef CONFIG_ENERGY_MODEL
+  EnergyModel::instance().radioTx(timeOnAirUs(data_len), config.tx_power);
+#endif
+
+  if (signal) {
+    k_poll_event_init(&txEvent, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY,
+                      signal);
+    k_work_poll_submit(&txDoneWork.work, &txEvent, 1, K_FOREVER);
+  }
+  bootMark(BootMilestone::FIRST_TX);
   LOG_DBG("Transmitted %u bytes over LoRa", data_len);
   return true;
 }
 
+#ifdef CONFIG_SLOT_TX
+void LoraTransceiver::armAt(const uint32_t startTicks) {
+  armedStartTicks = startTicks;
+  armPending = true;
+}
+
+void LoraTransceiver::disarm() {
+  armPending = false;
+  k_timer_stop(&keyTimer);
+  k_work_cancel(&keyWork.work);
+}
+
+void LoraTransceiver::keyTimerExpiry(k_timer *timer) {
+  auto *transceiver =
+      static_cast<LoraTransceiver *>(k_timer_user_data_get(timer));
+  traceEvent(TraceEvent::TX_KEY_TIMER);
+  k_work_submit_to_queue(&slotTxQueue, &transceiver->keyWork.work);
+}
+
+void LoraTransceiver::keyWorkHandler(k_work *work) {
+  CONTAINER_OF(work, KeyWork, work)->owner->keyArmed();
+}
+
+void LoraTransceiver::keyArmed() {
+  // Back to the timer if the start time has moved away since arming, e.g. the
+  // TDMA clock stepped to a new PPS, so the spin below stays within the lead
+  const int32_t untilUs = TdmaClock::instance().usUntil(armedStartTicks);
+  if (untilUs > CONFIG_SLOT_TX_LEAD_US) {
+    k_timer_start(&keyTimer, K_USEC(untilUs - CONFIG_SLOT_TX_LEAD_US),
+                  K_NO_WAIT);
+    return;
+  }
+
+  // Held from the spin to keying, so no reconfiguration from another thread
+  // lands in between. Waiting for one already running makes the slot late.
+  k_mutex_lock(&radioLock, K_FOREVER);
+  const TimestampService &timestamps = TimestampService::instance();
+  // Cooperative thread, so only interrupts get in between here and keying.
+  // The cycle counter caps the spin at the lead should the capture timer
+  // stall, other cooperative threads wait for it.
+  const uint32_t spinStartCycles = k_cycle_get_32();
+  const uint32_t spinLimitCycles = k_us_to_cyc_ceil32(CONFIG_SLOT_TX_LEAD_US);
+  while (static_cast<int32_t>(armedStartTicks - timestamps.now()) > 0 &&
+         k_cycle_get_32() - spinStartCycles < spinLimitCycles) {
+  }
+  const uint32_t keyedTicks = timestamps.now();
+
+  TimestampService::Capture done{};
+  timestamps.lastCapture(TimestampService::Event::RADIO_DONE, done);
+  keyedDoneCount = done.count;
+  measurePending = send(armedFrame, armedLength);
+  k_mutex_unlock(&radioLock);
+
+  const auto keyLatencyUs = static_cast<uint32_t>(
+      static_cast<uint64_t>(keyedTicks - armedStartTicks) * 1'000'000U /
+      timestamps.frequency());
+  slotTxStats.maxKeyLatencyUs = MAX(slotTxStats.maxKeyLatencyUs, keyLatencyUs);
+}
+
+void LoraTransceiver::measureSlotStart() {
+  if (!measurePending) {
+    return;
+  }
+  measurePending = false;
+
+  const TimestampService &timestamps = TimestampService::instance();
+  TimestampService::Capture done{};
+  if (!timestamps.lastCapture(TimestampService::Event::RADIO_DONE, done) ||
+      done.count == keyedDoneCount) {
+    return;
+  }
+
+  // The frame went on air one time on air before its TxDone edge
+  const uint32_t timerHz = timestamps.frequency();
+  const auto airTicks = static_cast<uint32_t>(
+      static_cast<uint64_t>(timeOnAirUs(armedLength)) * timerHz / 1'000'000U);
+  const auto errorTicks =
+      static_cast<int32_t>(done.ticks - airTicks - armedStartTicks);
+  const auto errorUs = static_cast<int32_t>(
+      static_cast<int64_t>(errorTicks) * 1'000'000 / timerHz);
+
+  SlotStats &stats = slotTxStats;
+  stats.minErrorUs =
+      stats.measured == 0 ? errorUs : MIN(stats.minErrorUs, errorUs);
+  stats.maxErrorUs =
+      stats.measured == 0 ? errorUs : MAX(stats.maxErrorUs, errorUs);
+  stats.lastErrorUs = errorUs;
+  stats.totalErrorUs += errorUs;
+  stats.measured++;
+}
+#endif
+
 #ifdef CONFIG_LICENSED_FREQUENCY
 void LoraTransceiver::setCallsign(const char *callsign) {
-  this->callsign = callsign;
+  encoder.setCallsign(callsign);
 }
 #endif
 
 void LoraTransceiver::setNodeId(uint8_t id) { nodeId = id; }
 
-void LoraTransceiver::parseLoraFrame(const LoraFrame &frame, const size_t size,
-                                     const int16_t rssi,
-                                     const int8_t snr) const {
-  LOG_INF("Node %d: (%d bytes | %d dBm | %d dB):", frame.node_id, size, rssi,
-          snr);
+void LoraTransceiver::onFix(const LoraFrame &frame, const RxInfo &rx) {
+  LOG_INF("Node %d: (%d bytes | %d dBm | %d dB):", frame.node_id, rx.size,
+          rx.rssi, rx.snr);
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-  LOG_INF("\tCallsign: %.*s", CALLSIGN_CHAR_COUNT, frame.callsign);
+  if (rx.callsign) {
+    LOG_INF("\tCallsign: %.*s", CALLSIGN_CHAR_COUNT, rx.callsign);
+  }
+  printGnssInfo(frame.gnssInfo);
+  predictFix(frame.node_id, frame.gnssInfo, 0);
+}
+
+void LoraTransceiver::onTimedFix(const TimedFixFrame &frame,
+                                 const RxInfo &rx) {
+  if (rx.callsign) {
+    LOG_INF("%.6s-%d: (%d bytes | %d dBm | %d dB):", rx.callsign,
+            frame.node_id, rx.size, rx.rssi, rx.snr);
+  } else {
+    LOG_INF("Node %d: (%d bytes | %d dBm | %d dB):", frame.node_id, rx.size,
+            rx.rssi, rx.snr);
+  }
+  printGnssInfo(frame.fix);
+
+  // The tracker timed the fix up to the start of the frame, the rest is airtime
+  // and the hunter's own handling
+  const uint32_t airtimeUs = timeOnAirUs(rx.size);
+  uint32_t ageMs = frame.fix_age_ms + airtimeUs / 1000U;
+  predictFix(frame.node_id, frame.fix, ageMs);
+#ifdef CONFIG_FIX_AGE
+  if (ageStats) {
+    ageMs = ageStats->record(frame.node_id, frame.fix_age_ms, airtimeUs,
+                             k_cyc_to_us_floor32(k_cycle_get_32() - rxCycles));
+  }
 #endif
-  LOG_INF("\tLatitude: %f", milliToDeg(frame.gnssInfo.latitude));
-  LOG_INF("\tLongitude: %f", milliToDeg(frame.gnssInfo.longitude));
-  LOG_INF("\tSatellites count: %u", frame.gnssInfo.satellites_cnt);
-  switch (frame.gnssInfo.fix_status) {
+  LOG_INF("\tPosition age: %u ms", ageMs);
+}
+
+void LoraTransceiver::onBatchFix(const FixBatchFrame &header,
+                                 const GnssInfo &fix, const uint32_t ageMs,
+                                 const RxInfo &rx) {
+  if (rx.callsign) {
+    LOG_INF("%.6s-%d: (%d bytes | %d dBm | %d dB):", rx.callsign,
+            header.node_id, rx.size, rx.rssi, rx.snr);
+  } else {
+    LOG_INF("Node %d: (%d bytes | %d dBm | %d dB):", header.node_id, rx.size,
+            rx.rssi, rx.snr);
+  }
+  printGnssInfo(fix);
+  LOG_INF("\tFix age: %u ms", ageMs);
+  predictFix(header.node_id, fix, ageMs);
+}
+
+void LoraTransceiver::predictFix(const uint8_t nodeId, const GnssInfo &fix,
+                                 const uint32_t ageMs) {
+#ifdef CONFIG_POSITION_PREDICTOR
+  if (!predictor) {
+    return;
+  }
+  switch (predictor->update(nodeId, fix, k_uptime_get_32() - ageMs)) {
+  case PositionPredictor::Result::OUTLIER:
+    LOG_INF("\tOutlier: fix rejected by predictor");
+    break;
+  case PositionPredictor::Result::INVALID:
+    LOG_INF("\tInvalid position: fix rejected by predictor");
+    break;
+  default:
+    break;
+  }
+#else
+  ARG_UNUSED(nodeId);
+  ARG_UNUSED(fix);
+  ARG_UNUSED(ageMs);
+#endif
+}
+
+void LoraTransceiver::onNoFix(const NoFixFrame &frame, const RxInfo &rx) {
+  if (rx.callsign) {
+    LOG_INF("%.6s-%d: (%d bytes | %d dBm | %d dB):", rx.callsign,
+            frame.node_id, rx.size, rx.rssi, rx.snr);
+  } else {
+    LOG_INF("Node %d: (%d bytes | %d dBm | %d dB):", frame.node_id, rx.size,
+            rx.rssi, rx.snr);
+  }
+  LOG_INF("\tNo fix acquired!");
+}
+
+void LoraTransceiver::onRelayed(const RelayFrame &envelope) {
+  LOG_INF("\tRelayed by: node %u (%u hops)", envelope.relay_node_id,
+          envelope.hops);
+}
+
+void LoraTransceiver::onCommand(const CommandFrame &command,
+                                const RxInfo &rx) {
+#ifdef CONFIG_DOWNLINK
+  if (commandHandler && (command.target_node == nodeId ||
+                         command.target_node == BROADCAST_NODE_ID)) {
+    commandHandler(command, commandUserData);
+  }
+#endif
+  LOG_DBG("Command %u for node %u (%d dBm)", command.command_id,
+          command.target_node, rx.rssi);
+}
+
+void LoraTransceiver::onCommandAck(const CommandAckFrame &ack,
+                                   const RxInfo &rx) {
+#ifdef CONFIG_DOWNLINK
+  if (downlink) {
+    downlink->onAck(ack);
+  }
+#endif
+  static constexpr const char *statusNames[] = {"applied", "invalid",
+                                                "unsupported", "failed"};
+  LOG_INF("Command %u acknowledged by node %u: %s (%d dBm)", ack.command_id,
+          ack.node_id,
+          ack.status < ARRAY_SIZE(statusNames) ? statusNames[ack.status]
+                                               : "unknown",
+          rx.rssi);
+}
+
+void LoraTransceiver::onBeacon(const BeaconFrame &beacon, const RxInfo &rx) {
+#ifdef CONFIG_FREQUENCY_HOPPING
+  if (clock) {
+    // The hunter's frame started this long before the beacon finished
+    const uint32_t elapsedUs =
+        beacon.offset_ms * 1000U + timeOnAirUs(rx.size);
+    clock->onHunterBeacon(beacon.frame_number,
+                          rxDoneValid ? rxDoneTicks
+                                      : TimestampService::instance().now(),
+                          elapsedUs);
+  }
+#endif
+  LOG_DBG("Beacon for frame %u (%d dBm)", beacon.frame_number, rx.rssi);
+}
+
+void LoraTransceiver::onUnknown(const uint8_t *data, const RxInfo &rx) {
+  LOG_INF("(%d bytes | %d dBm | %d dB):", rx.size, rx.rssi, rx.snr);
+  if (rx.callsign) {
+    LOG_INF("\tCallsign: %.*s", CALLSIGN_CHAR_COUNT, rx.callsign);
+  }
+  LOG_INF("\tReceived data: %s", data);
+}
+
+void LoraTransceiver::onMalformed(const FrameType type, const uint8_t nodeId,
+                                  const RxInfo &rx) {
+  if (type == FrameType::RELAY) {
+    LOG_WRN("Malformed relay frame from node %u", nodeId);
+  } else {
+    LOG_WRN("Malformed fix batch from node %u (%d bytes)", nodeId, rx.size);
+  }
+}
+
+void LoraTransceiver::printGnssInfo(const GnssInfo &info) const {
+  // Six places as the Dispatch GUI has always received, formatted in integers
+  char degrees[FIXED_POINT_TEXT_SIZE];
+  formatFixedPoint(degrees, info.latitude, 3, 6);
+  LOG_INF("\tLatitude: %s", degrees);
+  formatFixedPoint(degrees, info.longitude, 3, 6);
+  LOG_INF("\tLongitude: %s", degrees);
+  LOG_INF("\tSatellites count: %u", info.satellites_cnt);
+  switch (info.fix_status) {
   case GNSS_FIX_STATUS_NO_FIX:
     LOG_INF("\tFix status: NO FIX");
     break;
@@ -226,3 +882,63 @@ void LoraTransceiver::parseLoraFrame(const LoraFrame &frame, const size_t size,
     break;
   }
 }
+
+#ifdef CONFIG_SHELL
+
+static void printTurnaround(const struct shell *sh, const char *name,
+                            const LoraTransceiver::TurnaroundTime &time) {
+  const uint32_t averageUs =
+      time.count == 0 ? 0 : static_cast<uint32_t>(time.totalUs / time.count);
+  shell_print(sh, "%s: %u switches, last %u us, average %u us, max %u us",
+              name, time.count, time.lastUs, averageUs, time.maxUs);
+}
+
+static int cmd_turnaround(const struct shell *sh, size_t argc, char **argv) {
+  const LoraTransceiver *lora = LoraTransceiver::instance();
+  if (!lora) {
+    shell_error(sh, "Radio not started");
+    return -ENODEV;
+  }
+
+  const LoraTransceiver::TurnaroundStats &stats = lora->turnaround();
+  printTurnaround(sh, "RX to TX", stats.rxToTx);
+  printTurnaround(sh, "TX to RX", stats.txToRx);
+  shell_print(sh, "Configurations: %u full, %u skipped", stats.fullConfigs,
+              stats.fastConfigs);
+  return 0;
+}
+
+SHELL_CMD_REGISTER(turnaround, NULL, "Show radio turnaround times",
+                   cmd_turnaround);
+
+#ifdef CONFIG_SLOT_TX
+static int cmd_txstart(const struct shell *sh, size_t argc, char **argv) {
+  const LoraTransceiver *lora = LoraTransceiver::instance();
+  if (!lora) {
+    shell_error(sh, "Radio not started");
+    return -ENODEV;
+  }
+
+  const LoraTransceiver::SlotStats &stats = lora->slotStats();
+  shell_print(sh, "Armed: %u, late: %u, measured: %u", stats.armed,
+              stats.late, stats.measured);
+  if (stats.measured == 0) {
+    return 0;
+  }
+
+  const auto averageUs =
+      static_cast<int32_t>(stats.totalErrorUs / stats.measured);
+  shell_print(sh,
+              "Start error: last %d us, average %d us, min %d us, max %d us",
+              stats.lastErrorUs, averageUs, stats.minErrorUs,
+              stats.maxErrorUs);
+  shell_print(sh, "Jitter: %d us, keying latency max %u us",
+              stats.maxErrorUs - stats.minErrorUs, stats.maxKeyLatencyUs);
+  return 0;
+}
+
+SHELL_CMD_REGISTER(txstart, NULL, "Show slot transmission start error",
+                   cmd_txstart);
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+#include "core/NodeTable.h"
+
+#include <algorithm>
+
+bool SeenFrames::markSeen(const FrameId& id, const uint32_t nowMs) {
+    if (id.nodeId > MAX_NODE_ID) {
+        return false;
+    }
+
+    uint32_t& seen = window[id.nodeId];
+    // A restarted tracker numbers its frames from wherever it starts, possibly just behind
+    // the numbers heard before it went quiet
+    if (seen != 0 && nowMs - lastNewMs[id.nodeId] > SILENCE_MS) {
+        seen = 0;
+    }
+    const int8_t ahead = static_cast<int8_t>(id.seq - newest[id.nodeId]);
+
+    if (seen != 0 && ahead <= 0 && ahead > -WINDOW) {
+        const uint32_t bit = 1U << -ahead;
+        if (seen & bit) {
+            return false;
+        }
+        seen |= bit;
+        lastNewMs[id.nodeId] = nowMs;
+        return true;
+    }
+
+    seen = (seen != 0 && ahead > 0 && ahead < WINDOW) ? (seen << ahead) | 1U : 1U;
+    newest[id.nodeId] = id.seq;
+    lastNewMs[id.nodeId] = nowMs;
+    return true;
+}
+
+bool NodeTable::accept(const FrameId& id, const int16_t rssi, const int8_t snr, const uint32_t nowMs) {
+    if (id.nodeId > MAX_NODE_ID) {
+        return false;
+    }
+
+    Node& entry = nodes[id.nodeId];
+    if (!seen.markSeen(id, nowMs)) {
+        entry.duplicates++;
+        return false;
+    }
+
+    // Batch sample numbers restart with the tracker too
+    if (entry.frames > 0 && nowMs - entry.lastFrameMs > SeenFrames::SILENCE_MS) {
+        entry.batchSeen = false;
+    }
+    entry.lastFrameMs = nowMs;
+
+    entry.frames++;
+    entry.lastRssi = rssi;
+    entry.lastSnr = snr;
+    return true;
+}
+
+void NodeTable::recordFix(const uint8_t nodeId, const GnssInfo& fix) {
+    if (nodeId > MAX_NODE_ID) {
+        return;
+    }
+
+    nodes[nodeId].lastFix = fix;
+    nodes[nodeId].hasFix = true;
+}
+
+size_t NodeTable::takeFreshBatchFixes(const FixBatchFrame& header) {
+    if (header.node_id > MAX_NODE_ID) {
+        return 0;
+    }
+
+    Node& entry = nodes[header.node_id];
+    size_t fresh = header.count;
+    if (entry.batchSeen) {
+        const int16_t ahead = static_cast<int16_t>(header.sample_index - entry.lastBatchSample);
+        fresh = std::clamp<int32_t>(ahead, 0, header.count);
+    }
+    entry.lastBatchSample = header.sample_index;
+    entry.batchSeen = true;
+
+    return fresh;
+}
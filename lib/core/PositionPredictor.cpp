@@ -0,0 +1,208 @@
+#include "core/PositionPredictor.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "core/Coordinates.h"
+
+namespace {
+// Covariances are kept in Q8 m^2, m^2/s and m^2/s^2, and times in Q16 seconds
+constexpr int64_t ONE_Q8 = 1 << 8;
+
+// Fixes are quantised to a millidegree on air, about 111 m, which dominates GNSS error:
+// 111 / sqrt(12) = 32 m, plus a few metres from the receiver
+constexpr int64_t MEASUREMENT_VAR_M2 = 35 * 35;
+
+// Manoeuvres the constant velocity model does not follow, as white noise acceleration.
+// A descent under parachute drifts with the wind, so changes are gentle.
+// Host tools have no Kconfig and use the default.
+#ifdef CONFIG_POSITION_PREDICTOR_ACCEL_DMS2
+constexpr int64_t ACCEL_DMS2 = CONFIG_POSITION_PREDICTOR_ACCEL_DMS2;
+#else
+constexpr int64_t ACCEL_DMS2 = 10;
+#endif
+constexpr int64_t ACCEL_VAR_Q8 = (ACCEL_DMS2 * ACCEL_DMS2 * ONE_Q8) / 100;
+
+// Two fixes closer together than this give too poor a velocity to start from
+constexpr uint32_t MIN_BASELINE_MS = 1'000;
+
+// Squared Mahalanobis distance over two axes above which a fix is an outlier, 99.75%
+constexpr int64_t OUTLIER_GATE = 12;
+
+// Offsets further than this from a track's origin start a new track, keeping the Q8 state
+// within range
+constexpr int32_t MAX_OFFSET_M = 1'000'000;
+constexpr int32_t MAX_VELOCITY_Q8 = 1'000 << 8;
+
+// Limits that keep every product below within 64 bits. A track starts with at most the
+// variance of a one second baseline and the gap is capped, so these are never reached in
+// practice.
+constexpr int64_t MAX_P00 = int64_t{1} << 40;
+constexpr int64_t MAX_P01 = int64_t{1} << 36;
+constexpr int64_t MAX_P11 = int64_t{1} << 30;
+
+int64_t clamp64(const int64_t value, const int64_t limit) {
+    return value > limit ? limit : (value < -limit ? -limit : value);
+}
+
+int32_t clampVelocity(const int64_t value) {
+    return static_cast<int32_t>(clamp64(value, MAX_VELOCITY_Q8));
+}
+
+int64_t toQ16Seconds(const uint32_t ms) {
+    return (static_cast<int64_t>(ms) << 16) / 1000;
+}
+}
+
+static_assert(ACCEL_DMS2 > 0 && ACCEL_DMS2 <= 50, "Process noise would overflow propagate");
+
+PositionPredictor::Covariance PositionPredictor::propagate(const Covariance& covariance, const uint32_t dtMs) {
+    const int64_t dt = toQ16Seconds(dtMs);
+    const int64_t dt2 = (dt * dt) >> 16;
+    const int64_t dt3 = (dt2 * dt) >> 16;
+    const int64_t dt4 = (dt2 * dt2) >> 16;
+
+    const Covariance& p = covariance;
+    Covariance next{};
+    next.p00 = p.p00 + ((2 * dt * p.p01) >> 16) + ((dt2 * p.p11) >> 16) + ((dt4 * ACCEL_VAR_Q8) >> 18);
+    next.p01 = p.p01 + ((dt * p.p11) >> 16) + ((dt3 * ACCEL_VAR_Q8) >> 17);
+    next.p11 = p.p11 + ((dt2 * ACCEL_VAR_Q8) >> 16);
+
+    next.p00 = clamp64(next.p00, MAX_P00);
+    next.p01 = clamp64(next.p01, MAX_P01);
+    next.p11 = clamp64(next.p11, MAX_P11);
+    return next;
+}
+
+void PositionPredictor::start(Track& track, const GnssInfo& fix, const uint32_t timeMs) {
+    track = Track{};
+    track.origin = fix;
+    track.last = fix;
+    // Until a second fix the velocity is unknown, so predictions only spread out from here
+    track.covariance = {MEASUREMENT_VAR_M2 * ONE_Q8, 0, MEASUREMENT_VAR_M2 * ONE_Q8};
+    track.timeMs = timeMs;
+    track.fixes = 1;
+}
+
+PositionPredictor::Result PositionPredictor::update(const uint8_t nodeId, const GnssInfo& fix, const uint32_t timeMs) {
+    if (nodeId > MAX_NODE_ID) {
+        return Result::STALE;
+    }
+    if (!validPosition(fix)) {
+        return Result::INVALID;
+    }
+
+    Track& track = tracks[nodeId];
+    const int32_t elapsed = static_cast<int32_t>(timeMs - track.timeMs);
+    if (track.fixes > 0 && elapsed < 0) {
+        return Result::STALE;
+    }
+
+    int32_t north = 0;
+    int32_t east = 0;
+    if (track.fixes > 0) {
+        localOffsetM(track.origin, fix, north, east);
+    }
+
+    if (track.fixes == 0 || static_cast<uint32_t>(elapsed) > MAX_GAP_MS || std::abs(north) > MAX_OFFSET_M ||
+        std::abs(east) > MAX_OFFSET_M) {
+        start(track, fix, timeMs);
+        return Result::STARTED;
+    }
+
+    // Q8 metres from the origin
+    const int32_t measured[2] = {north * 256, east * 256};
+
+    if (track.fixes == 1) {
+        if (static_cast<uint32_t>(elapsed) < MIN_BASELINE_MS) {
+            start(track, fix, timeMs);
+            return Result::STARTED;
+        }
+
+        // Velocity from the two fixes, with the variance of a difference of two measurements
+        const int64_t dtMs = elapsed;
+        for (size_t axis = 0; axis < 2; axis++) {
+            track.velocity[axis] = clampVelocity((static_cast<int64_t>(measured[axis]) - track.position[axis]) * 1000 / dtMs);
+            track.position[axis] = measured[axis];
+        }
+        track.covariance.p00 = MEASUREMENT_VAR_M2 * ONE_Q8;
+        track.covariance.p01 = MEASUREMENT_VAR_M2 * ONE_Q8 * 1000 / dtMs;
+        track.covariance.p11 = 2 * MEASUREMENT_VAR_M2 * ONE_Q8 * 1'000'000 / (dtMs * dtMs);
+        track.last = fix;
+        track.timeMs = timeMs;
+        track.fixes = 2;
+        return Result::ACCEPTED;
+    }
+
+    const int64_t dt = toQ16Seconds(static_cast<uint32_t>(elapsed));
+    const Covariance predicted = propagate(track.covariance, static_cast<uint32_t>(elapsed));
+
+    // Innovation of each axis against the constant velocity prediction, Q8 metres
+    int64_t extrapolated[2];
+    int64_t innovation[2];
+    int64_t distance2 = 0;
+    for (size_t axis = 0; axis < 2; axis++) {
+        extrapolated[axis] = track.position[axis] + ((track.velocity[axis] * dt) >> 16);
+        innovation[axis] = measured[axis] - extrapolated[axis];
+        distance2 += innovation[axis] * innovation[axis];
+    }
+
+    // Innovation variance in whole m^2, the same along both axes
+    const int64_t s = (predicted.p00 >> 8) + MEASUREMENT_VAR_M2;
+    if (distance2 > OUTLIER_GATE * (s << 16)) {
+        if (++track.outliers >= MAX_OUTLIERS) {
+            start(track, fix, timeMs);
+            return Result::STARTED;
+        }
+        return Result::OUTLIER;
+    }
+
+    // Gains in Q16
+    const int64_t k0 = (predicted.p00 << 8) / s;
+    const int64_t k1 = (predicted.p01 << 8) / s;
+    for (size_t axis = 0; axis < 2; axis++) {
+        track.position[axis] = static_cast<int32_t>(extrapolated[axis] + ((k0 * innovation[axis]) >> 16));
+        track.velocity[axis] = clampVelocity(track.velocity[axis] + ((k1 * innovation[axis]) >> 16));
+    }
+
+    track.covariance.p00 = predicted.p00 - ((k0 * predicted.p00) >> 16);
+    track.covariance.p01 = predicted.p01 - ((k0 * predicted.p01) >> 16);
+    track.covariance.p11 = predicted.p11 - ((k1 * predicted.p01) >> 16);
+    track.last = fix;
+    track.timeMs = timeMs;
+    track.outliers = 0;
+    return Result::ACCEPTED;
+}
+
+bool PositionPredictor::predict(const uint8_t nodeId, const uint32_t nowMs, Prediction& out) const {
+    if (nodeId > MAX_NODE_ID || tracks[nodeId].fixes == 0) {
+        return false;
+    }
+
+    const Track& track = tracks[nodeId];
+    const int32_t elapsed = static_cast<int32_t>(nowMs - track.timeMs);
+    const uint32_t ageMs = elapsed > 0 ? static_cast<uint32_t>(elapsed) : 0;
+    const uint32_t dtMs = ageMs < MAX_GAP_MS ? ageMs : MAX_GAP_MS;
+    const int64_t dt = toQ16Seconds(dtMs);
+
+    int32_t offset[2];
+    for (size_t axis = 0; axis < 2; axis++) {
+        const int64_t position = track.position[axis] + ((track.velocity[axis] * dt) >> 16);
+        offset[axis] = static_cast<int32_t>(position / 256);
+    }
+
+    out.position = offsetPosition(track.origin, offset[0], offset[1]);
+    out.position.satellites_cnt = track.last.satellites_cnt;
+    out.position.fix_status = track.last.fix_status;
+    out.uncertaintyM = isqrt64(static_cast<uint64_t>(std::max<int64_t>(propagate(track.covariance, dtMs).p00, 0) >> 8));
+    out.northCmPerS = track.velocity[0] * 100 / 256;
+    out.eastCmPerS = track.velocity[1] * 100 / 256;
+    out.ageMs = ageMs;
+    return true;
+}
+
+void PositionPredictor::reset() {
+    for (Track& track : tracks) {
+        track.fixes = 0;
+    }
+}
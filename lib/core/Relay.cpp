@@ -0,0 +1,62 @@
+#include "core/Relay.h"
+
+#include <cstring>
+
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(Relay);
+
+#ifdef CONFIG_RELAY
+
+bool RelayCache::offer(const uint8_t* data, size_t size, const uint32_t nowMs) {
+    uint8_t hops = 0;
+
+    const size_t prefix = framePrefixSize(data, size);
+    if (size > prefix + RELAY_HEADER_SIZE && data[prefix] == static_cast<uint8_t>(FrameType::RELAY)) {
+        RelayFrame envelope{};
+        memcpy(&envelope, data + prefix, sizeof(envelope));
+        hops = envelope.hops;
+        data += prefix + RELAY_HEADER_SIZE;
+        size -= prefix + RELAY_HEADER_SIZE;
+    }
+
+    FrameId id{};
+    if (!identifyFrame(data, size, id) || id.nodeId == ownNodeId) {
+        return false;
+    }
+
+    if (!seen.markSeen(id, nowMs)) {
+        return false;
+    }
+
+    if (hops >= CONFIG_RELAY_MAX_HOPS || size > RELAY_MAX_INNER_SIZE) {
+        return false;
+    }
+
+    Entry& entry = entries[id.nodeId];
+    memcpy(entry.data, data, size);
+    entry.size = static_cast<uint8_t>(size);
+    entry.hops = hops + 1;
+    entry.pending = true;
+
+    LOG_DBG("Cached frame %u from node %u (%u hops)", id.seq, id.nodeId, entry.hops);
+    return true;
+}
+
+size_t RelayCache::takeNext(uint8_t* out, uint8_t& hops) {
+    for (size_t i = 0; i <= MAX_NODE_ID; i++) {
+        Entry& entry = entries[nextNode];
+        nextNode = (nextNode + 1) % (MAX_NODE_ID + 1);
+
+        if (entry.pending) {
+            entry.pending = false;
+            memcpy(out, entry.data, entry.size);
+            hops = entry.hops;
+            return entry.size;
+        }
+    }
+
+    return 0;
+}
+
+#endif
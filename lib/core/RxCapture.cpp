@@ -0,0 +1,81 @@
+#include "core/RxCapture.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static int hexValue(const char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+size_t formatRxCapture(char* out, const RxCaptureRecord& record) {
+    static constexpr char digits[] = "0123456789abcdef";
+
+    int len = snprintf(out, RX_CAPTURE_LINE_SIZE, "%s %" PRIu64 " %d %d ", RX_CAPTURE_PREFIX, record.arrivalUs,
+                       record.rssi, record.snr);
+    if (len < 0) {
+        return 0;
+    }
+
+    size_t pos = static_cast<size_t>(len);
+    for (size_t i = 0; i < record.size; i++) {
+        out[pos++] = digits[record.data[i] >> 4];
+        out[pos++] = digits[record.data[i] & 0x0F];
+    }
+    out[pos] = '\0';
+
+    return pos;
+}
+
+bool parseRxCapture(const char* line, RxCaptureRecord& record) {
+    const size_t prefixLen = strlen(RX_CAPTURE_PREFIX);
+    if (strncmp(line, RX_CAPTURE_PREFIX, prefixLen) != 0 || line[prefixLen] != ' ') {
+        return false;
+    }
+
+    char* end = nullptr;
+    const char* pos = line + prefixLen;
+    record.arrivalUs = strtoull(pos, &end, 10);
+    if (end == pos) {
+        return false;
+    }
+    pos = end;
+
+    const long rssi = strtol(pos, &end, 10);
+    if (end == pos || rssi < INT16_MIN || rssi > INT16_MAX) {
+        return false;
+    }
+    record.rssi = static_cast<int16_t>(rssi);
+    pos = end;
+
+    const long snr = strtol(pos, &end, 10);
+    if (end == pos || snr < INT8_MIN || snr > INT8_MAX || *end != ' ') {
+        return false;
+    }
+    record.snr = static_cast<int8_t>(snr);
+    pos = end + 1;
+
+    size_t size = 0;
+    while (pos[0] != '\0' && pos[0] != '\r' && pos[0] != '\n') {
+        const int high = hexValue(pos[0]);
+        const int low = high < 0 ? -1 : hexValue(pos[1]);
+        if (low < 0 || size >= RX_CAPTURE_MAX_FRAME) {
+            return false;
+        }
+        record.data[size++] = static_cast<uint8_t>((high << 4) | low);
+        pos += 2;
+    }
+
+    record.size = static_cast<uint8_t>(size);
+    return size > 0;
+}
@@ -5,54 +5,216 @@
 
 #include "core/Settings.h"
 
+#include "core/Coordinates.h"
+#include "core/UbxAiding.h"
+#include "core/defs.h"
+
 #include <cstdlib>
 #include <cstring>
+#include <zephyr/drivers/lora.h>
+#include <zephyr/kernel.h>
 #include <zephyr/settings/settings.h>
 #include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
 
 #ifdef CONFIG_SHELL
 #include <zephyr/shell/shell.h>
 #endif
 
-#if defined(CONFIG_SHELL_FREQUENCY) || defined(CONFIG_LICENSED_FREQUENCY) || defined(CONFIG_SHELL_NODE_ID)
+#ifdef CONFIG_SETTINGS
 
 LOG_MODULE_REGISTER(Settings);
 
-static uint32_t CONFIGURED_FREQUENCY = Settings::DEFAULT_FREQUENCY;
+using Settings::Descriptor;
+using Settings::Id;
+using Settings::Type;
+
+namespace {
+constexpr size_t SETTING_COUNT = static_cast<size_t>(Id::COUNT);
+
+// Keys are those saved by earlier firmware, so settings survive an update
+constexpr Descriptor REGISTRY[] = {
+    {Id::FREQUENCY, "freq", "freq", "LoRa frequency in MHz (e.g. 903.123456)", Type::UINT, sizeof(uint32_t), 6,
+     IS_ENABLED(CONFIG_SHELL_FREQUENCY),
 #ifdef CONFIG_LICENSED_FREQUENCY
-static char CONFIGURED_CALLSIGN[Settings::CALLSIGN_LEN] = {};
+     420'000'000, 450'000'000,
+#else
+     902'000'000, 928'000'000,
 #endif
-static uint8_t CONFIGURED_NODE_ID = Settings::DEFAULT_NODE_ID;
-
-static int settings_set_handler(const char *name, size_t len,
-                                settings_read_cb readCallback, void *callbackArgs) {
-#ifdef CONFIG_SHELL_FREQUENCY
-    if (strcmp(name, "freq") == 0) {
-        if (len != sizeof(uint32_t)) {
-            return -EINVAL;
+     Settings::DEFAULT_FREQUENCY},
+    {Id::CALLSIGN, "cs", "callsign", "Callsign, 4-6 chars (e.g. W1ABC)", Type::TEXT, Settings::CALLSIGN_LEN, 0,
+     IS_ENABLED(CONFIG_LICENSED_FREQUENCY), 4, Settings::CALLSIGN_LEN, 0},
+    {Id::NODE_ID, "nid", "node_id", "Node ID (0-9)", Type::UINT, sizeof(uint8_t), 0, IS_ENABLED(CONFIG_SHELL_NODE_ID),
+     0, MAX_NODE_ID, Settings::DEFAULT_NODE_ID},
+    {Id::TX_PERIOD, "txp", "period", "Time between frames in ms (1000-3600000)", Type::UINT, sizeof(uint32_t), 0,
+     IS_ENABLED(CONFIG_SHELL_TX_PERIOD), 1'000, 3'600'000, Settings::DEFAULT_TX_PERIOD_MS},
+    {Id::DATARATE, "sf", "sf", "Spreading factor (7-12)", Type::UINT, sizeof(uint8_t), 0,
+     IS_ENABLED(CONFIG_SHELL_RADIO), SF_7, SF_12, SF_10},
+    {Id::TX_POWER, "pwr", "power", "Transmit power in dBm (2-20)", Type::UINT, sizeof(uint8_t), 0,
+     IS_ENABLED(CONFIG_SHELL_RADIO), 2, 20, 20},
+    {Id::HOP_CHANNELS, "hopn", "channels", "Channels hopped over, 1 to stay on freq (1-16)", Type::UINT,
+     sizeof(uint8_t), 0, IS_ENABLED(CONFIG_FREQUENCY_HOPPING), 1, 16, Settings::DEFAULT_HOP_CHANNELS},
+    {Id::HOP_SPACING, "hops", "spacing", "Channel spacing above freq in MHz (0.125-4)", Type::UINT,
+     sizeof(uint32_t), 6, IS_ENABLED(CONFIG_FREQUENCY_HOPPING), 125'000, 4'000'000, Settings::DEFAULT_HOP_SPACING},
+    {Id::LAST_FIX, "lfix", "", "", Type::BLOB, sizeof(AidingFix), 0, false, 0, 0, 0},
+};
+
+constexpr bool registryInOrder() {
+    for (size_t i = 0; i < SETTING_COUNT; i++) {
+        const Descriptor& setting = REGISTRY[i];
+        const bool sized = setting.type != Type::UINT || setting.size == 1 || setting.size == 2 || setting.size == 4;
+        if (static_cast<size_t>(setting.id) != i || !sized || setting.min > setting.max) {
+            return false;
         }
-        readCallback(callbackArgs, &CONFIGURED_FREQUENCY, sizeof(uint32_t));
-        return 0;
     }
-#endif
+    return true;
+}
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-    if (strcmp(name, "cs") == 0) {
-        const size_t to_read = len < static_cast<size_t>(Settings::CALLSIGN_LEN)
-                                   ? len
-                                   : static_cast<size_t>(Settings::CALLSIGN_LEN);
-        readCallback(callbackArgs, CONFIGURED_CALLSIGN, to_read);
-        return 0;
+static_assert(sizeof(REGISTRY) / sizeof(REGISTRY[0]) == SETTING_COUNT, "Every setting needs a table entry");
+static_assert(registryInOrder(), "Table entries must be in Id order, with valid sizes and ranges");
+static_assert(SETTING_COUNT <= 32, "Dirty and saved flags are 32 bit masks");
+
+// Each setting's bytes, at the sum of the sizes before it
+constexpr size_t offsetOf(const size_t index) {
+    size_t offset = 0;
+    for (size_t i = 0; i < index; i++) {
+        offset += REGISTRY[i].size;
     }
-#endif
+    return offset;
+}
+
+struct Offsets {
+    size_t offset[SETTING_COUNT + 1];
+};
+
+constexpr Offsets computeOffsets() {
+    Offsets offsets{};
+    for (size_t i = 0; i <= SETTING_COUNT; i++) {
+        offsets.offset[i] = offsetOf(i);
+    }
+    return offsets;
+}
+
+constexpr Offsets OFFSETS = computeOffsets();
+
+uint8_t storage[OFFSETS.offset[SETTING_COUNT]];
+// Changed since the last commit, and loaded or changed since boot
+uint32_t dirty;
+uint32_t saved;
+
+Settings::ApplyHandler applyHandler;
+void* applyUserData;
+
+// Changes from other threads are applied on the system work queue, which drives the radio
+void applyWorkHandler(k_work* work);
+K_WORK_DEFINE(applyWork, applyWorkHandler);
+K_MUTEX_DEFINE(applyLock);
+Id applyId;
+uint32_t applyValue;
+bool applied;
+
+void applyWorkHandler(k_work* work) {
+    applied = applyHandler(applyId, applyValue, applyUserData);
+}
+
+bool apply(const Id id, const uint32_t value) {
+    if (applyHandler == nullptr) {
+        return true;
+    }
+    if (k_current_get() == k_work_queue_thread_get(&k_sys_work_q)) {
+        return applyHandler(id, value, applyUserData);
+    }
+
+    k_mutex_lock(&applyLock, K_FOREVER);
+    applyId = id;
+    applyValue = value;
+    k_work_submit(&applyWork);
+    k_work_sync sync;
+    k_work_flush(&applyWork, &sync);
+    const bool result = applied;
+    k_mutex_unlock(&applyLock);
+    return result;
+}
+
+uint8_t* valueOf(const Id id) {
+    return storage + OFFSETS.offset[static_cast<size_t>(id)];
+}
+
+uint32_t readUint(const Descriptor& setting) {
+    const uint8_t* value = valueOf(setting.id);
+    switch (setting.size) {
+    case sizeof(uint8_t):
+        return *value;
+    case sizeof(uint16_t): {
+        uint16_t out;
+        memcpy(&out, value, sizeof(out));
+        return out;
+    }
+    default: {
+        uint32_t out;
+        memcpy(&out, value, sizeof(out));
+        return out;
+    }
+    }
+}
+
+void writeUint(const Descriptor& setting, const uint32_t value) {
+    uint8_t* out = valueOf(setting.id);
+    switch (setting.size) {
+    case sizeof(uint8_t):
+        *out = static_cast<uint8_t>(value);
+        break;
+    case sizeof(uint16_t): {
+        const uint16_t narrow = static_cast<uint16_t>(value);
+        memcpy(out, &narrow, sizeof(narrow));
+        break;
+    }
+    default:
+        memcpy(out, &value, sizeof(value));
+        break;
+    }
+}
+
+void resetToDefault(const Descriptor& setting) {
+    memset(valueOf(setting.id), 0, setting.size);
+    if (setting.type == Type::UINT) {
+        writeUint(setting, setting.defaultValue);
+    }
+}
+
+uint32_t flag(const Id id) {
+    return 1U << static_cast<size_t>(id);
+}
+}
+
+static int settings_set_handler(const char *name, size_t len, settings_read_cb readCallback, void *callbackArgs) {
+    for (const Descriptor& setting : REGISTRY) {
+        if (strcmp(name, setting.key) != 0) {
+            continue;
+        }
+
+        // Text may have been saved shorter, the rest stays zero
+        const bool fits = setting.type == Type::TEXT ? len <= setting.size : len == setting.size;
+        if (!fits) {
+            return -EINVAL;
+        }
+
+        resetToDefault(setting);
+        if (len > 0 && readCallback(callbackArgs, valueOf(setting.id), len) != static_cast<ssize_t>(len)) {
+            resetToDefault(setting);
+            return -EIO;
+        }
 
-#ifdef CONFIG_SHELL_NODE_ID
-    if (strcmp(name, "nid") == 0) {
-        if (len != sizeof(uint8_t)) return -EINVAL;
-        readCallback(callbackArgs, &CONFIGURED_NODE_ID, sizeof(uint8_t));
+        if (setting.type == Type::UINT && (readUint(setting) < setting.min || readUint(setting) > setting.max)) {
+            LOG_WRN("Saved %s out of range, using default", setting.key);
+            resetToDefault(setting);
+            return 0;
+        }
+
+        saved |= flag(setting.id);
         return 0;
     }
-#endif
     return -ENOENT;
 }
 
@@ -61,6 +223,12 @@ SETTINGS_STATIC_HANDLER_DEFINE(config, "config", nullptr, settings_set_handler,
 namespace Settings {
 
 int load() {
+    for (const Descriptor& setting : REGISTRY) {
+        resetToDefault(setting);
+    }
+    dirty = 0;
+    saved = 0;
+
     int ret = settings_subsys_init();
     if (ret != 0) {
         LOG_ERR("settings_subsys_init failed: %d", ret);
@@ -73,142 +241,188 @@ int load() {
     return ret;
 }
 
-#ifdef CONFIG_SHELL_FREQUENCY
-uint32_t getFrequency() {
-    LOG_INF("Loaded frequency: %f MHz", static_cast<double>(CONFIGURED_FREQUENCY) / 1'000'000);
-    return CONFIGURED_FREQUENCY;
+const Descriptor& describe(const Id id) {
+    return REGISTRY[static_cast<size_t>(id)];
 }
 
-int saveFrequency(uint32_t frequency) {
-    CONFIGURED_FREQUENCY = frequency;
-    const int ret = settings_save_one("config/freq", &frequency, sizeof(frequency));
-    if (ret != 0) {
-        LOG_ERR("settings_save_one(config/freq) failed: %d", ret);
+uint32_t get(const Id id) {
+    const Descriptor& setting = describe(id);
+    return setting.type == Type::UINT ? readUint(setting) : 0;
+}
+
+int set(const Id id, const uint32_t value) {
+    const Descriptor& setting = describe(id);
+    if (setting.type != Type::UINT || value < setting.min || value > setting.max) {
+        return -EINVAL;
     }
-    return ret;
+    if (!apply(id, value)) {
+        return -EIO;
+    }
+
+    writeUint(setting, value);
+    dirty |= flag(id);
+    saved |= flag(id);
+    return 0;
 }
-#endif
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-void getCallsign(char out[CALLSIGN_LEN]) {
-    memcpy(out, CONFIGURED_CALLSIGN, CALLSIGN_LEN);
+bool getBytes(const Id id, void* out, const size_t size) {
+    const Descriptor& setting = describe(id);
+    const size_t copied = size < setting.size ? size : setting.size;
+    memcpy(out, valueOf(id), copied);
+    memset(static_cast<uint8_t*>(out) + copied, 0, size - copied);
+    return (saved & flag(id)) != 0;
 }
 
-int saveCallsign(const char callsign[CALLSIGN_LEN]) {
-    memcpy(CONFIGURED_CALLSIGN, callsign, CALLSIGN_LEN);
-    const int ret = settings_save_one("config/cs", callsign, CALLSIGN_LEN);
-    if (ret != 0) {
-        LOG_ERR("settings_save_one(config/cs) failed: %d", ret);
+int setBytes(const Id id, const void* data, const size_t size) {
+    const Descriptor& setting = describe(id);
+    if (setting.type == Type::UINT || size > setting.size) {
+        return -EINVAL;
+    }
+    if (!apply(id, 0)) {
+        return -EIO;
     }
-    return ret;
-}
-#endif
 
-#ifdef CONFIG_SHELL_NODE_ID
-uint8_t getNodeId() {
-    return CONFIGURED_NODE_ID;
+    memset(valueOf(id), 0, setting.size);
+    memcpy(valueOf(id), data, size);
+    dirty |= flag(id);
+    saved |= flag(id);
+    return 0;
 }
 
-int saveNodeId(uint8_t nodeId) {
-    if (nodeId < 0 || nodeId > 9) return -EINVAL;
-    CONFIGURED_NODE_ID = nodeId;
-    const int ret = settings_save_one("config/nid", &nodeId, sizeof(nodeId));
-    if (ret != 0) {
-        LOG_ERR("settings_save_one(config/nid) failed: %d", ret);
+int commit() {
+    char key[16];
+    int first = 0;
+
+    for (const Descriptor& setting : REGISTRY) {
+        if ((dirty & flag(setting.id)) == 0) {
+            continue;
+        }
+
+        snprintk(key, sizeof(key), "config/%s", setting.key);
+        const int ret = settings_save_one(key, valueOf(setting.id), setting.size);
+        if (ret != 0) {
+            LOG_ERR("settings_save_one(%s) failed: %d", key, ret);
+            first = first != 0 ? first : ret;
+            continue;
+        }
+        dirty &= ~flag(setting.id);
     }
-    return ret;
+    return first;
 }
-#endif
-} // namespace OutlawSettings
+
+void setApplyHandler(const ApplyHandler handler, void* userData) {
+    applyHandler = handler;
+    applyUserData = userData;
+}
+
+} // namespace Settings
 
 #ifdef CONFIG_SHELL
 
-#ifdef CONFIG_SHELL_FREQUENCY
-static int cmd_freq(const struct shell *sh, size_t argc, char **argv) {
-    char *end;
-    const float freq = strtof(argv[1], &end);
-    if (*end != '\0' || freq < 902.0f || freq > 928.0f) {
-        shell_error(sh, "Invalid frequency '%s' (902.0 - 928.0)", argv[1]);
-        return -EINVAL;
+namespace {
+const Descriptor* findShellSetting(const char* name) {
+    for (const Descriptor& setting : REGISTRY) {
+        if (setting.shell && strcmp(name, setting.name) == 0) {
+            return &setting;
+        }
     }
-    const int ret = Settings::saveFrequency(static_cast<uint32_t>(freq * 1'000'000));
+    return nullptr;
+}
 
-    if (ret == 0) {
-        shell_print(sh, "Frequency saved: %f Mhz (reboot to apply)", static_cast<double>(freq));
+void printSetting(const struct shell *sh, const Descriptor& setting, const char* note) {
+    char value[FIXED_POINT_TEXT_SIZE] = {};
+    if (setting.type == Type::TEXT) {
+        Settings::getBytes(setting.id, value, Settings::CALLSIGN_LEN);
     } else {
-        shell_error(sh, "Save failed: %d", ret);
+        formatFixedPoint(value, static_cast<int32_t>(Settings::get(setting.id)), setting.decimals, setting.decimals);
     }
-    return ret;
+    shell_print(sh, "%s: %s%s", setting.name, value, note);
 }
-#endif
-
-#ifdef CONFIG_LICENSED_FREQUENCY
 
-static int cmd_callsign(const struct shell *sh, size_t argc, char **argv) {
-    const size_t len = strlen(argv[1]);
-    if (len < 4) {
-        shell_warn(sh, "Callsigns must be at least 4 characters. Assuming no callsign and suspending transmission upon reboot.");
-        const int ret = Settings::saveCallsign("");
-        if (ret != 0) {
-            shell_error(sh, "Save failed: %d", ret);
-        }
-        return ret;
-    } else if (len > (size_t)Settings::CALLSIGN_LEN) {
-        shell_error(sh, "Callsign must be 1-%d characters", Settings::CALLSIGN_LEN);
+int setText(const struct shell *sh, const Descriptor& setting, const char* text) {
+    const size_t len = strlen(text);
+    if (len > setting.max) {
+        shell_error(sh, "%s must be at most %u characters", setting.name, setting.max);
         return -EINVAL;
     }
-    char cs[Settings::CALLSIGN_LEN] = {};
-    memcpy(cs, argv[1], len);
-    const int ret = Settings::saveCallsign(cs);
-    if (ret == 0) {
-        shell_print(sh, "Callsign saved: %.*s (reboot to apply)", Settings::CALLSIGN_LEN, cs);
-    } else {
-        shell_error(sh, "Save failed: %d", ret);
+
+    if (len < setting.min) {
+        shell_warn(sh, "%s must be at least %u characters. Clearing it, which suspends transmission upon reboot.",
+                   setting.name, setting.min);
+        return Settings::setBytes(setting.id, "", 0);
     }
-    return ret;
+    return Settings::setBytes(setting.id, text, len);
 }
 
-#endif
-
-#ifdef CONFIG_SHELL_NODE_ID
+// Handler for every generated subcommand, which finds its setting by its own name
+int cmd_setting(const struct shell *sh, size_t argc, char **argv) {
+    const Descriptor* setting = findShellSetting(argv[0]);
+    if (setting == nullptr) {
+        return -ENOENT;
+    }
 
-static int cmd_node_id(const struct shell *sh, size_t argc, char **argv) {
-    char *end;
-    const unsigned long id = strtoul(argv[1], &end, 10);
-    if (*end != '\0' || id < 0 || id > 9) {
-        shell_error(sh, "Invalid node ID '%s' (expected 0-9)", argv[1]);
-        return -EINVAL;
+    if (argc < 2) {
+        printSetting(sh, *setting, "");
+        return 0;
     }
-    const int ret = Settings::saveNodeId(static_cast<uint8_t>(id));
-    if (ret == 0) {
-        shell_print(sh, "Node ID saved: %lu (reboot to apply)", id);
+
+    int ret = 0;
+    if (setting->type == Type::TEXT) {
+        ret = setText(sh, *setting, argv[1]);
     } else {
-        shell_error(sh, "Save failed: %d", ret);
+        uint32_t value = 0;
+        if (!parseFixedPoint(argv[1], setting->decimals, value)) {
+            shell_error(sh, "Invalid %s '%s'", setting->name, argv[1]);
+            return -EINVAL;
+        }
+        ret = Settings::set(setting->id, value);
+        if (ret == -EINVAL) {
+            char min[FIXED_POINT_TEXT_SIZE];
+            char max[FIXED_POINT_TEXT_SIZE];
+            formatFixedPoint(min, static_cast<int32_t>(setting->min), setting->decimals, setting->decimals);
+            formatFixedPoint(max, static_cast<int32_t>(setting->max), setting->decimals, setting->decimals);
+            shell_error(sh, "Invalid %s '%s' (%s - %s)", setting->name, argv[1], min, max);
+            return ret;
+        }
     }
-    return ret;
-}
-#endif
 
-#if defined(CONFIG_SHELL_FREQUENCY) || defined(CONFIG_LICENSED_FREQUENCY) || defined(CONFIG_SHELL_NODE_ID)
-SHELL_STATIC_SUBCMD_SET_CREATE(sub_config,
-#ifdef CONFIG_SHELL_FREQUENCY
-    SHELL_CMD_ARG(freq, NULL, "Set LoRa frequency in Mhz (e.g. 903.123456)", cmd_freq, 2, 0),
-#endif
+    if (ret == 0) {
+        ret = Settings::commit();
+    }
+    if (ret != 0) {
+        shell_error(sh, "Failed to set %s: %d", setting->name, ret);
+        return ret;
+    }
 
-#ifdef CONFIG_LICENSED_FREQUENCY
-    SHELL_CMD_ARG(callsign, NULL, "Set callsign, max 6 chars (e.g. W1ABC)", cmd_callsign, 2, 0),
-#endif
+    // Text and blobs are only read at boot
+    const bool applied = applyHandler != nullptr && setting->type == Type::UINT;
+    printSetting(sh, *setting, applied ? " (saved)" : " (saved, reboot to apply)");
+    return 0;
+}
 
-#ifdef CONFIG_SHELL_NODE_ID
-    SHELL_CMD_ARG(node_id, NULL, "Set node ID (0-9)", cmd_node_id, 2, 0),
-#endif
-    SHELL_SUBCMD_SET_END
-);
+void getSettingCmd(size_t index, struct shell_static_entry *entry) {
+    entry->syntax = nullptr;
+    for (const Descriptor& setting : REGISTRY) {
+        if (!setting.shell) {
+            continue;
+        }
+        if (index-- == 0) {
+            entry->syntax = setting.name;
+            entry->help = setting.help;
+            entry->subcmd = nullptr;
+            entry->handler = cmd_setting;
+            entry->args.mandatory = 1;
+            entry->args.optional = 1;
+            return;
+        }
+    }
+}
+}
 
-SHELL_CMD_REGISTER(config, &sub_config, "Configure settings", NULL);
+SHELL_DYNAMIC_CMD_CREATE(sub_config, getSettingCmd);
 
-#endif
+SHELL_CMD_REGISTER(config, &sub_config, "Show or set a saved setting: config <setting> [value]", NULL);
 
 #endif // CONFIG_SHELL
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "core/SfScanner.h"
+
+#ifdef CONFIG_SF_SCAN
+
+#include <zephyr/logging/log.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+#include "core/LoraTransceiver.h"
+#include "core/defs.h"
+
+LOG_MODULE_REGISTER(sf_scanner);
+
+namespace {
+// Largest frame the hunter receives, a full relay envelope
+constexpr size_t MAX_FRAME_SIZE = TX_PREFIX_SIZE + RELAY_HEADER_SIZE + RELAY_MAX_INNER_SIZE;
+
+uint32_t average(const uint64_t total, const uint32_t count) {
+    return count == 0 ? 0 : static_cast<uint32_t>(total / count);
+}
+}
+
+SfScanner* SfScanner::shellInstance = nullptr;
+
+SfScanner::SfScanner(LoraTransceiver& lora) : lora(lora) {
+    for (int sf = SF_7; sf <= SF_12; sf++) {
+        if (CONFIG_SF_SCAN_RATES & BIT(sf)) {
+            rates[rateCount++] = static_cast<lora_datarate>(sf);
+        }
+    }
+    stepWork.owner = this;
+    k_work_init_delayable(&stepWork.work, stepWorkHandler);
+    shellInstance = this;
+}
+
+void SfScanner::start() {
+    if (rateCount == 0) {
+        LOG_ERR("No spreading factors to scan");
+        return;
+    }
+
+    LOG_INF("Scanning %u spreading factors, %u symbols each", rateCount, CONFIG_SF_SCAN_DWELL_SYMBOLS);
+    state = State::SCANNING;
+    current = rateCount - 1;
+    lastReportUs = nowUs();
+    next();
+}
+
+void SfScanner::stepWorkHandler(k_work* work) {
+    auto* delayable = k_work_delayable_from_work(work);
+    CONTAINER_OF(delayable, StepWork, work)->owner->step();
+}
+
+void SfScanner::step() {
+    if (lora.isTx()) {
+        // A downlink or beacon is on air, whoever sent it returns the modem to RX
+        cycleInterrupted = true;
+        k_work_schedule(&stepWork.work, K_USEC(CONFIG_SF_SCAN_DWELL_SYMBOLS * lora.symbolUs()));
+        return;
+    }
+
+    if (state == State::LOCKED) {
+        // Noise that looked like a preamble, or a frame that failed its header or CRC
+        stats.missed++;
+        state = State::SCANNING;
+        next();
+        return;
+    }
+
+    if (lora.preambleDetected()) {
+        state = State::LOCKED;
+        lockUs = nowUs();
+        stats.locks++;
+        cycleInterrupted = true;
+        // Detection comes after the preamble started, so a whole frame's airtime is margin enough
+        k_work_schedule(&stepWork.work, K_USEC(lora.timeOnAirUs(MAX_FRAME_SIZE)));
+        return;
+    }
+
+    next();
+}
+
+void SfScanner::next() {
+    current = (current + 1) % rateCount;
+    if (current == 0) {
+        const uint64_t now = nowUs();
+        if (!cycleInterrupted) {
+            const auto cycleUs = static_cast<uint32_t>(now - cycleStartUs);
+            stats.cycles++;
+            stats.cycleUsTotal += cycleUs;
+            stats.cycleUsMax = MAX(stats.cycleUsMax, cycleUs);
+        }
+        cycleStartUs = now;
+        cycleInterrupted = false;
+
+        if (CONFIG_SF_SCAN_REPORT_S > 0 && now - lastReportUs >= CONFIG_SF_SCAN_REPORT_S * 1'000'000ULL) {
+            lastReportUs = now;
+            report();
+        }
+    }
+
+    if (rateCount > 1 || lora.datarate() != rates[current]) {
+        lora.awaitCancel();
+        lora.setDatarate(rates[current]);
+        lora.awaitRxPacket();
+    }
+    k_work_schedule(&stepWork.work, K_USEC(CONFIG_SF_SCAN_DWELL_SYMBOLS * lora.symbolUs()));
+}
+
+void SfScanner::onFrame(const uint32_t timeOnAirUs) {
+    // The receive callback runs on the system work queue like the scan, so nothing to lock
+    if (state != State::LOCKED) {
+        stats.unlocked++;
+        return;
+    }
+
+    // The frame ended just now, its preamble started one airtime ago
+    const uint64_t preambleUs = nowUs() - timeOnAirUs;
+    const auto latencyUs = static_cast<uint32_t>(lockUs > preambleUs ? lockUs - preambleUs : 0);
+    stats.frames++;
+    stats.latencyUsTotal += latencyUs;
+    stats.latencyUsMax = MAX(stats.latencyUsMax, latencyUs);
+
+    // Stay one more dwell, so replies to the frame go out on its spreading factor first
+    state = State::SCANNING;
+    k_work_reschedule(&stepWork.work, K_USEC(CONFIG_SF_SCAN_DWELL_SYMBOLS * lora.symbolUs()));
+}
+
+void SfScanner::report() const {
+    const uint32_t missedPermille = stats.locks == 0 ? 0 : stats.missed * 1000U / stats.locks;
+    LOG_INF("SF scan: %u cycles, %u us average, %u us max", stats.cycles,
+            average(stats.cycleUsTotal, stats.cycles), stats.cycleUsMax);
+    LOG_INF("SF scan: %u preambles, %u frames, %u missed (%u.%u%%), %u unlocked", stats.locks, stats.frames,
+            stats.missed, missedPermille / 10, missedPermille % 10, stats.unlocked);
+    LOG_INF("SF scan: detection latency %u us average, %u us max",
+            average(stats.latencyUsTotal, stats.frames), stats.latencyUsMax);
+}
+
+#ifdef CONFIG_SHELL
+
+static int cmd_sfscan(const struct shell *sh, size_t argc, char **argv) {
+    const SfScanner* scanner = SfScanner::instance();
+    if (!scanner) {
+        shell_error(sh, "Scanner not started");
+        return -ENODEV;
+    }
+
+    const SfScanner::Counters& stats = scanner->counters();
+    shell_print(sh, "Cycles: %u, %u us average, %u us max", stats.cycles,
+                average(stats.cycleUsTotal, stats.cycles), stats.cycleUsMax);
+    shell_print(sh, "Preambles: %u, frames: %u, missed: %u, unlocked: %u", stats.locks, stats.frames,
+                stats.missed, stats.unlocked);
+    shell_print(sh, "Detection latency: %u us average, %u us max", average(stats.latencyUsTotal, stats.frames),
+                stats.latencyUsMax);
+    return 0;
+}
+
+SHELL_CMD_REGISTER(sfscan, NULL, "Show spreading factor scan counters", cmd_sfscan);
+
+#endif
+
+#endif
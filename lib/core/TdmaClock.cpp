@@ -1,16 +1,26 @@
 #include <core/TdmaClock.h>
 
-#include <zephyr/drivers/counter.h>
+#include <core/EventTrace.h>
+
 #include <zephyr/logging/log.h>
 
+#include <cstdlib>
 #include <utility>
 
 LOG_MODULE_REGISTER(tdma_clock, LOG_LEVEL_INF);
 
 namespace {
-constexpr uint32_t frameLenMs = 1000;
+constexpr uint64_t frameLenNs = TdmaClock::FRAME_LEN_MS * 1'000'000ULL;
 constexpr uint32_t gpsDemoteMs = 5000;
 constexpr uint32_t hunterStaleMs = 30000;
+
+// PPS intervals further than this from nominal are missed or spurious edges
+constexpr int32_t maxDriftPpb = 20'000'000;
+// Assumed oscillator error before any PPS interval has been measured (HSI trim limit)
+constexpr int32_t unknownDriftPpb = 10'000'000;
+// Samples before the estimate is used, and the EWMA weight (1/2^n) once it is
+constexpr uint16_t minDriftSamples = 8;
+constexpr uint32_t driftFilterShift = 3;
 }
 
 TdmaClock& TdmaClock::instance() {
@@ -18,38 +28,30 @@ TdmaClock& TdmaClock::instance() {
     return clock;
 }
 
-void TdmaClock::init(const gpio_dt_spec* pps, const device* tim2Dev) {
-    ppsSpec = pps;
-    tim2 = tim2Dev;
-    ppsConfigured = false;
+void TdmaClock::init(TimestampService& timestampService) {
+    timestamps = &timestampService;
 
     atomic_set(&currentSource, static_cast<atomic_val_t>(Source::FREERUN));
     atomic_set(&epochTicksValue, 0);
     atomic_set(&frameNumberValue, 0);
     atomic_set(&lastHunterUptimeMs, 0);
 
+    sync = {};
+
     k_timer_init(&freerunTimer, TdmaClock::freerunExpiry, nullptr);
     k_work_init_delayable(&demoteWork, TdmaClock::demoteHandler);
 
-    if (ppsSpec != nullptr && device_is_ready(ppsSpec->port)) {
-        if (gpio_pin_configure_dt(ppsSpec, GPIO_INPUT) == 0 &&
-            gpio_pin_interrupt_configure_dt(ppsSpec, GPIO_INT_EDGE_RISING) == 0) {
-            gpio_init_callback(&ppsCallback, TdmaClock::ppsIsr, BIT(ppsSpec->pin));
-            if (gpio_add_callback(ppsSpec->port, &ppsCallback) == 0) {
-                ppsConfigured = true;
-            }
-        }
+    if (timestamps->frequency() == 0) {
+        LOG_WRN("TDMA timer not running, epoch ticks will remain 0");
     }
 
-    if (tim2 == nullptr || !device_is_ready(tim2)) {
-        LOG_WRN("TDMA timer device not ready, epoch ticks will remain 0");
-    }
+    const bool ppsAttached = timestamps->addListener(TimestampService::Event::PPS, TdmaClock::onPps, this);
 
     startFreerun();
     scheduleDemote(K_MSEC(gpsDemoteMs));
 
-    if (!ppsConfigured) {
-        LOG_WRN("PPS not configured, starting in FREERUN");
+    if (!ppsAttached) {
+        LOG_WRN("PPS not available, starting in FREERUN");
     }
 }
 
@@ -65,28 +67,129 @@ uint32_t TdmaClock::frameNumber() const {
     return static_cast<uint32_t>(atomic_get(&frameNumberValue));
 }
 
-void TdmaClock::onHunterBeacon(uint32_t beaconFrameNumber, uint32_t timestamp) {
-    atomic_set(&frameNumberValue, static_cast<atomic_val_t>(beaconFrameNumber));
-    atomic_set(&epochTicksValue, static_cast<atomic_val_t>(timestamp));
+TdmaClock::SyncState TdmaClock::syncState() const {
+    const k_spinlock_key_t key = k_spin_lock(&syncLock);
+    const SyncState state = sync;
+    k_spin_unlock(&syncLock, key);
+    return state;
+}
+
+int32_t TdmaClock::driftPpb() const {
+    return syncState().driftEstimatePpb;
+}
+
+bool TdmaClock::driftValid() const {
+    return driftValid(syncState());
+}
+
+bool TdmaClock::driftValid(const SyncState& state) {
+    return state.driftSamples >= minDriftSamples;
+}
+
+uint32_t TdmaClock::timeErrorBoundUs() const {
+    const uint32_t timerHz = timestamps->frequency();
+    const uint32_t tickUs = timerHz != 0 ? DIV_ROUND_UP(1'000'000U, timerHz) : 1U;
+    const SyncState state = syncState();
+
+    uint32_t sinceSyncMs = 0;
+    switch (source()) {
+    case Source::GPS_PPS:
+        return tickUs;
+    case Source::HUNTER:
+    case Source::FREERUN:
+        if (!state.synced) {
+            return UINT32_MAX;
+        }
+        sinceSyncMs = static_cast<uint32_t>(k_ticks_to_ms_floor64(k_uptime_ticks() - state.lastSyncUptimeTicks));
+        break;
+    }
+
+    // Three deviations of the filtered estimate covers what the correction cannot remove
+    const int64_t uncertaintyPpb = driftValid(state) ? 3LL * state.driftDeviationPpb + 1'000'000'000LL / timerHz
+                                                : unknownDriftPpb;
+    const int64_t holdoverUs = static_cast<int64_t>(sinceSyncMs) * uncertaintyPpb / 1'000'000;
+    const int64_t tickPeriodUs = 1'000'000 / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+
+    return static_cast<uint32_t>(MIN(holdoverUs + tickPeriodUs + tickUs, int64_t{UINT32_MAX}));
+}
+
+uint32_t TdmaClock::nextFrameOffsetTicks(const uint32_t offsetUs, const uint32_t leadUs) const {
+    const uint32_t timerHz = timestamps->frequency();
+    const uint32_t now = timestamps->now();
+    if (timerHz == 0) {
+        return now;
+    }
+
+    // One frame in timer ticks, stretched by the measured drift as the freerun frames are
+    const SyncState state = syncState();
+    const int64_t correctionTicks =
+        driftValid(state) ? static_cast<int64_t>(timerHz) * state.driftEstimatePpb / 1'000'000'000 : 0;
+    const auto frameTicks = static_cast<uint32_t>(static_cast<int64_t>(timerHz) * FRAME_LEN_MS / 1000 + correctionTicks);
+    const auto toTicks = [timerHz](const uint32_t us) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(us) * timerHz / 1'000'000);
+    };
+
+    uint32_t target = epochTicks() + toTicks(offsetUs);
+    const uint32_t earliest = now + toTicks(leadUs);
+    while (static_cast<int32_t>(target - earliest) < 0) {
+        target += frameTicks;
+    }
+    return target;
+}
+
+int32_t TdmaClock::usUntil(const uint32_t ticks) const {
+    const uint32_t timerHz = timestamps->frequency();
+    if (timerHz == 0) {
+        return 0;
+    }
+    const auto delta = static_cast<int32_t>(ticks - timestamps->now());
+    return static_cast<int32_t>(static_cast<int64_t>(delta) * 1'000'000 / timerHz);
+}
+
+void TdmaClock::onHunterBeacon(uint32_t beaconFrameNumber, uint32_t timestamp, uint32_t frameElapsedUs) {
+    const int64_t frameStartTicks = k_uptime_ticks() - static_cast<int64_t>(k_us_to_ticks_near64(frameElapsedUs));
     atomic_set(&lastHunterUptimeMs, static_cast<atomic_val_t>(k_uptime_get_32()));
 
-    if (source() != Source::GPS_PPS) {
-        atomic_set(&currentSource, static_cast<atomic_val_t>(Source::HUNTER));
-        stopFreerun();
-        scheduleDemote(K_MSEC(hunterStaleMs));
+    if (source() == Source::GPS_PPS) {
+        // PPS edges stay the frame boundaries, numbered as the hunter frame each falls closest to
+        const int64_t frameTicks = k_ms_to_ticks_near64(FRAME_LEN_MS);
+        const int64_t ppsOffsetTicks = syncState().lastSyncUptimeTicks - frameStartTicks;
+        const int64_t frames = (ppsOffsetTicks + (ppsOffsetTicks >= 0 ? frameTicks / 2 : -frameTicks / 2)) / frameTicks;
+        atomic_set(&frameNumberValue, static_cast<atomic_val_t>(beaconFrameNumber + static_cast<int32_t>(frames)));
+        return;
     }
+
+    const uint32_t timerHz = timestamps->frequency();
+    const uint32_t elapsedTicks = static_cast<uint32_t>(static_cast<uint64_t>(frameElapsedUs) * timerHz / 1'000'000);
+    atomic_set(&frameNumberValue, static_cast<atomic_val_t>(beaconFrameNumber));
+    atomic_set(&epochTicksValue, static_cast<atomic_val_t>(timestamp - elapsedTicks));
+    const k_spinlock_key_t key = k_spin_lock(&syncLock);
+    sync.lastSyncUptimeTicks = frameStartTicks;
+    sync.synced = true;
+    k_spin_unlock(&syncLock, key);
+
+    // Frames carry on from the hunter's phase until the next beacon
+    setSource(Source::HUNTER);
+    freerunNextNs = k_ticks_to_ns_floor64(frameStartTicks);
+    scheduleFreerun();
+    scheduleDemote(K_MSEC(hunterStaleMs));
+}
+
+bool TdmaClock::hunterSynced() const {
+    const uint32_t lastHunter = static_cast<uint32_t>(atomic_get(&lastHunterUptimeMs));
+    return lastHunter != 0U && k_uptime_get_32() - lastHunter < hunterStaleMs;
 }
 
-void TdmaClock::ppsIsr(const device* dev, gpio_callback* cb, uint32_t pins) {
-    ARG_UNUSED(dev);
-    ARG_UNUSED(cb);
-    ARG_UNUSED(pins);
+void TdmaClock::onPps(TimestampService::Event event, uint32_t ticks, void* userData) {
+    ARG_UNUSED(event);
 
-    TdmaClock& clock = TdmaClock::instance();
+    TdmaClock& clock = *static_cast<TdmaClock*>(userData);
 
-    atomic_set(&clock.epochTicksValue, static_cast<atomic_val_t>(clock.readTim2Ticks()));
-    atomic_inc(&clock.frameNumberValue);
-    atomic_set(&clock.currentSource, static_cast<atomic_val_t>(Source::GPS_PPS));
+    clock.updateDrift(ticks);
+    atomic_set(&clock.epochTicksValue, static_cast<atomic_val_t>(ticks));
+    const auto frameNumber = static_cast<uint32_t>(atomic_inc(&clock.frameNumberValue)) + 1U;
+    clock.setSource(Source::GPS_PPS);
+    traceEvent(TraceEvent::FRAME, static_cast<uint16_t>(frameNumber));
 
     clock.stopFreerun();
     (void)k_work_reschedule(&clock.demoteWork, K_MSEC(gpsDemoteMs));
@@ -96,12 +199,14 @@ void TdmaClock::freerunExpiry(k_timer* timer) {
     ARG_UNUSED(timer);
 
     TdmaClock& clock = TdmaClock::instance();
-    if (clock.source() != Source::FREERUN) {
+    if (clock.source() == Source::GPS_PPS) {
         return;
     }
 
-    atomic_set(&clock.epochTicksValue, static_cast<atomic_val_t>(clock.readTim2Ticks()));
-    atomic_inc(&clock.frameNumberValue);
+    atomic_set(&clock.epochTicksValue, static_cast<atomic_val_t>(clock.timestamps->now()));
+    const auto frameNumber = static_cast<uint32_t>(atomic_inc(&clock.frameNumberValue)) + 1U;
+    traceEvent(TraceEvent::FRAME, static_cast<uint16_t>(frameNumber));
+    clock.scheduleFreerun();
 }
 
 void TdmaClock::demoteHandler(k_work* work) {
@@ -117,41 +222,96 @@ void TdmaClock::demoteHandler(k_work* work) {
         const bool hunterFresh = (lastHunter != 0U) && (hunterAgeMs < hunterStaleMs);
 
         if (hunterFresh) {
-            atomic_set(&clock.currentSource, std::to_underlying(Source::HUNTER));
-            clock.stopFreerun();
+            clock.setSource(Source::HUNTER);
+            clock.startFreerun();
             clock.scheduleDemote(K_MSEC(hunterStaleMs - hunterAgeMs));
         } else {
-            atomic_set(&clock.currentSource, std::to_underlying(Source::FREERUN));
+            clock.setSource(Source::FREERUN);
             clock.startFreerun();
+            const SyncState state = clock.syncState();
+            LOG_INF("PPS lost, holdover drift %d ppb (deviation %d ppb, %s)", state.driftEstimatePpb,
+                    state.driftDeviationPpb, driftValid(state) ? "corrected" : "uncorrected");
         }
         return;
     }
 
     if (now == Source::HUNTER) {
-        atomic_set(&clock.currentSource, std::to_underlying(Source::FREERUN));
+        clock.setSource(Source::FREERUN);
         clock.startFreerun();
     }
 }
 
+void TdmaClock::setSource(const Source next) {
+    const auto previous = static_cast<Source>(atomic_set(&currentSource, std::to_underlying(next)));
+    if (previous != next) {
+        traceEvent(TraceEvent::CLOCK_SOURCE, std::to_underlying(next));
+    }
+}
+
 void TdmaClock::startFreerun() {
-    k_timer_start(&freerunTimer, K_NO_WAIT, K_MSEC(frameLenMs));
+    const SyncState state = syncState();
+    if (state.synced) {
+        // Hold the phase of the last sync so frame boundaries continue where it left off
+        freerunNextNs = k_ticks_to_ns_floor64(state.lastSyncUptimeTicks);
+        scheduleFreerun();
+    } else {
+        freerunNextNs = k_ticks_to_ns_floor64(k_uptime_ticks());
+        k_timer_start(&freerunTimer, K_NO_WAIT, K_NO_WAIT);
+    }
+}
+
+void TdmaClock::scheduleFreerun() {
+    // One local second stretched or shrunk by the measured drift, scheduled against absolute
+    // deadlines so tick rounding does not accumulate
+    const SyncState state = syncState();
+    const int64_t correctionNs = driftValid(state) ? state.driftEstimatePpb : 0;
+    const uint64_t periodNs = static_cast<uint64_t>(static_cast<int64_t>(frameLenNs) + correctionNs);
+    const uint64_t nowNs = k_ticks_to_ns_floor64(k_uptime_ticks());
+
+    do {
+        freerunNextNs += periodNs;
+    } while (freerunNextNs <= nowNs);
+
+    k_timer_start(&freerunTimer, K_TIMEOUT_ABS_TICKS(k_ns_to_ticks_near64(freerunNextNs)), K_NO_WAIT);
 }
 
 void TdmaClock::stopFreerun() {
     k_timer_stop(&freerunTimer);
 }
 
-uint32_t TdmaClock::readTim2Ticks() const {
-    if (tim2 == nullptr || !device_is_ready(tim2)) {
-        return 0;
+void TdmaClock::updateDrift(const uint32_t ppsTicks) {
+    const int64_t uptimeTicks = k_uptime_ticks();
+    const uint32_t timerHz = timestamps->frequency();
+    const k_spinlock_key_t key = k_spin_lock(&syncLock);
+    SyncState& state = sync;
+    const bool consecutive = state.lastPpsValid && source() == Source::GPS_PPS && timerHz != 0;
+    const uint32_t intervalTicks = ppsTicks - state.lastPpsTicks;
+
+    state.lastPpsTicks = ppsTicks;
+    state.lastPpsValid = true;
+    state.lastSyncUptimeTicks = uptimeTicks;
+    state.synced = true;
+
+    const int64_t errorTicks = static_cast<int64_t>(intervalTicks) - timerHz;
+    const int64_t samplePpb = consecutive ? errorTicks * 1'000'000'000LL / timerHz : 0;
+    if (!consecutive || samplePpb > maxDriftPpb || samplePpb < -maxDriftPpb) {
+        k_spin_unlock(&syncLock, key);
+        return;
     }
 
-    uint32_t ticks = 0;
-    if (counter_get_value(tim2, &ticks) != 0) {
-        return 0;
+    // Average the first samples evenly, then settle into an EWMA that tracks temperature
+    const int32_t sample = static_cast<int32_t>(samplePpb);
+    if (state.driftSamples < minDriftSamples) {
+        state.driftSamples++;
+        state.driftEstimatePpb += (sample - state.driftEstimatePpb) / state.driftSamples;
+        state.driftDeviationPpb +=
+            (std::abs(sample - state.driftEstimatePpb) - state.driftDeviationPpb) / state.driftSamples;
+    } else {
+        state.driftEstimatePpb += (sample - state.driftEstimatePpb) >> driftFilterShift;
+        state.driftDeviationPpb +=
+            (std::abs(sample - state.driftEstimatePpb) - state.driftDeviationPpb) >> driftFilterShift;
     }
-
-    return ticks;
+    k_spin_unlock(&syncLock, key);
 }
 
 void TdmaClock::scheduleDemote(k_timeout_t delay) {
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifdef CONFIG_THREAD_STATS
+
+#include "core/ThreadStats.h"
+
+#include <cstring>
+
+#include <zephyr/init.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+
+#ifdef CONFIG_SHELL
+#include <zephyr/shell/shell.h>
+#endif
+
+LOG_MODULE_REGISTER(threads, LOG_LEVEL_INF);
+
+namespace {
+constexpr size_t MAX_THREADS = CONFIG_THREAD_STATS_MAX_THREADS;
+
+// CPU time of each thread at the previous sample, matched by thread
+struct ThreadCycles {
+    const k_thread* thread;
+    uint64_t cycles;
+};
+
+struct SampleContext {
+    ThreadStatsSnapshot& out;
+    uint64_t intervalCycles;
+    ThreadCycles next[MAX_THREADS];
+};
+
+ThreadCycles lastCycles[MAX_THREADS];
+int64_t lastSampleTicks;
+
+#if CONFIG_THREAD_STATS_REPORT_S > 0 || defined(CONFIG_SHELL)
+// Shared by the periodic log and the shell to save RAM, both print while holding sampleLock
+ThreadStatsSnapshot reportSnapshot;
+#endif
+
+K_MUTEX_DEFINE(sampleLock);
+
+#ifdef CONFIG_THREAD_STATS_ISR
+// Written from interrupts, read with interrupts locked
+uint64_t isrCycles;
+uint64_t lastIsrCycles;
+uint32_t isrEnterCycles;
+uint32_t isrDepth;
+#endif
+
+uint16_t permille(const uint64_t part, const uint64_t whole) {
+    if (whole == 0) {
+        return 0;
+    }
+    return static_cast<uint16_t>(MIN(part * 1000U / whole, 1000U));
+}
+
+uint64_t previousCycles(const k_thread* thread) {
+    for (const ThreadCycles& entry : lastCycles) {
+        if (entry.thread == thread) {
+            return entry.cycles;
+        }
+    }
+    return 0;
+}
+
+void sampleThread(const k_thread* thread, void* userData) {
+    auto* context = static_cast<SampleContext*>(userData);
+    ThreadStatsSnapshot& out = context->out;
+    if (out.count >= MAX_THREADS) {
+        out.missed++;
+        return;
+    }
+
+    const auto tid = const_cast<k_tid_t>(thread);
+    k_thread_runtime_stats_t stats{};
+    k_thread_runtime_stats_get(tid, &stats);
+
+    size_t unused = 0;
+    k_thread_stack_space_get(thread, &unused);
+
+    const char* name = k_thread_name_get(tid);
+    ThreadSample& sample = out.threads[out.count];
+    sample.name = name != nullptr && name[0] != '\0' ? name : "unnamed";
+    sample.stackSize = static_cast<uint32_t>(thread->stack_info.size);
+    sample.stackUsed = static_cast<uint32_t>(thread->stack_info.size - unused);
+    sample.cpuPermille = permille(stats.execution_cycles - previousCycles(thread), context->intervalCycles);
+
+    context->next[out.count] = {thread, stats.execution_cycles};
+    out.count++;
+}
+
+void printPermille(char* out, const size_t size, const uint16_t value) {
+    snprintk(out, size, "%3u.%u%%", value / 10U, value % 10U);
+}
+}
+
+#ifdef CONFIG_THREAD_STATS_ISR
+// User tracing hooks, run on entry to and exit from every interrupt with interrupts locked
+extern "C" void sys_trace_isr_enter_user(int nested_interrupts) {
+    ARG_UNUSED(nested_interrupts);
+
+    if (isrDepth++ == 0) {
+        isrEnterCycles = k_cycle_get_32();
+    }
+}
+
+extern "C" void sys_trace_isr_exit_user(int nested_interrupts) {
+    ARG_UNUSED(nested_interrupts);
+
+    if (isrDepth > 0 && --isrDepth == 0) {
+        isrCycles += k_cycle_get_32() - isrEnterCycles;
+    }
+}
+#endif
+
+void threadStatsSample(ThreadStatsSnapshot& out) {
+    k_mutex_lock(&sampleLock, K_FOREVER);
+
+    const int64_t now = k_uptime_ticks();
+    const uint64_t intervalCycles = k_ticks_to_cyc_floor64(static_cast<uint64_t>(now - lastSampleTicks));
+
+    out = ThreadStatsSnapshot{};
+    out.intervalMs = static_cast<uint32_t>(k_ticks_to_ms_floor64(static_cast<uint64_t>(now - lastSampleTicks)));
+
+    SampleContext context{out, intervalCycles, {}};
+    // Stacks are scanned for their watermark, too long to hold the thread list lock for
+    k_thread_foreach_unlocked(sampleThread, &context);
+
+    memcpy(lastCycles, context.next, sizeof(lastCycles));
+    lastSampleTicks = now;
+
+#ifdef CONFIG_THREAD_STATS_ISR
+    const unsigned int key = irq_lock();
+    const uint64_t isrTotal = isrCycles;
+    irq_unlock(key);
+
+    out.isrPermille = permille(isrTotal - lastIsrCycles, intervalCycles);
+    lastIsrCycles = isrTotal;
+#endif
+
+    k_mutex_unlock(&sampleLock);
+}
+
+#if CONFIG_THREAD_STATS_REPORT_S > 0
+static void reportWorkHandler(k_work* work);
+
+K_WORK_DELAYABLE_DEFINE(reportWork, reportWorkHandler);
+
+static void reportWorkHandler(k_work* work) {
+    ARG_UNUSED(work);
+
+    // Mutexes are recursive, so the sample can be taken with the lock held
+    k_mutex_lock(&sampleLock, K_FOREVER);
+    const ThreadStatsSnapshot& snapshot = reportSnapshot;
+    threadStatsSample(reportSnapshot);
+
+    char share[12];
+    printPermille(share, sizeof(share), snapshot.isrPermille);
+    LOG_INF("Threads over %u ms, ISR %s", snapshot.intervalMs, share);
+    for (size_t i = 0; i < snapshot.count; i++) {
+        const ThreadSample& sample = snapshot.threads[i];
+        printPermille(share, sizeof(share), sample.cpuPermille);
+        LOG_INF("\t%-16s stack %4u / %4u  cpu %s", sample.name, sample.stackUsed, sample.stackSize, share);
+    }
+    if (snapshot.missed > 0) {
+        LOG_WRN("%u threads not reported, raise CONFIG_THREAD_STATS_MAX_THREADS",
+                static_cast<unsigned int>(snapshot.missed));
+    }
+    k_mutex_unlock(&sampleLock);
+
+    k_work_schedule(&reportWork, K_SECONDS(CONFIG_THREAD_STATS_REPORT_S));
+}
+
+static int startThreadReports() {
+    k_work_schedule(&reportWork, K_SECONDS(CONFIG_THREAD_STATS_REPORT_S));
+    return 0;
+}
+
+SYS_INIT(startThreadReports, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#endif
+
+#ifdef CONFIG_SHELL
+static int cmd_threads(const struct shell *sh, size_t argc, char **argv) {
+    k_mutex_lock(&sampleLock, K_FOREVER);
+    const ThreadStatsSnapshot& snapshot = reportSnapshot;
+    threadStatsSample(reportSnapshot);
+
+    char share[12];
+    printPermille(share, sizeof(share), snapshot.isrPermille);
+    shell_print(sh, "Over %u ms, ISR %s", snapshot.intervalMs, share);
+    shell_print(sh, "%-16s %6s %6s %7s", "Thread", "Used", "Stack", "CPU");
+    for (size_t i = 0; i < snapshot.count; i++) {
+        const ThreadSample& sample = snapshot.threads[i];
+        printPermille(share, sizeof(share), sample.cpuPermille);
+        shell_print(sh, "%-16s %6u %6u %7s", sample.name, sample.stackUsed, sample.stackSize, share);
+    }
+    if (snapshot.missed > 0) {
+        shell_warn(sh, "%u threads not shown, raise CONFIG_THREAD_STATS_MAX_THREADS",
+                   static_cast<unsigned int>(snapshot.missed));
+    }
+    k_mutex_unlock(&sampleLock);
+    return 0;
+}
+
+SHELL_CMD_REGISTER(threads, NULL, "Show stack high-water marks and CPU use since the last report", cmd_threads);
+#endif
+
+#endif
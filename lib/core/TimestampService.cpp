@@ -0,0 +1,173 @@
+#include <core/TimestampService.h>
+
+#include <core/EventTrace.h>
+
+#include <zephyr/drivers/counter.h>
+#include <zephyr/logging/log.h>
+
+LOG_MODULE_REGISTER(timestamp, LOG_LEVEL_INF);
+
+TimestampService& TimestampService::instance() {
+    static TimestampService service;
+    return service;
+}
+
+int TimestampService::init(const device* timerDev) {
+    timer = timerDev;
+    timerHz = 0;
+    atomic_set(&timerWraps, 0);
+
+    if (timer == nullptr || !device_is_ready(timer)) {
+        LOG_WRN("Timestamp timer device not ready, captures will read 0");
+        return -ENODEV;
+    }
+
+    // TIM2 is 16 bits on the trackers, so count wraps to extend it to 32
+    timerPeriod = counter_get_top_value(timer) + 1U;
+    const counter_top_cfg topCfg{
+        .ticks = timerPeriod - 1U,
+        .callback = TimestampService::timerWrap,
+        .user_data = this,
+        .flags = 0,
+    };
+
+    int ret = counter_set_top_value(timer, &topCfg);
+    if (ret == 0) {
+        ret = counter_start(timer);
+    }
+
+    if (ret != 0) {
+        LOG_WRN("Timestamp timer failed to start, rc=%d", ret);
+        return ret;
+    }
+
+    timerHz = counter_get_frequency(timer);
+    return 0;
+}
+
+int TimestampService::attachPps(const gpio_dt_spec* pps) {
+    if (pps == nullptr || !device_is_ready(pps->port)) {
+        LOG_ERR("PPS GPIO device not ready");
+        return -ENODEV;
+    }
+
+    int ret = gpio_pin_configure_dt(pps, GPIO_INPUT | GPIO_PULL_UP);
+    if (ret != 0) {
+        LOG_ERR("Failed to configure PPS pin %d, rc=%d", pps->pin, ret);
+        return ret;
+    }
+
+    // The receiver's rising edge marks the top of the second
+    ret = gpio_pin_interrupt_configure_dt(pps, GPIO_INT_EDGE_RISING);
+    if (ret != 0) {
+        LOG_ERR("Failed to configure interrupt on pin %d, rc=%d", pps->pin, ret);
+        return ret;
+    }
+
+    gpio_init_callback(&ppsCallback, TimestampService::ppsIsr, BIT(pps->pin));
+    ret = gpio_add_callback(pps->port, &ppsCallback);
+    if (ret != 0) {
+        LOG_ERR("Failed to add PPS callback, rc=%d", ret);
+    }
+
+    return ret;
+}
+
+int TimestampService::attachRadio(const gpio_dt_spec* dio) {
+    if (dio == nullptr || !device_is_ready(dio->port)) {
+        LOG_ERR("Radio GPIO device not ready");
+        return -ENODEV;
+    }
+
+    // The LoRa driver configures the pin and its interrupt. Callbacks are added to the front of
+    // the port's list, so this one runs before the driver's and latches the timer first.
+    gpio_init_callback(&radioCallback, TimestampService::radioIsr, BIT(dio->pin));
+    const int ret = gpio_add_callback(dio->port, &radioCallback);
+    if (ret != 0) {
+        LOG_ERR("Failed to add radio callback, rc=%d", ret);
+    }
+
+    return ret;
+}
+
+bool TimestampService::addListener(const Event event, const Listener listener, void* userData) {
+    if (listener == nullptr || listenerCount >= MAX_LISTENERS) {
+        return false;
+    }
+
+    const unsigned int key = irq_lock();
+    listeners[listenerCount] = Slot{listener, userData, event};
+    listenerCount++;
+    irq_unlock(key);
+
+    return true;
+}
+
+uint32_t TimestampService::now() const {
+    if (timerHz == 0) {
+        return 0;
+    }
+
+    const unsigned int key = irq_lock();
+    uint32_t wraps = static_cast<uint32_t>(atomic_get(&timerWraps));
+    uint32_t ticks = 0;
+    int ret = counter_get_value(timer, &ticks);
+
+    // A wrap whose interrupt has not run yet: re-read so the count is after the wrap
+    if (ret == 0 && counter_get_pending_int(timer) != 0) {
+        ret = counter_get_value(timer, &ticks);
+        wraps++;
+    }
+    irq_unlock(key);
+
+    if (ret != 0) {
+        return 0;
+    }
+
+    return wraps * timerPeriod + ticks;
+}
+
+bool TimestampService::lastCapture(const Event event, Capture& capture) const {
+    const unsigned int key = irq_lock();
+    capture = captures[static_cast<size_t>(event)];
+    irq_unlock(key);
+
+    return capture.count != 0;
+}
+
+void TimestampService::capture(const Event event) {
+    const uint32_t ticks = now();
+
+    Capture& latest = captures[static_cast<size_t>(event)];
+    latest.ticks = ticks;
+    latest.count++;
+    traceEvent(event == Event::PPS ? TraceEvent::PPS : TraceEvent::RADIO_DONE, static_cast<uint16_t>(latest.count));
+
+    for (size_t i = 0; i < listenerCount; i++) {
+        if (listeners[i].event == event) {
+            listeners[i].listener(event, ticks, listeners[i].userData);
+        }
+    }
+}
+
+void TimestampService::ppsIsr(const device* dev, gpio_callback* cb, uint32_t pins) {
+    ARG_UNUSED(dev);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(pins);
+
+    TimestampService::instance().capture(Event::PPS);
+}
+
+void TimestampService::radioIsr(const device* dev, gpio_callback* cb, uint32_t pins) {
+    ARG_UNUSED(dev);
+    ARG_UNUSED(cb);
+    ARG_UNUSED(pins);
+
+    TimestampService::instance().capture(Event::RADIO_DONE);
+}
+
+void TimestampService::timerWrap(const device* dev, void* userData) {
+    ARG_UNUSED(dev);
+
+    atomic_inc(&static_cast<TimestampService*>(userData)->timerWraps);
+}
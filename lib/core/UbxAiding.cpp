@@ -0,0 +1,78 @@
+#include "core/UbxAiding.h"
+
+#include <cstring>
+
+namespace {
+constexpr uint8_t ubxSync1 = 0xB5;
+constexpr uint8_t ubxSync2 = 0x62;
+constexpr uint8_t ubxClassMga = 0x13;
+constexpr uint8_t ubxIdMgaIni = 0x40;
+
+constexpr uint8_t mgaIniPosLlh = 0x01;
+constexpr uint8_t mgaIniTimeUtc = 0x10;
+// Leap seconds unknown, let the receiver use its own value
+constexpr int8_t leapSecondsUnknown = -128;
+
+void putU16(uint8_t* out, const uint16_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void putU32(uint8_t* out, const uint32_t value) {
+    putU16(out, static_cast<uint16_t>(value));
+    putU16(out + 2, static_cast<uint16_t>(value >> 16));
+}
+
+// Wraps a payload already written at out + 6 in its header and checksum
+size_t finishUbxFrame(uint8_t* out, const uint8_t msgClass, const uint8_t msgId, const uint16_t payloadLen) {
+    out[0] = ubxSync1;
+    out[1] = ubxSync2;
+    out[2] = msgClass;
+    out[3] = msgId;
+    putU16(out + 4, payloadLen);
+
+    // 8-bit Fletcher over class, ID, length and payload
+    uint8_t ckA = 0;
+    uint8_t ckB = 0;
+    for (size_t i = 2; i < 6U + payloadLen; i++) {
+        ckA += out[i];
+        ckB += ckA;
+    }
+    out[6 + payloadLen] = ckA;
+    out[7 + payloadLen] = ckB;
+
+    return UBX_FRAME_OVERHEAD + payloadLen;
+}
+}
+
+size_t encodeMgaIniPosLlh(uint8_t* out, const AidingFix& fix, const uint32_t accuracyCm) {
+    uint8_t* payload = out + 6;
+    memset(payload, 0, 20);
+
+    payload[0] = mgaIniPosLlh;
+    putU32(payload + 4, static_cast<uint32_t>(fix.latitudeE7));
+    putU32(payload + 8, static_cast<uint32_t>(fix.longitudeE7));
+    putU32(payload + 12, static_cast<uint32_t>(fix.altitudeCm));
+    putU32(payload + 16, accuracyCm);
+
+    return finishUbxFrame(out, ubxClassMga, ubxIdMgaIni, 20);
+}
+
+size_t encodeMgaIniTimeUtc(uint8_t* out, const AidingFix& fix, const uint16_t accuracyS) {
+    uint8_t* payload = out + 6;
+    memset(payload, 0, 24);
+
+    payload[0] = mgaIniTimeUtc;
+    // No time reference: the time applies when the message is received
+    payload[2] = 0;
+    payload[3] = static_cast<uint8_t>(leapSecondsUnknown);
+    putU16(payload + 4, fix.year);
+    payload[6] = fix.month;
+    payload[7] = fix.day;
+    payload[8] = fix.hour;
+    payload[9] = fix.minute;
+    payload[10] = fix.second;
+    putU16(payload + 16, accuracyS);
+
+    return finishUbxFrame(out, ubxClassMga, ubxIdMgaIni, 24);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Holds each core benchmark to a budget in nanoseconds per operation, timed on the host clock.
+ * Budgets are around fifteen times what a desktop runs them in, loose enough for a busy CI
+ * machine and tight enough to catch a receive path that starts copying or searching more.
+ */
+
+#include <string.h>
+
+#include <zephyr/ztest.h>
+
+#include <core/Benchmark.h>
+
+#include "host_clock.h"
+
+namespace {
+constexpr uint32_t ITERATIONS = 20'000;
+// Best of several runs, so one preempted run does not fail the suite
+constexpr int RUNS = 5;
+
+struct Budget {
+    const char* name;
+    uint32_t nsPerOp;
+};
+
+constexpr Budget budgets[] = {
+    {"encode_fix", 300},
+    {"encode_batch", 1'500},
+    {"decode_batch", 800},
+    {"relay_unwrap", 150},
+    {"rx_dedup", 250},
+    {"rx_decode", 2'000},
+    {"format_fix", 1'500},
+    {"distance", 3'000},
+    {"predict", 1'500},
+};
+
+volatile uint32_t sink;
+
+const Budget* budgetFor(const char* name) {
+    for (const Budget& budget : budgets) {
+        if (strcmp(budget.name, name) == 0) {
+            return &budget;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t bestNsPerOp(const size_t index) {
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < RUNS; run++) {
+        Benchmark::prepare();
+        const uint64_t start = host_clock_ns();
+        sink = Benchmark::run(index, ITERATIONS);
+        const uint64_t elapsed = host_clock_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return static_cast<uint32_t>(best / ITERATIONS);
+}
+} // namespace
+
+ZTEST_SUITE(benchmark, nullptr, nullptr, nullptr, nullptr, nullptr);
+
+ZTEST(benchmark, test_every_case_budgeted) {
+    zassert_equal(Benchmark::caseCount(), ARRAY_SIZE(budgets));
+    for (size_t index = 0; index < Benchmark::caseCount(); index++) {
+        zassert_not_null(budgetFor(Benchmark::caseName(index)), "%s has no budget", Benchmark::caseName(index));
+    }
+}
+
+ZTEST(benchmark, test_within_budget) {
+    for (size_t index = 0; index < Benchmark::caseCount(); index++) {
+        const char* name = Benchmark::caseName(index);
+        const Budget* budget = budgetFor(name);
+        zassert_not_null(budget, "%s has no budget", name);
+
+        const uint32_t nsPerOp = bestNsPerOp(index);
+        TC_PRINT("%-14s %8u ns/op (budget %u)\n", name, nsPerOp, budget->nsPerOp);
+        zassert_true(nsPerOp <= budget->nsPerOp, "%s took %u ns/op, over its %u ns budget", name, nsPerOp,
+                     budget->nsPerOp);
+    }
+}
+
+ZTEST(benchmark, test_runs_repeat) {
+    // Each run starts from the same frames and an empty node table, so timings compare like for like
+    for (size_t index = 0; index < Benchmark::caseCount(); index++) {
+        Benchmark::prepare();
+        const uint32_t first = Benchmark::run(index, 100);
+        Benchmark::prepare();
+        zassert_equal(Benchmark::run(index, 100), first, "%s differs between runs", Benchmark::caseName(index));
+    }
+}
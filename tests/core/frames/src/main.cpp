@@ -0,0 +1,418 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Frames encoded as a tracker or hunter sends them, decoded as the hunter's receive path does,
+ * in the layout this build transmits. Covers duplicate and relayed copies, overlapping batches
+ * and trackers that restart their sequence numbers.
+ */
+
+#include <zephyr/ztest.h>
+
+#include <core/FrameCodec.h>
+#include <core/FrameDecoder.h>
+#include <core/NodeTable.h>
+#include <core/defs.h>
+
+namespace {
+constexpr char CALLSIGN[] = "KK7XYZ";
+constexpr int16_t RSSI = -80;
+constexpr int8_t SNR = 7;
+
+// Records what the decoder passed on, the last of each kind
+class RecordingSink : public FrameSink {
+public:
+    uint32_t fixes{0};
+    uint32_t timedFixes{0};
+    uint32_t batchFixes{0};
+    uint32_t noFixes{0};
+    uint32_t relayed{0};
+    uint32_t commands{0};
+    uint32_t acks{0};
+    uint32_t beacons{0};
+    uint32_t unknown{0};
+    uint32_t malformed{0};
+
+    LoraFrame lastFix{};
+    TimedFixFrame lastTimedFix{};
+    FixBatchFrame lastBatch{};
+    GnssInfo batch[2 * FIX_BATCH_MAX_FIXES]{};
+    uint32_t batchAgesMs[2 * FIX_BATCH_MAX_FIXES]{};
+    uint8_t lastNoFixNode{0};
+    uint8_t lastNoFixSeq{0};
+    RelayFrame lastRelay{};
+    CommandFrame lastCommand{};
+    CommandAckFrame lastAck{};
+    BeaconFrame lastBeacon{};
+    FrameType lastMalformedType{};
+    const char* lastCallsign{nullptr};
+
+    void onFix(const LoraFrame& frame, const RxInfo& rx) override {
+        fixes++;
+        lastFix = frame;
+        lastCallsign = rx.callsign;
+    }
+
+    void onTimedFix(const TimedFixFrame& frame, const RxInfo& rx) override {
+        timedFixes++;
+        lastTimedFix = frame;
+        lastCallsign = rx.callsign;
+    }
+
+    void onBatchFix(const FixBatchFrame& header, const GnssInfo& fix, const uint32_t ageMs,
+                    const RxInfo& rx) override {
+        if (batchFixes < ARRAY_SIZE(batch)) {
+            batch[batchFixes] = fix;
+            batchAgesMs[batchFixes] = ageMs;
+        }
+        batchFixes++;
+        lastBatch = header;
+        lastCallsign = rx.callsign;
+    }
+
+    void onNoFix(const NoFixFrame& frame, const RxInfo& rx) override {
+        noFixes++;
+        lastNoFixNode = frame.node_id;
+        lastNoFixSeq = frame.seq;
+        lastCallsign = rx.callsign;
+    }
+
+    void onRelayed(const RelayFrame& envelope) override {
+        relayed++;
+        lastRelay = envelope;
+    }
+
+    void onCommand(const CommandFrame& command, const RxInfo& rx) override {
+        commands++;
+        lastCommand = command;
+        lastCallsign = rx.callsign;
+    }
+
+    void onCommandAck(const CommandAckFrame& ack, const RxInfo& rx) override {
+        acks++;
+        lastAck = ack;
+        lastCallsign = rx.callsign;
+    }
+
+    void onBeacon(const BeaconFrame& beacon, const RxInfo& rx) override {
+        beacons++;
+        lastBeacon = beacon;
+        lastCallsign = rx.callsign;
+    }
+
+    void onUnknown(const uint8_t*, const RxInfo&) override { unknown++; }
+
+    void onMalformed(const FrameType type, uint8_t, const RxInfo&) override {
+        malformed++;
+        lastMalformedType = type;
+    }
+};
+
+const TxFrameEncoder encoder{CALLSIGN};
+RecordingSink sink;
+FrameDecoder decoder{sink};
+uint32_t nowMs;
+
+GnssInfo makeFix(const int32_t latitude, const int32_t longitude, const uint8_t satellites = 9) {
+    GnssInfo fix{};
+    fix.latitude = latitude;
+    fix.longitude = longitude;
+    fix.satellites_cnt = satellites;
+    fix.fix_status = 1;
+    return fix;
+}
+
+void expectFix(const GnssInfo& actual, const GnssInfo& expected) {
+    zassert_equal(actual.latitude, expected.latitude);
+    zassert_equal(actual.longitude, expected.longitude);
+    zassert_equal(actual.satellites_cnt, expected.satellites_cnt);
+    zassert_equal(actual.fix_status, expected.fix_status);
+}
+
+// Frames from trackers carry the callsign only on licensed builds
+void expectCallsign(const char* callsign) {
+#ifdef CONFIG_LICENSED_FREQUENCY
+    zassert_not_null(callsign);
+    zassert_mem_equal(callsign, CALLSIGN, CALLSIGN_CHAR_COUNT);
+#else
+    zassert_is_null(callsign);
+#endif
+}
+
+bool receive(const uint8_t* frame, const size_t size) {
+    return decoder.decode(frame, size, RSSI, SNR, nowMs);
+}
+
+void before(void*) {
+    sink = RecordingSink{};
+    decoder.reset();
+    nowMs = 1'000;
+}
+} // namespace
+
+ZTEST_SUITE(frames, nullptr, nullptr, before, nullptr, nullptr);
+
+ZTEST(frames, test_fix_round_trip) {
+    const GnssInfo fix = makeFix(47'654, -122'308);
+    uint8_t frame[TxFrameEncoder::frameSize<LoraFrame>];
+    zassert_equal(encoder.encodeFix(frame, 3, 7, fix), sizeof(frame));
+
+    FrameId id{};
+    zassert_true(identifyFrame(frame, sizeof(frame), id));
+    zassert_equal(id.nodeId, 3);
+    zassert_equal(id.seq, 7);
+
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.fixes, 1U);
+    zassert_equal(sink.lastFix.node_id, 3);
+    zassert_equal(sink.lastFix.seq, 7);
+    expectFix(sink.lastFix.gnssInfo, fix);
+    expectCallsign(sink.lastCallsign);
+    zassert_true(decoder.nodeTable().node(3).hasFix);
+    zassert_equal(decoder.nodeTable().node(3).lastRssi, RSSI);
+}
+
+ZTEST(frames, test_timed_fix_round_trip) {
+    const GnssInfo fix = makeFix(-33'868, 151'209);
+    uint8_t frame[TxFrameEncoder::frameSize<TimedFixFrame>];
+    zassert_equal(encoder.encodeTimedFix(frame, 4, 1, fix, 1'500), sizeof(frame));
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.timedFixes, 1U);
+    zassert_equal(sink.lastTimedFix.node_id, 4);
+    zassert_equal(sink.lastTimedFix.fix_age_ms, 1'500);
+    expectFix(sink.lastTimedFix.fix, fix);
+    expectCallsign(sink.lastCallsign);
+
+    // Ages past 16 bits saturate
+    encoder.encodeTimedFix(frame, 4, 2, fix, 100'000);
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.lastTimedFix.fix_age_ms, UINT16_MAX);
+}
+
+ZTEST(frames, test_no_fix_round_trip) {
+    uint8_t frame[TxFrameEncoder::frameSize<NoFixFrame>];
+    zassert_equal(encoder.encodeNoFix(frame, 4, 9), sizeof(frame));
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.noFixes, 1U);
+    zassert_equal(sink.lastNoFixNode, 4);
+    zassert_equal(sink.lastNoFixSeq, 9);
+    expectCallsign(sink.lastCallsign);
+}
+
+ZTEST(frames, test_batch_round_trip) {
+    constexpr size_t count = 5;
+    GnssInfo fixes[count];
+    for (size_t age = 0; age < count; age++) {
+        fixes[age] = makeFix(47'654 - static_cast<int32_t>(age) * 3, -122'308 + static_cast<int32_t>(age) * 2,
+                             static_cast<uint8_t>(9 - age));
+    }
+
+    FixBatchFrame header{};
+    header.node_id = 2;
+    header.seq = 1;
+    header.sample_index = 100;
+    header.interval_ds = 10;
+    uint8_t frame[TxFrameEncoder::frameSize<FixBatchFrame> + (count - 1) * FIX_DELTA_SIZE];
+    zassert_equal(encoder.encodeFixBatch(frame, header, fixes, count), sizeof(frame));
+
+    FixBatchFrame decodedHeader{};
+    GnssInfo decoded[FIX_BATCH_MAX_FIXES];
+    zassert_true(decodeFixBatchFrame(frame, sizeof(frame), decodedHeader, decoded, FIX_BATCH_MAX_FIXES));
+    zassert_equal(decodedHeader.count, count);
+    zassert_equal(decodedHeader.sample_index, 100);
+
+    // Older fixes are deltas, so they carry the newest fix's satellites and status
+    for (size_t age = 0; age < count; age++) {
+        GnssInfo expected = fixes[age];
+        expected.satellites_cnt = fixes[0].satellites_cnt;
+        expectFix(decoded[age], expected);
+    }
+
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.batchFixes, count);
+    expectCallsign(sink.lastCallsign);
+    // Reported oldest first, each with its age before the newest
+    for (size_t i = 0; i < count; i++) {
+        const size_t age = count - 1 - i;
+        zassert_equal(sink.batch[i].latitude, fixes[age].latitude);
+        zassert_equal(sink.batch[i].longitude, fixes[age].longitude);
+        zassert_equal(sink.batchAgesMs[i], age * header.interval_ds * 100U);
+    }
+}
+
+ZTEST(frames, test_overlapping_batch_reports_new_fixes) {
+    constexpr size_t count = 4;
+    GnssInfo fixes[count + 2];
+    for (size_t i = 0; i < ARRAY_SIZE(fixes); i++) {
+        fixes[i] = makeFix(47'654 + static_cast<int32_t>(i), -122'308);
+    }
+
+    FixBatchFrame header{};
+    header.node_id = 2;
+    header.seq = 1;
+    header.sample_index = 100;
+    header.interval_ds = 10;
+    uint8_t frame[TxFrameEncoder::frameSize<FixBatchFrame> + (count - 1) * FIX_DELTA_SIZE];
+    encoder.encodeFixBatch(frame, header, fixes + 2, count);
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.batchFixes, count);
+
+    // Two samples on, the batch repeats two fixes already reported
+    header.seq = 2;
+    header.sample_index = 102;
+    encoder.encodeFixBatch(frame, header, fixes, count);
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.batchFixes, count + 2);
+    zassert_equal(sink.batch[count].latitude, fixes[1].latitude);
+    zassert_equal(sink.batch[count + 1].latitude, fixes[0].latitude);
+}
+
+ZTEST(frames, test_relay_round_trip) {
+    const GnssInfo fix = makeFix(51'507, -127);
+    uint8_t inner[TxFrameEncoder::frameSize<LoraFrame>];
+    encoder.encodeFix(inner, 5, 3, fix);
+    uint8_t frame[TxFrameEncoder::frameSize<RelayFrame> + sizeof(inner)];
+    zassert_equal(encoder.encodeRelay(frame, 6, 1, inner, sizeof(inner)), sizeof(frame));
+
+    RelayFrame envelope{};
+    const uint8_t* unwrapped = nullptr;
+    size_t unwrappedSize = 0;
+    zassert_true(decodeRelayFrame(frame, sizeof(frame), envelope, unwrapped, unwrappedSize));
+    zassert_equal(unwrappedSize, sizeof(inner));
+    zassert_mem_equal(unwrapped, inner, sizeof(inner));
+
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.fixes, 1U);
+    zassert_equal(sink.lastFix.node_id, 5);
+    expectFix(sink.lastFix.gnssInfo, fix);
+    zassert_equal(sink.relayed, 1U);
+    zassert_equal(sink.lastRelay.relay_node_id, 6);
+    zassert_equal(sink.lastRelay.hops, 1);
+
+    // Envelopes are never nested
+    uint8_t nested[TxFrameEncoder::frameSize<RelayFrame> + sizeof(frame)];
+    encoder.encodeRelay(nested, 7, 2, frame, sizeof(frame));
+    zassert_false(decodeRelayFrame(nested, sizeof(nested), envelope, unwrapped, unwrappedSize));
+}
+
+ZTEST(frames, test_duplicate_dropped) {
+    uint8_t frame[TxFrameEncoder::frameSize<LoraFrame>];
+    encoder.encodeFix(frame, 3, 7, makeFix(47'654, -122'308));
+
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_false(receive(frame, sizeof(frame)), "The same node and sequence number is a duplicate");
+    zassert_equal(sink.fixes, 1U);
+    zassert_equal(decoder.nodeTable().node(3).frames, 1U);
+    zassert_equal(decoder.nodeTable().node(3).duplicates, 1U);
+
+    encoder.encodeFix(frame, 3, 8, makeFix(47'655, -122'308));
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.fixes, 2U);
+}
+
+ZTEST(frames, test_relayed_copy_dropped) {
+    uint8_t inner[TxFrameEncoder::frameSize<LoraFrame>];
+    encoder.encodeFix(inner, 5, 3, makeFix(51'507, -127));
+    uint8_t frame[TxFrameEncoder::frameSize<RelayFrame> + sizeof(inner)];
+    encoder.encodeRelay(frame, 6, 1, inner, sizeof(inner));
+
+    // Heard directly first, then through a relay
+    zassert_true(receive(inner, sizeof(inner)));
+    receive(frame, sizeof(frame));
+    zassert_equal(sink.fixes, 1U);
+    zassert_equal(sink.relayed, 0U, "Relayed copies of frames already heard are not reported");
+    zassert_equal(decoder.nodeTable().node(5).duplicates, 1U);
+}
+
+ZTEST(frames, test_restarted_tracker_heard_after_silence) {
+    uint8_t frame[TxFrameEncoder::frameSize<LoraFrame>];
+    encoder.encodeFix(frame, 3, 7, makeFix(47'654, -122'308));
+    zassert_true(receive(frame, sizeof(frame)));
+
+    // Within the silence timeout the same sequence number is a duplicate, not a restart
+    nowMs += SeenFrames::SILENCE_MS / 2;
+    zassert_false(receive(frame, sizeof(frame)));
+
+    // Silent for longer, a tracker that rebooted into the same sequence number is heard
+    nowMs += SeenFrames::SILENCE_MS / 2 + 1;
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.fixes, 2U);
+}
+
+ZTEST(frames, test_command_round_trip) {
+    CommandFrame command{};
+    command.target_node = 3;
+    command.command_id = 9;
+    command.opcode = static_cast<uint8_t>(CommandOpcode::SET_DATARATE);
+    command.value = 9;
+    uint8_t frame[TxFrameEncoder::frameSize<CommandFrame>];
+    zassert_equal(encoder.encodeCommand(frame, command), sizeof(frame));
+
+    CommandFrame decoded{};
+    zassert_true(decodeCommandFrame(frame, sizeof(frame), decoded));
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.commands, 1U);
+    zassert_equal(sink.lastCommand.target_node, 3);
+    zassert_equal(sink.lastCommand.command_id, 9);
+    zassert_equal(sink.lastCommand.opcode, static_cast<uint8_t>(CommandOpcode::SET_DATARATE));
+    zassert_equal(sink.lastCommand.value, 9U);
+
+    // Commands carry no sequence number, so a repeat is passed on for the tracker to judge
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.commands, 2U);
+}
+
+ZTEST(frames, test_command_ack_round_trip) {
+    CommandAckFrame ack{};
+    ack.node_id = 3;
+    ack.command_id = 9;
+    ack.status = static_cast<uint8_t>(CommandStatus::INVALID);
+    uint8_t frame[TxFrameEncoder::frameSize<CommandAckFrame>];
+    zassert_equal(encoder.encodeCommandAck(frame, ack), sizeof(frame));
+
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.acks, 1U);
+    zassert_equal(sink.lastAck.node_id, 3);
+    zassert_equal(sink.lastAck.command_id, 9);
+    zassert_equal(sink.lastAck.status, static_cast<uint8_t>(CommandStatus::INVALID));
+}
+
+ZTEST(frames, test_beacon_round_trip) {
+    BeaconFrame beacon{};
+    beacon.frame_number = 123'456;
+    beacon.offset_ms = 250;
+    uint8_t frame[TxFrameEncoder::frameSize<BeaconFrame>];
+    zassert_equal(encoder.encodeBeacon(frame, beacon), sizeof(frame));
+
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.beacons, 1U);
+    zassert_equal(sink.lastBeacon.frame_number, 123'456U);
+    zassert_equal(sink.lastBeacon.offset_ms, 250);
+}
+
+ZTEST(frames, test_truncated_batch_malformed) {
+    constexpr size_t count = 3;
+    GnssInfo fixes[count];
+    for (size_t age = 0; age < count; age++) {
+        fixes[age] = makeFix(47'654, -122'308 + static_cast<int32_t>(age));
+    }
+
+    FixBatchFrame header{};
+    header.node_id = 2;
+    header.interval_ds = 10;
+    uint8_t frame[TxFrameEncoder::frameSize<FixBatchFrame> + (count - 1) * FIX_DELTA_SIZE];
+    encoder.encodeFixBatch(frame, header, fixes, count);
+
+    // The last delta is lost
+    zassert_true(receive(frame, sizeof(frame) - FIX_DELTA_SIZE));
+    zassert_equal(sink.malformed, 1U);
+    zassert_equal(sink.lastMalformedType, FrameType::FIX_BATCH);
+    zassert_equal(sink.batchFixes, 0U);
+}
+
+ZTEST(frames, test_unknown_frame) {
+    const uint8_t frame[] = {0x01, 0x02, 0x03};
+    zassert_true(receive(frame, sizeof(frame)));
+    zassert_equal(sink.unknown, 1U);
+    zassert_equal(sink.fixes + sink.noFixes + sink.malformed, 0U);
+}
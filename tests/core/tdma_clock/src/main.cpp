@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * TdmaClock source transitions between FREERUN, HUNTER and GPS_PPS. The timebase is the fake
+ * counter, PPS edges are driven onto an emulated GPIO and simulated time only moves while the
+ * test sleeps, so every edge, beacon and timeout lands at a known time.
+ */
+
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+
+#include <core/TdmaClock.h>
+#include <core/TimestampService.h>
+
+#include "fake_counter.h"
+
+namespace {
+using Source = TdmaClock::Source;
+
+constexpr uint32_t FRAME_MS = TdmaClock::FRAME_LEN_MS;
+constexpr uint32_t FRAME_TICKS = FAKE_COUNTER_HZ * FRAME_MS / 1000U;
+// TdmaClock's demotion timeouts, 5 s without PPS and 30 s without a beacon, plus a margin
+constexpr uint32_t PPS_LOST_MS = 5'500;
+constexpr uint32_t HUNTER_LOST_MS = 31'000;
+// Freerun frames start on a kernel tick, so can be this far from a counter tick
+constexpr uint32_t KERNEL_TICK_TICKS = FAKE_COUNTER_HZ / CONFIG_SYS_CLOCK_TICKS_PER_SEC;
+
+const gpio_dt_spec pps = GPIO_DT_SPEC_GET(DT_PATH(zephyr_user), pps_gpios);
+int timebaseResult;
+uint32_t boundBeforeSync;
+
+void pulsePps() {
+    gpio_emul_input_set(pps.port, pps.pin, 1);
+    gpio_emul_input_set(pps.port, pps.pin, 0);
+}
+
+// A GNSS receiver with a fix, an edge at the top of each of the next seconds
+void runPps(const uint32_t seconds) {
+    for (uint32_t i = 0; i < seconds; i++) {
+        k_msleep(FRAME_MS);
+        pulsePps();
+    }
+}
+
+// A hunter beacon ending now, elapsedUs into the hunter's frame
+void hearBeacon(const uint32_t frameNumber, const uint32_t elapsedUs) {
+    TdmaClock::instance().onHunterBeacon(frameNumber, TimestampService::instance().now(), elapsedUs);
+}
+
+void* setup() {
+    TimestampService& timestamps = TimestampService::instance();
+    timebaseResult = timestamps.init(fake_counter_get());
+    if (timebaseResult == 0) {
+        timebaseResult = timestamps.attachPps(&pps);
+    }
+    TdmaClock::instance().init(timestamps);
+    boundBeforeSync = TdmaClock::instance().timeErrorBoundUs();
+    return nullptr;
+}
+
+// Each test starts in FREERUN on an exact timebase, long after the last edge and beacon
+void before(void*) {
+    zassert_ok(timebaseResult, "Timebase did not start");
+    fake_counter_set_drift(0);
+    k_msleep(HUNTER_LOST_MS);
+}
+} // namespace
+
+ZTEST_SUITE(tdma_clock, nullptr, setup, before, nullptr, nullptr);
+
+ZTEST(tdma_clock, test_freerun_without_sync) {
+    TdmaClock& clock = TdmaClock::instance();
+    zassert_equal(boundBeforeSync, UINT32_MAX, "A clock never synced has no error bound");
+    zassert_equal(clock.source(), Source::FREERUN);
+    zassert_false(clock.hunterSynced());
+
+    const uint32_t frame = clock.frameNumber();
+    k_msleep(10 * FRAME_MS);
+    zassert_within(clock.frameNumber() - frame, 10U, 1U, "Freerun keeps a frame a second");
+}
+
+ZTEST(tdma_clock, test_pps_promotes_to_gps) {
+    TdmaClock& clock = TdmaClock::instance();
+    const uint32_t frame = clock.frameNumber();
+
+    pulsePps();
+    zassert_equal(clock.source(), Source::GPS_PPS);
+    zassert_equal(clock.epochTicks(), TimestampService::instance().now(), "The frame starts at the PPS capture");
+    zassert_equal(clock.frameNumber(), frame + 1);
+    zassert_equal(clock.timeErrorBoundUs(), 1U, "Locked to PPS, the error is one timer tick");
+
+    // Only the edges start frames while locked
+    runPps(3);
+    zassert_equal(clock.frameNumber(), frame + 4);
+}
+
+ZTEST(tdma_clock, test_pps_loss_demotes_to_freerun) {
+    TdmaClock& clock = TdmaClock::instance();
+    runPps(3);
+    const uint32_t ppsEpoch = clock.epochTicks();
+
+    k_msleep(PPS_LOST_MS);
+    zassert_equal(clock.source(), Source::FREERUN);
+    const uint32_t bound = clock.timeErrorBoundUs();
+    zassert_true(bound > 1U && bound < UINT32_MAX, "Holdover error grows from the last edge");
+
+    // Holdover frames keep the phase of the last edge
+    k_msleep(FRAME_MS);
+    zassert_within(clock.epochTicks() - ppsEpoch, 6U * FRAME_TICKS, KERNEL_TICK_TICKS);
+}
+
+ZTEST(tdma_clock, test_beacon_promotes_to_hunter) {
+    TdmaClock& clock = TdmaClock::instance();
+    hearBeacon(42, 0);
+    const uint32_t beaconEpoch = TimestampService::instance().now();
+    zassert_equal(clock.source(), Source::HUNTER);
+    zassert_true(clock.hunterSynced());
+    zassert_equal(clock.frameNumber(), 42U);
+    zassert_equal(clock.epochTicks(), beaconEpoch);
+
+    // Frames carry on from the hunter's phase between beacons
+    k_msleep(FRAME_MS + FRAME_MS / 2);
+    zassert_equal(clock.frameNumber(), 43U);
+    zassert_within(clock.epochTicks() - beaconEpoch, FRAME_TICKS, KERNEL_TICK_TICKS);
+
+    k_msleep(HUNTER_LOST_MS);
+    zassert_equal(clock.source(), Source::FREERUN);
+    zassert_false(clock.hunterSynced());
+}
+
+ZTEST(tdma_clock, test_beacon_numbers_pps_frames) {
+    TdmaClock& clock = TdmaClock::instance();
+    pulsePps();
+    const uint32_t ppsEpoch = clock.epochTicks();
+
+    // The hunter's frame started on the edge
+    k_msleep(200);
+    hearBeacon(100, 200'000);
+    zassert_equal(clock.source(), Source::GPS_PPS, "PPS keeps the frame boundaries");
+    zassert_equal(clock.epochTicks(), ppsEpoch);
+    zassert_equal(clock.frameNumber(), 100U);
+
+    // The hunter's frame started 900 ms before the edge, which is closest to its next frame
+    hearBeacon(200, 1'100'000);
+    zassert_equal(clock.frameNumber(), 201U);
+    zassert_equal(clock.epochTicks(), ppsEpoch);
+}
+
+ZTEST(tdma_clock, test_pps_loss_falls_back_to_hunter) {
+    TdmaClock& clock = TdmaClock::instance();
+    hearBeacon(7, 0);
+    runPps(3);
+    zassert_equal(clock.source(), Source::GPS_PPS);
+
+    k_msleep(PPS_LOST_MS);
+    zassert_equal(clock.source(), Source::HUNTER, "A hunter heard within 30 s takes over from PPS");
+
+    k_msleep(HUNTER_LOST_MS);
+    zassert_equal(clock.source(), Source::FREERUN);
+}
+
+ZTEST(tdma_clock, test_drift_measured_against_pps) {
+    TdmaClock& clock = TdmaClock::instance();
+    // The local oscillator runs 50 ppm fast
+    fake_counter_set_drift(50'000);
+    runPps(64);
+    zassert_true(clock.driftValid());
+    zassert_within(clock.driftPpb(), 50'000, 100);
+
+    // Slots in later frames are a measured frame apart
+    const uint32_t epoch = clock.epochTicks();
+    zassert_equal(clock.nextFrameOffsetTicks(100'000, 0), epoch + 100'000U);
+    zassert_within(clock.nextFrameOffsetTicks(100'000, 500'000), epoch + 100'000U + FRAME_TICKS + 50U, 1U);
+}
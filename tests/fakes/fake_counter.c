@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "fake_counter.h"
+
+#include <zephyr/drivers/counter.h>
+#include <zephyr/kernel.h>
+
+/*
+ * 32 bits wide, so it does not wrap within a test run and TimestampService's wrap count stays
+ * at 0. The count is worked out from simulated time whenever it is read.
+ */
+struct fake_counter_data {
+	struct k_spinlock lock;
+	bool running;
+	int32_t drift_ppb;
+	/* Simulated time and count when the drift last changed */
+	uint64_t origin_ns;
+	uint64_t origin_count;
+};
+
+static struct fake_counter_data fake_counter_data;
+
+static uint64_t uptime_ns(void)
+{
+	return k_ticks_to_ns_floor64(k_uptime_ticks());
+}
+
+static uint64_t count_at(const struct fake_counter_data *data, uint64_t now_ns)
+{
+	const uint64_t elapsed_ns = now_ns - data->origin_ns;
+	const int64_t drift_ns = (int64_t)elapsed_ns * data->drift_ppb / 1000000000;
+
+	return data->origin_count +
+	       ((int64_t)elapsed_ns + drift_ns) * FAKE_COUNTER_HZ / 1000000000U;
+}
+
+static int fake_counter_start(const struct device *dev)
+{
+	struct fake_counter_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	data->origin_ns = uptime_ns();
+	data->running = true;
+	k_spin_unlock(&data->lock, key);
+	return 0;
+}
+
+static int fake_counter_stop(const struct device *dev)
+{
+	struct fake_counter_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	data->origin_count = count_at(data, uptime_ns());
+	data->running = false;
+	k_spin_unlock(&data->lock, key);
+	return 0;
+}
+
+static int fake_counter_get_value(const struct device *dev, uint32_t *ticks)
+{
+	struct fake_counter_data *data = dev->data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+
+	*ticks = (uint32_t)(data->running ? count_at(data, uptime_ns()) : data->origin_count);
+	k_spin_unlock(&data->lock, key);
+	return 0;
+}
+
+static int fake_counter_set_top_value(const struct device *dev, const struct counter_top_cfg *cfg)
+{
+	ARG_UNUSED(dev);
+
+	/* Only the full range is supported, and a 32 bit counter never wraps in a test */
+	return cfg->ticks == UINT32_MAX ? 0 : -ENOTSUP;
+}
+
+static uint32_t fake_counter_get_pending_int(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return 0;
+}
+
+static uint32_t fake_counter_get_top_value(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return UINT32_MAX;
+}
+
+static uint32_t fake_counter_get_freq(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	return FAKE_COUNTER_HZ;
+}
+
+static DEVICE_API(counter, fake_counter_api) = {
+	.start = fake_counter_start,
+	.stop = fake_counter_stop,
+	.get_value = fake_counter_get_value,
+	.set_top_value = fake_counter_set_top_value,
+	.get_pending_int = fake_counter_get_pending_int,
+	.get_top_value = fake_counter_get_top_value,
+	.get_freq = fake_counter_get_freq,
+};
+
+static const struct counter_config_info fake_counter_config = {
+	.max_top_value = UINT32_MAX,
+	.freq = FAKE_COUNTER_HZ,
+	.flags = COUNTER_CONFIG_INFO_COUNT_UP,
+	.channels = 0,
+};
+
+DEVICE_DEFINE(fake_counter, "fake_counter", NULL, NULL, &fake_counter_data, &fake_counter_config,
+	      POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &fake_counter_api);
+
+const struct device *fake_counter_get(void)
+{
+	return DEVICE_GET(fake_counter);
+}
+
+void fake_counter_set_drift(int32_t drift_ppb)
+{
+	struct fake_counter_data *data = &fake_counter_data;
+	k_spinlock_key_t key = k_spin_lock(&data->lock);
+	const uint64_t now_ns = uptime_ns();
+
+	if (data->running) {
+		data->origin_count = count_at(data, now_ns);
+	}
+	data->origin_ns = now_ns;
+	data->drift_ppb = drift_ppb;
+	k_spin_unlock(&data->lock, key);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Counter device standing in for the trackers' TDMA timer. It counts at FAKE_COUNTER_HZ on
+ * simulated time, sped up or slowed down by a drift set from the test, so TimestampService and
+ * TdmaClock see an oscillator with a known frequency error.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <zephyr/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAKE_COUNTER_HZ 1000000U
+
+/**
+ * @return The fake counter device
+ */
+const struct device *fake_counter_get(void);
+
+/**
+ * Change the counter's frequency error from now on, the count carries on from where it is
+ * @param drift_ppb Frequency error in parts per billion, positive to count fast
+ */
+void fake_counter_set_drift(int32_t drift_ppb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * The host's monotonic clock, for timing code on native_sim. Simulated time only moves while
+ * the CPU is idle, so k_cycle_get_32() reads the same before and after a busy loop.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @return Host monotonic time in nanoseconds
+ */
+uint64_t host_clock_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
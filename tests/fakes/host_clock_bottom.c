@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Built into the native simulator runner, against the host C library.
+ */
+
+#include <stdint.h>
+#include <time.h>
+
+#include "host_clock.h"
+
+uint64_t host_clock_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
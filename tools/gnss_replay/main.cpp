@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Streams a recorded GNSS log to a serial port, a native_sim PTY or stdout, paced by the
+ * log's own timestamps at real time or any multiple of it. NMEA logs are sent as recorded.
+ * UBX logs are sent as the GGA and RMC sentences the trackers' NMEA driver reads, one pair
+ * per NAV-PVT. On a serial port DTR can rise at the start of each UTC second, as PPS.
+ */
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t DAY_MS = 86'400'000;
+constexpr uint8_t UBX_SYNC_1 = 0xB5;
+constexpr uint8_t UBX_SYNC_2 = 0x62;
+constexpr uint8_t UBX_CLASS_NAV = 0x01;
+constexpr uint8_t UBX_NAV_PVT = 0x07;
+constexpr size_t UBX_NAV_PVT_SIZE = 92;
+constexpr size_t UBX_OVERHEAD = 8;
+
+struct Options {
+    std::string log;
+    std::string port;
+    uint32_t baud{9600};
+    double rate{1.0};
+    uint32_t repeat{1};
+    bool pps{false};
+};
+
+// Everything the receiver sent for one navigation solution
+struct Epoch {
+    uint32_t timeMs;    // UTC time of day, or GPS time of week for UBX logs
+    std::string data;
+};
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options] <log>\n"
+            "\n"
+            "  --port PATH      Serial port or PTY to write to (default stdout)\n"
+            "  --baud N         Baud rate when the port is a serial port (default 9600)\n"
+            "  --rate X         Replay speed as a multiple of real time, 0 for as fast as possible\n"
+            "                   (default 1)\n"
+            "  --repeat N       Send the log N times, 0 to loop until stopped (default 1)\n"
+            "  --pps            Raise DTR at the start of each UTC second, as the receiver's PPS\n",
+            name);
+}
+
+bool parseUint(const char* text, uint32_t& value) {
+    char* end = nullptr;
+    const unsigned long parsed = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || parsed > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool parseRate(const char* text, double& value) {
+    char* end = nullptr;
+    value = strtod(text, &end);
+    return end != text && *end == '\0' && value >= 0.0;
+}
+
+bool parseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--port" && hasValue) {
+            options.port = argv[++i];
+        } else if (arg == "--baud" && hasValue) {
+            if (!parseUint(argv[++i], options.baud)) {
+                return false;
+            }
+        } else if (arg == "--rate" && hasValue) {
+            if (!parseRate(argv[++i], options.rate)) {
+                return false;
+            }
+        } else if (arg == "--repeat" && hasValue) {
+            if (!parseUint(argv[++i], options.repeat)) {
+                return false;
+            }
+        } else if (arg == "--pps") {
+            options.pps = true;
+        } else if (!arg.empty() && arg[0] != '-' && options.log.empty()) {
+            options.log = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.log.empty();
+}
+
+uint8_t nmeaChecksum(const std::string& body) {
+    uint8_t checksum = 0;
+    for (const char c : body) {
+        checksum ^= static_cast<uint8_t>(c);
+    }
+    return checksum;
+}
+
+std::string nmeaSentence(const std::string& body) {
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", nmeaChecksum(body));
+    return "$" + body + tail;
+}
+
+/**
+ * Time of day of a GGA or RMC sentence
+ * @param line Sentence without its line ending
+ * @param timeMs Filled with the time in milliseconds since midnight UTC
+ * @return Whether the sentence carries a time
+ */
+bool nmeaTime(const std::string& line, uint32_t& timeMs) {
+    if (line.size() < 7 || line[0] != '$' || (line.compare(3, 3, "GGA") != 0 && line.compare(3, 3, "RMC") != 0)) {
+        return false;
+    }
+
+    const size_t field = line.find(',');
+    unsigned hours = 0;
+    unsigned minutes = 0;
+    double seconds = 0.0;
+    if (field == std::string::npos ||
+        sscanf(line.c_str() + field + 1, "%2u%2u%lf", &hours, &minutes, &seconds) != 3) {
+        return false;
+    }
+    timeMs = (hours * 3600U + minutes * 60U) * 1000U + static_cast<uint32_t>(seconds * 1000.0 + 0.5);
+    return true;
+}
+
+/**
+ * Split an NMEA log into epochs, each starting at the first sentence with a new time. Lines
+ * that are not sentences, e.g. UBX binary in a mixed log, are dropped.
+ */
+void readNmea(const std::string& text, std::vector<Epoch>& epochs) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string line = text.substr(start, end - start);
+        start = end + 1;
+
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+            line.pop_back();
+        }
+        const size_t sentence = line.find('$');
+        if (sentence == std::string::npos) {
+            continue;
+        }
+        line.erase(0, sentence);
+
+        uint32_t timeMs = 0;
+        if (nmeaTime(line, timeMs) && (epochs.empty() || epochs.back().timeMs != timeMs)) {
+            epochs.push_back({timeMs, {}});
+        }
+        if (!epochs.empty()) {
+            epochs.back().data += line + "\r\n";
+        }
+    }
+}
+
+template <typename T>
+T readLe(const uint8_t* data) {
+    T value{};
+    for (size_t i = 0; i < sizeof(T); i++) {
+        value = static_cast<T>(value | static_cast<T>(static_cast<T>(data[i]) << (8 * i)));
+    }
+    return value;
+}
+
+// ddmm.mmmmm from 1e-7 degrees, with the hemisphere letter
+std::string nmeaAngle(const int32_t e7, const int degreeDigits, const char positive, const char negative) {
+    const uint32_t magnitude = e7 < 0 ? static_cast<uint32_t>(-static_cast<int64_t>(e7)) : static_cast<uint32_t>(e7);
+    const uint32_t degrees = magnitude / 10'000'000U;
+    // 1e-7 degrees times 60 is 1e-7 minutes, then down to 1e-5
+    const uint32_t minutesE5 = (magnitude % 10'000'000U) * 60U / 100U;
+    char text[24];
+    snprintf(text, sizeof(text), "%0*u%02u.%05u,%c", degreeDigits, degrees, minutesE5 / 100'000U,
+             minutesE5 % 100'000U, e7 < 0 ? negative : positive);
+    return text;
+}
+
+/**
+ * The GGA and RMC sentences a receiver would send for a NAV-PVT solution
+ */
+std::string pvtToNmea(const uint8_t* pvt) {
+    const uint32_t iTow = readLe<uint32_t>(pvt);
+    const uint16_t year = readLe<uint16_t>(pvt + 4);
+    const uint8_t month = pvt[6];
+    const uint8_t day = pvt[7];
+    const uint8_t hour = pvt[8];
+    const uint8_t minute = pvt[9];
+    const uint8_t second = pvt[10];
+    const uint8_t fixType = pvt[20];
+    const uint8_t flags = pvt[21];
+    const uint8_t satellites = pvt[23];
+    const auto lon = readLe<int32_t>(pvt + 24);
+    const auto lat = readLe<int32_t>(pvt + 28);
+    const auto heightMm = readLe<int32_t>(pvt + 32);
+    const auto mslMm = readLe<int32_t>(pvt + 36);
+    const auto speedMmS = readLe<int32_t>(pvt + 60);
+    const auto headingE5 = readLe<int32_t>(pvt + 64);
+    const uint16_t pdop = readLe<uint16_t>(pvt + 76);
+
+    const bool fixOk = (flags & 0x01) != 0 && fixType >= 2 && fixType <= 4;
+    const int quality = !fixOk ? 0 : (flags & 0x02) != 0 ? 2 : 1;
+
+    // Whole hundredths only, the fraction of the second is the same in GPS and UTC time
+    char time[16];
+    snprintf(time, sizeof(time), "%02u%02u%02u.%02u", hour, minute, second, iTow % 1000U / 10U);
+    const std::string position = nmeaAngle(lat, 2, 'N', 'S') + "," + nmeaAngle(lon, 3, 'E', 'W');
+
+    char gga[128];
+    snprintf(gga, sizeof(gga), "GPGGA,%s,%s,%d,%02u,%.2f,%.1f,M,%.1f,M,,", time, position.c_str(), quality,
+             satellites, pdop / 100.0, mslMm / 1000.0, (heightMm - mslMm) / 1000.0);
+
+    char rmc[128];
+    snprintf(rmc, sizeof(rmc), "GPRMC,%s,%c,%s,%.2f,%.2f,%02u%02u%02u,,,%c", time, fixOk ? 'A' : 'V',
+             position.c_str(), speedMmS * 0.00194384, headingE5 / 100'000.0, day, month, year % 100U,
+             fixOk ? (quality == 2 ? 'D' : 'A') : 'N');
+
+    return nmeaSentence(rmc) + nmeaSentence(gga);
+}
+
+/**
+ * One epoch per NAV-PVT in a UBX log, at its GPS time of week. Other messages and anything
+ * that fails its checksum are skipped.
+ */
+void readUbx(const std::vector<uint8_t>& log, std::vector<Epoch>& epochs) {
+    size_t i = 0;
+    while (i + UBX_OVERHEAD <= log.size()) {
+        if (log[i] != UBX_SYNC_1 || log[i + 1] != UBX_SYNC_2) {
+            i++;
+            continue;
+        }
+
+        const size_t length = readLe<uint16_t>(&log[i + 4]);
+        if (i + UBX_OVERHEAD + length > log.size()) {
+            break;
+        }
+
+        uint8_t ckA = 0;
+        uint8_t ckB = 0;
+        for (size_t j = i + 2; j < i + 6 + length; j++) {
+            ckA = static_cast<uint8_t>(ckA + log[j]);
+            ckB = static_cast<uint8_t>(ckB + ckA);
+        }
+        if (ckA != log[i + 6 + length] || ckB != log[i + 7 + length]) {
+            i++;
+            continue;
+        }
+
+        if (log[i + 2] == UBX_CLASS_NAV && log[i + 3] == UBX_NAV_PVT && length >= UBX_NAV_PVT_SIZE) {
+            const uint8_t* pvt = &log[i + 6];
+            epochs.push_back({readLe<uint32_t>(pvt), pvtToNmea(pvt)});
+        }
+        i += UBX_OVERHEAD + length;
+    }
+}
+
+bool loadLog(const std::string& path, std::vector<Epoch>& epochs) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    const std::vector<uint8_t> log{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    // A log with NAV-PVT in it is replayed from those, even if NMEA was logged alongside
+    readUbx(log, epochs);
+    if (epochs.empty()) {
+        readNmea(std::string(log.begin(), log.end()), epochs);
+    }
+    return true;
+}
+
+speed_t baudConstant(const uint32_t baud) {
+    switch (baud) {
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default: return B0;
+    }
+}
+
+/**
+ * Open the output, raw and at the given baud rate if it is a terminal
+ * @return File descriptor, or -1 on error
+ */
+int openPort(const Options& options) {
+    if (options.port.empty()) {
+        return STDOUT_FILENO;
+    }
+
+    const int fd = open(options.port.c_str(), O_WRONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", options.port.c_str(), strerror(errno));
+        return -1;
+    }
+
+    termios tty{};
+    if (tcgetattr(fd, &tty) == 0) {
+        const speed_t speed = baudConstant(options.baud);
+        if (speed == B0) {
+            fprintf(stderr, "Unsupported baud rate %u\n", options.baud);
+            close(fd);
+            return -1;
+        }
+        cfmakeraw(&tty);
+        cfsetospeed(&tty, speed);
+        cfsetispeed(&tty, speed);
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    return fd;
+}
+
+bool writeAll(const int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t ret = write(fd, data.data() + written, data.size() - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            fprintf(stderr, "Write failed: %s\n", strerror(errno));
+            return false;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+void setDtr(const int fd, const bool high) {
+    int bits = TIOCM_DTR;
+    ioctl(fd, high ? TIOCMBIS : TIOCMBIC, &bits);
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Epoch> epochs;
+    if (!loadLog(options.log, epochs)) {
+        return 1;
+    }
+    if (epochs.empty()) {
+        fprintf(stderr, "No epochs in %s\n", options.log.c_str());
+        return 1;
+    }
+
+    const int fd = openPort(options);
+    if (fd < 0) {
+        return 1;
+    }
+    if (options.pps && !isatty(fd)) {
+        fprintf(stderr, "--pps needs a serial port\n");
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    uint64_t sent = 0;
+    uint64_t bytes = 0;
+    // Log time elapsed in earlier passes, so a repeat carries on from where the last one ended
+    double offsetMs = 0.0;
+
+    for (uint32_t pass = 0; options.repeat == 0 || pass < options.repeat; pass++) {
+        uint32_t previousMs = epochs.front().timeMs;
+        uint32_t previousSecond = UINT32_MAX;
+        double logMs = offsetMs;
+
+        for (const Epoch& epoch : epochs) {
+            // Midnight, or the end of the GPS week, wraps the time back
+            const uint32_t stepMs = epoch.timeMs >= previousMs ? epoch.timeMs - previousMs
+                                                               : epoch.timeMs + DAY_MS - previousMs;
+            previousMs = epoch.timeMs;
+            logMs += stepMs;
+
+            // Paced against the start, so the time spent writing does not add up
+            if (options.rate > 0.0) {
+                std::this_thread::sleep_until(
+                    start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double, std::milli>(logMs / options.rate)));
+            }
+
+            const uint32_t second = epoch.timeMs / 1000U;
+            const bool pulse = options.pps && second != previousSecond;
+            previousSecond = second;
+            if (pulse) {
+                setDtr(fd, true);
+            }
+            if (!writeAll(fd, epoch.data)) {
+                return 1;
+            }
+            if (pulse) {
+                setDtr(fd, false);
+            }
+            sent++;
+            bytes += epoch.data.size();
+        }
+
+        // The gap between passes is one epoch's worth
+        offsetMs = logMs + (epochs.size() > 1 ? (logMs - offsetMs) / static_cast<double>(epochs.size() - 1) : 1000.0);
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    fprintf(stderr, "Epochs:      %" PRIu64 " (%zu x %u)\n", sent, epochs.size(), options.repeat);
+    fprintf(stderr, "Sent:        %" PRIu64 " bytes in %.3f s, %.1f epochs/s\n", bytes, seconds,
+            seconds > 0.0 ? static_cast<double>(sent) / seconds : 0.0);
+    return 0;
+}
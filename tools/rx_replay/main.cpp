@@ -0,0 +1,443 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Replays hunter RX captures, or synthetic multi-node traffic, through the hunter's decode path
+ * and node table as fast as possible, reporting throughput and per-frame latency. Mutated
+ * traffic exercises the decoder with malformed frames. The latency pass also runs the position
+ * predictor, timed by each frame's arrival.
+ *
+ * Mutated traffic should also run clean under the undefined behaviour sanitizer:
+ *   cmake -S tools/rx_replay -B builds/rx_replay_ubsan -DCMAKE_CXX_FLAGS="-fsanitize=undefined -fno-sanitize-recover=all"
+ *   cmake --build builds/rx_replay_ubsan && builds/rx_replay_ubsan/rx_replay --synthetic --frames 200000 --mutate 20
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/FrameCodec.h"
+#include "core/FrameDecoder.h"
+#include "core/PositionPredictor.h"
+#include "core/RxCapture.h"
+#include "core/defs.h"
+
+namespace {
+
+struct Options {
+    std::vector<std::string> captures;
+    bool synthetic{false};
+    uint32_t nodes{MAX_NODE_ID + 1};
+    uint32_t frames{1'000'000};
+    uint32_t seed{1};
+    uint32_t mutatePercent{0};
+    uint32_t repeat{1};
+    bool licensed{false};
+    std::string dump;
+};
+
+class CountingSink : public FrameSink {
+public:
+    uint64_t fixes{0};
+    uint64_t batchFixes{0};
+    uint64_t noFixes{0};
+    uint64_t relayed{0};
+    uint64_t commands{0};
+    uint64_t beacons{0};
+    uint64_t unknown{0};
+    uint64_t malformed{0};
+    uint64_t outliers{0};
+    uint64_t invalid{0};
+
+    // Fed with fixes as the hunter does when set, at nowMs
+    PositionPredictor* predictor{nullptr};
+    uint32_t nowMs{0};
+
+    void onFix(const LoraFrame& frame, const RxInfo&) override {
+        fixes++;
+        predict(frame.node_id, frame.gnssInfo, 0);
+    }
+    void onTimedFix(const TimedFixFrame& frame, const RxInfo&) override {
+        fixes++;
+        predict(frame.node_id, frame.fix, 0);
+    }
+    void onBatchFix(const FixBatchFrame& header, const GnssInfo& fix, uint32_t ageMs, const RxInfo&) override {
+        batchFixes++;
+        predict(header.node_id, fix, ageMs);
+    }
+    void onNoFix(const NoFixFrame&, const RxInfo&) override { noFixes++; }
+    void onRelayed(const RelayFrame&) override { relayed++; }
+    void onCommand(const CommandFrame&, const RxInfo&) override { commands++; }
+    void onCommandAck(const CommandAckFrame&, const RxInfo&) override { commands++; }
+    void onBeacon(const BeaconFrame&, const RxInfo&) override { beacons++; }
+    void onUnknown(const uint8_t*, const RxInfo&) override { unknown++; }
+    void onMalformed(FrameType, uint8_t, const RxInfo&) override { malformed++; }
+
+private:
+    void predict(const uint8_t nodeId, const GnssInfo& fix, const uint32_t ageMs) {
+        if (!predictor) {
+            return;
+        }
+        const PositionPredictor::Result result = predictor->update(nodeId, fix, nowMs - ageMs);
+        if (result == PositionPredictor::Result::OUTLIER) {
+            outliers++;
+        } else if (result == PositionPredictor::Result::INVALID) {
+            invalid++;
+        }
+    }
+};
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options] <capture.log>...\n"
+            "       %s [options] --synthetic\n"
+            "\n"
+            "  --synthetic      Generate traffic instead of reading captures\n"
+            "  --nodes N        Synthetic trackers, 1-%u (default %u)\n"
+            "  --frames N       Synthetic frames (default 1000000)\n"
+            "  --seed N         Random seed (default 1)\n"
+            "  --mutate PCT     Corrupt PCT%% of frames to fuzz the decoder\n"
+            "  --repeat N       Decode the frames N times, starting fresh each time\n"
+            "  --licensed       Synthetic frames carry a callsign, as from licensed trackers\n"
+            "  --dump FILE      Write the frames as capture lines, e.g. for a fuzz corpus\n",
+            name, name, MAX_NODE_ID + 1, MAX_NODE_ID + 1);
+}
+
+bool parseUint(const char* text, uint32_t& value) {
+    char* end = nullptr;
+    const unsigned long parsed = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || parsed > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<uint32_t>(parsed);
+    return true;
+}
+
+bool parseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--synthetic") {
+            options.synthetic = true;
+        } else if (arg == "--nodes" && hasValue) {
+            if (!parseUint(argv[++i], options.nodes) || options.nodes == 0 || options.nodes > MAX_NODE_ID + 1) {
+                return false;
+            }
+        } else if (arg == "--frames" && hasValue) {
+            if (!parseUint(argv[++i], options.frames)) {
+                return false;
+            }
+        } else if (arg == "--seed" && hasValue) {
+            if (!parseUint(argv[++i], options.seed)) {
+                return false;
+            }
+        } else if (arg == "--mutate" && hasValue) {
+            if (!parseUint(argv[++i], options.mutatePercent) || options.mutatePercent > 100) {
+                return false;
+            }
+        } else if (arg == "--repeat" && hasValue) {
+            if (!parseUint(argv[++i], options.repeat) || options.repeat == 0) {
+                return false;
+            }
+        } else if (arg == "--licensed") {
+            options.licensed = true;
+        } else if (arg == "--dump" && hasValue) {
+            options.dump = argv[++i];
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.captures.push_back(arg);
+        } else {
+            return false;
+        }
+    }
+
+    return options.synthetic != !options.captures.empty();
+}
+
+bool loadCapture(const std::string& path, std::vector<RxCaptureRecord>& records) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    size_t skipped = 0;
+    RxCaptureRecord record{};
+    while (std::getline(file, line)) {
+        // Captures are interleaved with the hunter's normal output, possibly after a log prefix
+        const size_t start = line.find(RX_CAPTURE_PREFIX);
+        if (start == std::string::npos) {
+            continue;
+        }
+        if (parseRxCapture(line.c_str() + start, record)) {
+            records.push_back(record);
+        } else {
+            skipped++;
+        }
+    }
+
+    if (skipped > 0) {
+        fprintf(stderr, "%s: skipped %zu malformed capture lines\n", path.c_str(), skipped);
+    }
+    return true;
+}
+
+/**
+ * Traffic from a fleet of trackers heard by one hunter: single fixes, batches, NOFIX, and frames
+ * heard a second time through a relay
+ */
+class SyntheticTraffic {
+public:
+    SyntheticTraffic(const Options& options) : options(options), rng(options.seed) {
+        for (uint32_t id = 0; id < options.nodes; id++) {
+            trackers[id].fix.latitude = 47'600 + static_cast<int32_t>(rng() % 100);
+            trackers[id].fix.longitude = -122'300 - static_cast<int32_t>(rng() % 100);
+            trackers[id].fix.satellites_cnt = 8;
+            trackers[id].fix.fix_status = 1;
+        }
+    }
+
+    void generate(std::vector<RxCaptureRecord>& records) {
+        records.reserve(records.size() + options.frames);
+        uint64_t arrivalUs = 0;
+
+        for (uint32_t i = 0; i < options.frames; i++) {
+            RxCaptureRecord record{};
+            arrivalUs += 1'000'000 / options.nodes;
+            record.arrivalUs = arrivalUs;
+            record.rssi = static_cast<int16_t>(-60 - static_cast<int>(rng() % 60));
+            record.snr = static_cast<int8_t>(static_cast<int>(rng() % 20) - 8);
+
+            const uint8_t nodeId = static_cast<uint8_t>(rng() % options.nodes);
+            const uint32_t kind = rng() % 100;
+            if (kind < 15 && lastSize > 0 && lastNode != nodeId) {
+                // Relay of the previous frame by another tracker; usually already heard directly
+                record.size = static_cast<uint8_t>(withEncoder([&](const auto& encoder) {
+                    return encoder.encodeRelay(record.data, nodeId, 1, lastFrame, lastSize);
+                }));
+            } else if (kind >= 95 && options.nodes > 1) {
+                // Out of range of the hunter, so only heard through another tracker
+                lastSize = encodeOwnFrame(nodeId, kind, lastFrame);
+                lastNode = nodeId;
+                const uint8_t relayNodeId = static_cast<uint8_t>((nodeId + 1) % options.nodes);
+                record.size = static_cast<uint8_t>(withEncoder([&](const auto& encoder) {
+                    return encoder.encodeRelay(record.data, relayNodeId, 1, lastFrame, lastSize);
+                }));
+            } else {
+                record.size = static_cast<uint8_t>(encodeOwnFrame(nodeId, kind, record.data));
+                memcpy(lastFrame, record.data, record.size);
+                lastSize = record.size;
+                lastNode = nodeId;
+            }
+
+            if (rng() % 100 < options.mutatePercent) {
+                mutate(record);
+            }
+            records.push_back(record);
+        }
+    }
+
+private:
+    struct Tracker {
+        GnssInfo fix;
+        uint8_t seq;
+        uint16_t sampleIndex;
+        GnssInfo history[FIX_BATCH_MAX_FIXES];
+    };
+
+    static constexpr char callsign[] = "SYNTH1";
+    static constexpr size_t batchFixes = 5;
+
+    /**
+     * Run an encode with the layout selected by --licensed
+     */
+    template <typename Encode>
+    size_t withEncoder(Encode&& encode) const {
+        return options.licensed ? encode(licensedEncoder) : encode(unlicensedEncoder);
+    }
+
+    size_t encodeOwnFrame(const uint8_t nodeId, const uint32_t kind, uint8_t* out) {
+        Tracker& tracker = trackers[nodeId];
+
+        // Wander up to a millidegree per frame, keeping the newest fixes for batches
+        tracker.fix.latitude += static_cast<int32_t>(rng() % 3) - 1;
+        tracker.fix.longitude += static_cast<int32_t>(rng() % 3) - 1;
+        std::copy_backward(tracker.history, tracker.history + batchFixes - 1, tracker.history + batchFixes);
+        tracker.history[0] = tracker.fix;
+        tracker.sampleIndex++;
+
+        if (kind < 25) {
+            FixBatchFrame header{};
+            header.node_id = nodeId;
+            header.seq = tracker.seq++;
+            header.sample_index = tracker.sampleIndex;
+            header.interval_ds = 10;
+            return withEncoder([&](const auto& encoder) {
+                return encoder.encodeFixBatch(out, header, tracker.history, batchFixes);
+            });
+        }
+
+        const uint8_t seq = tracker.seq++;
+        if (kind < 35) {
+            return withEncoder([&](const auto& encoder) { return encoder.encodeNoFix(out, nodeId, seq); });
+        }
+        return withEncoder([&](const auto& encoder) { return encoder.encodeFix(out, nodeId, seq, tracker.fix); });
+    }
+
+    void mutate(RxCaptureRecord& record) {
+        switch (rng() % 4) {
+        case 0:
+            record.data[rng() % record.size] ^= static_cast<uint8_t>(1U << (rng() % 8));
+            break;
+        case 1:
+            record.size = static_cast<uint8_t>(1 + rng() % record.size);
+            break;
+        case 2: {
+            const size_t extra = std::min<size_t>(1 + rng() % 16, RX_CAPTURE_MAX_FRAME - record.size);
+            for (size_t i = 0; i < extra; i++) {
+                record.data[record.size + i] = static_cast<uint8_t>(rng());
+            }
+            record.size = static_cast<uint8_t>(record.size + extra);
+            break;
+        }
+        default:
+            // Garbage frame type, including the typed range
+            record.data[std::min<size_t>(framePrefixSize(record.data, record.size), record.size - 1U)] =
+                static_cast<uint8_t>(rng());
+            break;
+        }
+    }
+
+    const Options& options;
+    const FrameEncoder<0> unlicensedEncoder{};
+    const FrameEncoder<CALLSIGN_CHAR_COUNT> licensedEncoder{callsign};
+    std::mt19937 rng;
+    Tracker trackers[MAX_NODE_ID + 1]{};
+    uint8_t lastFrame[RX_CAPTURE_MAX_FRAME]{};
+    size_t lastSize{0};
+    uint8_t lastNode{0};
+};
+
+bool dumpCapture(const std::string& path, const std::vector<RxCaptureRecord>& records) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return false;
+    }
+
+    char line[RX_CAPTURE_LINE_SIZE];
+    for (const RxCaptureRecord& record : records) {
+        formatRxCapture(line, record);
+        fprintf(file, "%s\n", line);
+    }
+
+    fclose(file);
+    return true;
+}
+
+uint64_t percentile(const std::vector<uint32_t>& sorted, const double fraction) {
+    const size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<RxCaptureRecord> records;
+    if (options.synthetic) {
+        SyntheticTraffic(options).generate(records);
+    } else {
+        for (const std::string& path : options.captures) {
+            if (!loadCapture(path, records)) {
+                return 1;
+            }
+        }
+    }
+
+    if (records.empty()) {
+        fprintf(stderr, "No frames to replay\n");
+        return 1;
+    }
+
+    if (!options.dump.empty() && !dumpCapture(options.dump, records)) {
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    CountingSink sink;
+    FrameDecoder decoder(sink);
+
+    // Throughput pass: nothing but decoding inside the timed loop
+    const Clock::time_point start = Clock::now();
+    for (uint32_t pass = 0; pass < options.repeat; pass++) {
+        decoder.reset();
+        for (const RxCaptureRecord& record : records) {
+            decoder.decode(record.data, record.size, record.rssi, record.snr,
+                           static_cast<uint32_t>(record.arrivalUs / 1000));
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const uint64_t decoded = static_cast<uint64_t>(records.size()) * options.repeat;
+
+    // Latency pass: every frame timed on its own, from a fresh node table
+    std::vector<uint32_t> latencyNs;
+    latencyNs.reserve(records.size());
+    CountingSink latencySink;
+    PositionPredictor predictor;
+    latencySink.predictor = &predictor;
+    FrameDecoder latencyDecoder(latencySink);
+    for (const RxCaptureRecord& record : records) {
+        latencySink.nowMs = static_cast<uint32_t>(record.arrivalUs / 1000);
+        const Clock::time_point frameStart = Clock::now();
+        latencyDecoder.decode(record.data, record.size, record.rssi, record.snr, latencySink.nowMs);
+        latencyNs.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frameStart).count()));
+    }
+    std::sort(latencyNs.begin(), latencyNs.end());
+
+    printf("Frames:      %" PRIu64 " (%zu x %u)\n", decoded, records.size(), options.repeat);
+    printf("Throughput:  %.0f frames/s\n", static_cast<double>(decoded) / seconds);
+    printf("Latency:     p50 %" PRIu64 " ns, p99 %" PRIu64 " ns, max %u ns\n", percentile(latencyNs, 0.50),
+           percentile(latencyNs, 0.99), latencyNs.back());
+    printf("Decoded:     %" PRIu64 " fixes, %" PRIu64 " batch fixes, %" PRIu64 " no fix, %" PRIu64 " relayed, %" PRIu64
+           " commands, %" PRIu64 " beacons\n",
+           latencySink.fixes, latencySink.batchFixes, latencySink.noFixes, latencySink.relayed, latencySink.commands,
+           latencySink.beacons);
+    printf("Rejected:    %" PRIu64 " unknown, %" PRIu64 " malformed, %" PRIu64 " outlier fixes, %" PRIu64
+           " invalid positions\n",
+           latencySink.unknown, latencySink.malformed, latencySink.outliers, latencySink.invalid);
+
+    printf("\nNode  Frames  Dups  RSSI  SNR  Last fix                 Predicted +/- m\n");
+    const NodeTable& nodes = latencyDecoder.nodeTable();
+    for (uint8_t id = 0; id <= MAX_NODE_ID; id++) {
+        const NodeTable::Node& node = nodes.node(id);
+        if (node.frames == 0) {
+            continue;
+        }
+        printf("%4u  %6u  %4u  %4d  %3d", id, node.frames, node.duplicates, node.lastRssi, node.lastSnr);
+        if (node.hasFix) {
+            printf("  %.6f, %.6f", node.lastFix.latitude / 1000.0, node.lastFix.longitude / 1000.0);
+        }
+        PositionPredictor::Prediction prediction{};
+        if (predictor.predict(id, latencySink.nowMs, prediction)) {
+            printf("  %5u", prediction.uncertaintyM);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2026 Aaron Chan
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Converts event trace dumps from a tracker or hunter log into a timeline. The default output is
+ * Chrome trace event JSON, which chrome://tracing and ui.perfetto.dev open, with one track each
+ * for the TDMA clock, the radio, the tracker's scheduling and GNSS. Transmissions show as slices
+ * from handing the frame to the modem to the radio done edge. --text prints the same events as
+ * a plain list with the time since the previous one.
+ */
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "core/EventTrace.h"
+
+namespace {
+struct Options {
+    std::string log;
+    std::string output;
+    bool text{false};
+};
+
+struct Dump {
+    TraceHeader header{};
+    std::vector<TraceEntry> entries;
+};
+
+enum Track : int {
+    CLOCK_TRACK = 1,
+    RADIO_TRACK,
+    TRACKER_TRACK,
+    GNSS_TRACK,
+};
+
+constexpr const char* TRACK_NAMES[] = {"", "TDMA clock", "Radio", "Tracker", "GNSS"};
+
+// Mirrors TdmaClock::Source, the tracker's StateMachine::State and Zephyr's gnss_fix_status
+constexpr const char* SOURCE_NAMES[] = {"freerun", "hunter", "gps pps"};
+constexpr const char* STATE_NAMES[] = {"transmitter", "receiver"};
+constexpr const char* FIX_NAMES[] = {"no fix", "fix", "dgnss fix", "estimated fix"};
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [options] <log>\n"
+            "\n"
+            "  -o PATH          Write the timeline to PATH (default stdout)\n"
+            "  --text           Print a plain event list instead of trace event JSON\n",
+            name);
+}
+
+bool parseOptions(const int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-o" && hasValue) {
+            options.output = argv[++i];
+        } else if (arg == "--text") {
+            options.text = true;
+        } else if (!arg.empty() && arg[0] != '-' && options.log.empty()) {
+            options.log = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.log.empty();
+}
+
+bool loadDumps(const std::string& path, std::vector<Dump>& dumps) {
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    size_t skipped = 0;
+    while (std::getline(in, line)) {
+        // Terminal loggers may put their own timestamp in front
+        const char* start = strstr(line.c_str(), EVENT_TRACE_PREFIX);
+        if (!start) {
+            continue;
+        }
+
+        TraceHeader header{};
+        if (parseTraceHeader(start, header)) {
+            dumps.push_back(Dump{header, {}});
+            continue;
+        }
+
+        TraceEntry entries[EVENT_TRACE_LINE_ENTRIES];
+        const size_t count = parseTraceEntries(start, entries);
+        if (count == 0 || dumps.empty()) {
+            skipped++;
+            continue;
+        }
+        dumps.back().entries.insert(dumps.back().entries.end(), entries, entries + count);
+    }
+
+    if (skipped > 0) {
+        fprintf(stderr, "%s: skipped %zu malformed trace lines\n", path.c_str(), skipped);
+    }
+    for (size_t i = 0; i < dumps.size(); i++) {
+        if (dumps[i].entries.size() != dumps[i].header.entries) {
+            fprintf(stderr, "Dump %zu: header says %" PRIu32 " events, found %zu, the log may be cut short\n", i + 1,
+                    dumps[i].header.entries, dumps[i].entries.size());
+        }
+    }
+    return true;
+}
+
+/**
+ * Time of each entry from the first one, unwrapping the 32 bit cycle counter
+ */
+std::vector<double> entryTimesUs(const Dump& dump) {
+    std::vector<double> times;
+    times.reserve(dump.entries.size());
+
+    uint64_t elapsed = 0;
+    for (size_t i = 0; i < dump.entries.size(); i++) {
+        if (i > 0) {
+            elapsed += static_cast<uint32_t>(dump.entries[i].cycles - dump.entries[i - 1].cycles);
+        }
+        times.push_back(static_cast<double>(elapsed) * 1e6 / dump.header.cycleHz);
+    }
+    return times;
+}
+
+Track trackOf(const TraceEvent event) {
+    switch (event) {
+    case TraceEvent::PPS:
+    case TraceEvent::CLOCK_SOURCE:
+    case TraceEvent::FRAME:
+        return CLOCK_TRACK;
+    case TraceEvent::TX_TIMER:
+    case TraceEvent::TX_WORK:
+    case TraceEvent::STATE:
+        return TRACKER_TRACK;
+    case TraceEvent::GNSS:
+        return GNSS_TRACK;
+    default:
+        return RADIO_TRACK;
+    }
+}
+
+const char* lookup(const char* const* names, const size_t count, const uint16_t value) {
+    return value < count ? names[value] : "unknown";
+}
+
+/**
+ * Readable meaning of an entry's argument
+ */
+std::string describeArg(const TraceEntry& entry) {
+    char text[48];
+    switch (entry.event) {
+    case TraceEvent::PPS:
+    case TraceEvent::RADIO_DONE:
+        snprintf(text, sizeof(text), "edge %u", entry.arg);
+        break;
+    case TraceEvent::CLOCK_SOURCE:
+        snprintf(text, sizeof(text), "%s", lookup(SOURCE_NAMES, std::size(SOURCE_NAMES), entry.arg));
+        break;
+    case TraceEvent::FRAME:
+        snprintf(text, sizeof(text), "frame %u", entry.arg);
+        break;
+    case TraceEvent::TX_START:
+    case TraceEvent::RX:
+        snprintf(text, sizeof(text), "%u bytes", entry.arg);
+        break;
+    case TraceEvent::GNSS:
+        snprintf(text, sizeof(text), "%s", lookup(FIX_NAMES, std::size(FIX_NAMES), entry.arg));
+        break;
+    case TraceEvent::STATE:
+        snprintf(text, sizeof(text), "%s", lookup(STATE_NAMES, std::size(STATE_NAMES), entry.arg));
+        break;
+    default:
+        text[0] = '\0';
+        break;
+    }
+    return text;
+}
+
+void writeText(FILE* out, const std::vector<Dump>& dumps) {
+    for (size_t d = 0; d < dumps.size(); d++) {
+        const Dump& dump = dumps[d];
+        const std::vector<double> times = entryTimesUs(dump);
+        fprintf(out, "Dump %zu: %zu events, %" PRIu32 " overwritten, %" PRIu32 " Hz cycle counter\n", d + 1,
+                dump.entries.size(), dump.header.overwritten, dump.header.cycleHz);
+        fprintf(out, "%14s %12s  %-13s %-3s %s\n", "Time (ms)", "Delta (us)", "Event", "ISR", "Detail");
+
+        for (size_t i = 0; i < dump.entries.size(); i++) {
+            const TraceEntry& entry = dump.entries[i];
+            const double deltaUs = i == 0 ? 0.0 : times[i] - times[i - 1];
+            fprintf(out, "%14.3f %12.1f  %-13s %-3s %s\n", times[i] / 1000.0, deltaUs, traceEventName(entry.event),
+                    (entry.flags & TRACE_FLAG_ISR) ? "isr" : "", describeArg(entry).c_str());
+        }
+        fprintf(out, "\n");
+    }
+}
+
+void writeEvent(FILE* out, bool& first, const char* name, const char* phase, const int pid, const Track track,
+                const double tsUs, const double durUs, const TraceEntry& entry) {
+    fprintf(out, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f", first ? "" : ",",
+            name, (entry.flags & TRACE_FLAG_ISR) ? "isr" : "thread", phase, pid, static_cast<int>(track), tsUs);
+    if (phase[0] == 'X') {
+        fprintf(out, ",\"dur\":%.3f", durUs);
+    } else {
+        fprintf(out, ",\"s\":\"t\"");
+    }
+    fprintf(out, ",\"args\":{\"arg\":%u,\"detail\":\"%s\",\"isr\":%s}}", entry.arg, describeArg(entry).c_str(),
+            (entry.flags & TRACE_FLAG_ISR) ? "true" : "false");
+    first = false;
+}
+
+void writeJson(FILE* out, const std::vector<Dump>& dumps) {
+    bool first = true;
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+    for (size_t d = 0; d < dumps.size(); d++) {
+        const Dump& dump = dumps[d];
+        const int pid = static_cast<int>(d + 1);
+        fprintf(out, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Dump %d\"}}",
+                first ? "" : ",", pid, pid);
+        first = false;
+        for (int track = CLOCK_TRACK; track <= GNSS_TRACK; track++) {
+            fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    pid, track, TRACK_NAMES[track]);
+        }
+
+        const std::vector<double> times = entryTimesUs(dump);
+        // A transmission runs from TX start to the next radio done edge, or TX done without one
+        ptrdiff_t txStart = -1;
+        for (size_t i = 0; i < dump.entries.size(); i++) {
+            const TraceEntry& entry = dump.entries[i];
+            const bool txEnd = entry.event == TraceEvent::RADIO_DONE || entry.event == TraceEvent::TX_DONE;
+            if (txStart >= 0 && (txEnd || entry.event == TraceEvent::TX_START)) {
+                const TraceEntry& start = dump.entries[txStart];
+                if (txEnd) {
+                    writeEvent(out, first, "tx", "X", pid, RADIO_TRACK, times[txStart], times[i] - times[txStart],
+                               start);
+                } else {
+                    writeEvent(out, first, traceEventName(start.event), "i", pid, RADIO_TRACK, times[txStart], 0,
+                               start);
+                }
+                txStart = -1;
+            }
+
+            if (entry.event == TraceEvent::TX_START) {
+                txStart = static_cast<ptrdiff_t>(i);
+                continue;
+            }
+            writeEvent(out, first, traceEventName(entry.event), "i", pid, trackOf(entry.event), times[i], 0, entry);
+        }
+        if (txStart >= 0) {
+            writeEvent(out, first, traceEventName(TraceEvent::TX_START), "i", pid, RADIO_TRACK, times[txStart], 0,
+                       dump.entries[txStart]);
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+}
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Dump> dumps;
+    if (!loadDumps(options.log, dumps)) {
+        return 1;
+    }
+    if (dumps.empty()) {
+        fprintf(stderr, "No trace dumps in %s, print one with the trace dump shell command\n", options.log.c_str());
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = fopen(options.output.c_str(), "w");
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+
+    if (options.text) {
+        writeText(out, dumps);
+    } else {
+        writeJson(out, dumps);
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    size_t events = 0;
+    for (const Dump& dump : dumps) {
+        events += dump.entries.size();
+    }
+    fprintf(stderr, "%zu dumps, %zu events\n", dumps.size(), events);
+    return 0;
+}